@@ -3,13 +3,70 @@
 
 #include "AnimationProgProject.h"
 #include <memory>
-#include "window/Window.h"
-#include "logger/Logger.h"
+#include <string>
+#include <vector>
+#include "Window/Window.h"
+#include "Window/HeadlessContext.h"
+#include "Logger/Logger.h"
+#include "opengl/shaders/Shader.h"
+#include "opengl/textures/Texture.h"
+#include "opengl/MainRenderer/OGLRenderer.h"
 
 using namespace std;
 
 int main(int argc, char *argv[])
 {
+	// "--no-shader-cache" compiles all shaders from source, to compare the startup time
+	// "--no-texture-cache" decodes the images every time and uses them uncompressed
+	// "--model <file>" loads another model, .gltf, the mapped .glb or a cooked .apmodel
+	// "--upload-budget <KB>" limits the model data uploaded per frame while the model is loading
+	// "--keep-source-data" keeps the glTF data in memory after the upload, to compare the resident memory
+	// "--lazy-clips" creates the animation clips on first use and drops unused ones above the clip budget
+	// "--stream-clips <KB>" streams clips with more keyframe data in windows, 0 streams every clip
+	vector<string> args{};
+	for (int i = 1; i < argc; ++i) {
+		if (string(argv[i]) == "--no-shader-cache") {
+			Shader::setCacheDirectory("");
+		}
+		else if (string(argv[i]) == "--no-texture-cache") {
+			Texture::setCompressedCache(false);
+		}
+		else if (string(argv[i]) == "--model" && i + 1 < argc) {
+			OGLRenderer::setModelFileName(argv[++i]);
+		}
+		else if (string(argv[i]) == "--upload-budget" && i + 1 < argc) {
+			OGLRenderer::setUploadBudget(stoi(argv[++i]));
+		}
+		else if (string(argv[i]) == "--keep-source-data") {
+			OGLRenderer::setResidentMinimal(false);
+		}
+		else if (string(argv[i]) == "--lazy-clips") {
+			OGLRenderer::setLazyClips(true);
+		}
+		else if (string(argv[i]) == "--stream-clips" && i + 1 < argc) {
+			OGLRenderer::setStreamClipThreshold(stoi(argv[++i]));
+		}
+		else {
+			args.push_back(argv[i]);
+		}
+	}
+
+	// Headless mode: AnimationProgProject --headless [frames] [screenshot.png]
+	if (!args.empty() && args.at(0) == "--headless") {
+		unsigned int frameCount = (args.size() > 1) ? static_cast<unsigned int>(stoul(args.at(1))) : 600;
+		string screenshotFileName = (args.size() > 2) ? args.at(2) : "";
+
+		unique_ptr<HeadlessContext> headless = make_unique<HeadlessContext>();
+		if (!headless->init(640, 480)) {
+			Logger::log(0, "%s: Error - Headless init Error.\n", __FUNCTION__);
+			return -1;
+		}
+
+		headless->mainLoop(frameCount, screenshotFileName);
+		headless->cleanup();
+		return 0;
+	}
+
 	unique_ptr<Window> w = make_unique<Window>();
 
 	// Try to initialize window.
@@ -8,9 +8,10 @@ layout (location = 1) out vec2 texCoord;
 
 
 // std140 keyword used for mem layout inside shader and binding for index incase of multiple uniform buffers
-layout (std140, binding = 0) uniform Matrices {
+layout (std140, binding = 0) uniform FrameConstants {
     mat4 view;
     mat4 projection;
+    vec4 frameTime;
 };
 
 
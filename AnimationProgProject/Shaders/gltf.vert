@@ -6,9 +6,10 @@ layout (location = 2) in vec2 aTexCoord;
 layout (location = 0) out vec3 normal;
 layout (location = 1) out vec2 texCoord;
 
-layout (std140, binding = 0) uniform Matrices {
+layout (std140, binding = 0) uniform FrameConstants {
  mat4 view;
  mat4 projection;
+ vec4 frameTime;
 };
 
 void main() {
@@ -0,0 +1,82 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNormal; // octahedral, snorm16
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aJointNum;
+layout (location = 4) in vec4 aJointWeight;
+
+layout (location = 0) out vec3 normal;
+layout (location = 1) out vec2 texCoord;
+
+layout (std140, binding = 0) uniform FrameConstants {
+ mat4 view;
+ mat4 projection;
+ vec4 frameTime;
+};
+
+// joint matrices of all baked clips, frame after frame
+layout (binding = 2) uniform samplerBuffer BakedMatrices;
+
+// per instance: x/z position, y rotation (radians), clip | start time, speed
+layout (std430, binding = 6) readonly buffer CrowdInstances {
+ vec4 instances[];
+};
+
+// per clip: first frame, frame count, duration
+layout (std430, binding = 7) readonly buffer CrowdClips {
+ vec4 clips[];
+};
+
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
+
+vec3 octDecode(vec2 oct) {
+ vec3 n = vec3(oct.xy, 1.0 - abs(oct.x) - abs(oct.y));
+ if (n.z < 0.0) {
+  n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+ }
+ return normalize(n);
+}
+
+mat4 getMatrix(int offset) {
+ return mat4(texelFetch(BakedMatrices, offset),
+ texelFetch(BakedMatrices, offset + 1),
+ texelFetch(BakedMatrices, offset + 2),
+ texelFetch(BakedMatrices, offset + 3));
+}
+
+mat4 getSkinMatrix(int frame) {
+ int frameOffset = frame * palette.x;
+ return aJointWeight.x * getMatrix((int(aJointNum.x) + frameOffset) * 4) +
+ aJointWeight.y * getMatrix((int(aJointNum.y) + frameOffset) * 4) +
+ aJointWeight.z * getMatrix((int(aJointNum.z) + frameOffset) * 4) +
+ aJointWeight.w * getMatrix((int(aJointNum.w) + frameOffset) * 4);
+}
+
+void main() {
+ vec4 placement = instances[gl_InstanceID * 2];
+ vec4 playback = instances[gl_InstanceID * 2 + 1];
+ vec4 clip = clips[int(placement.w)];
+
+ // local clip time, then interpolate between the two nearest baked frames
+ float clipTime = mod(playback.x + clipInfo.x * playback.y, clip.z);
+ float framePos = clipTime * clipInfo.y;
+ int frame = min(int(framePos), int(clip.y) - 1);
+ int nextFrame = min(frame + 1, int(clip.y) - 1);
+ float frameBlend = fract(framePos);
+ mat4 skinMat = getSkinMatrix(int(clip.x) + frame) * (1.0 - frameBlend) +
+ getSkinMatrix(int(clip.x) + nextFrame) * frameBlend;
+
+ float s = sin(placement.z);
+ float c = cos(placement.z);
+ mat4 worldMat = mat4(vec4(c, 0.0, -s, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(s, 0.0, c, 0.0),
+ vec4(placement.x, 0.0, placement.y, 1.0));
+
+ gl_Position = projection * view * world * worldMat * skinMat * vec4(aPos, 1.0);
+ normal = mat3(world * worldMat) * octDecode(aNormal);
+ texCoord = aTexCoord;
+}
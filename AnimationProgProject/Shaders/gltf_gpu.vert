@@ -8,14 +8,20 @@ layout (location = 4) in vec4 aJointWeight;
 layout (location = 0) out vec3 normal;
 layout (location = 1) out vec2 texCoord;
 
-layout (std140, binding = 0) uniform Matrices {
+layout (std140, binding = 0) uniform FrameConstants {
  mat4 view;
  mat4 projection;
+ vec4 frameTime;
 };
 
 layout (binding = 1) uniform samplerBuffer JointMatrices;
 
-uniform int aModelStride;
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
 
 mat4 getMatrix(int offset) {
  return mat4(texelFetch(JointMatrices, offset),
@@ -25,12 +31,12 @@ mat4 getMatrix(int offset) {
 }
 
 void main() {
-mat4 skinMat = aJointWeight.x * getMatrix((int(aJointNum.x) + gl_InstanceID * aModelStride) * 4) +
- aJointWeight.y * getMatrix((int(aJointNum.y) + gl_InstanceID * aModelStride) * 4) +
- aJointWeight.z * getMatrix((int(aJointNum.z) + gl_InstanceID * aModelStride) * 4) +
- aJointWeight.w * getMatrix((int(aJointNum.w) + gl_InstanceID * aModelStride) * 4);
+mat4 skinMat = aJointWeight.x * getMatrix((int(aJointNum.x) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.y * getMatrix((int(aJointNum.y) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.z * getMatrix((int(aJointNum.z) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.w * getMatrix((int(aJointNum.w) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4);
 
- gl_Position = projection * view * skinMat * vec4(aPos, 1.0);
+ gl_Position = projection * view * world * skinMat * vec4(aPos, 1.0);
  normal = aNormal;
  texCoord = aTexCoord;
 }
\ No newline at end of file
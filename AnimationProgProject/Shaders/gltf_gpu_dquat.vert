@@ -8,23 +8,29 @@ layout (location = 4) in vec4 aJointWeight;
 layout (location = 0) out vec3 normal;
 layout (location = 1) out vec2 texCoord;
 
-layout (std140, binding = 0) uniform Matrices {
+layout (std140, binding = 0) uniform FrameConstants {
   mat4 view;
   mat4 projection;
+  vec4 frameTime;
 };
 
 layout (std430, binding = 2) readonly buffer JointDualQuats {
   mat2x4 jointDQs[];
 };
 
-uniform int aModelStride;
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
 
 mat2x4 getJointTransform(ivec4 joints, vec4 weights) {
   // read dual quaterions from buffer
-  mat2x4 dq0 = jointDQs[joints.x + gl_InstanceID * aModelStride];
-  mat2x4 dq1 = jointDQs[joints.y + gl_InstanceID * aModelStride];
-  mat2x4 dq2 = jointDQs[joints.z + gl_InstanceID * aModelStride];
-  mat2x4 dq3 = jointDQs[joints.w + gl_InstanceID * aModelStride];
+  mat2x4 dq0 = jointDQs[joints.x + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x];
+  mat2x4 dq1 = jointDQs[joints.y + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x];
+  mat2x4 dq2 = jointDQs[joints.z + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x];
+  mat2x4 dq3 = jointDQs[joints.w + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x];
 
   // shortest rotation
   weights.y *= sign(dot(dq0[0], dq1[0]));
@@ -73,7 +79,7 @@ mat4 skinMat() {
 
 
 void main() {
-  gl_Position = projection * view * skinMat() * vec4(aPos, 1.0);
+  gl_Position = projection * view * world * skinMat() * vec4(aPos, 1.0);
   normal = aNormal;
   texCoord = aTexCoord;
 }
@@ -0,0 +1,50 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNormal; // octahedral, snorm16
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 aJointNum;
+layout (location = 4) in vec4 aJointWeight;
+
+layout (location = 0) out vec3 normal;
+layout (location = 1) out vec2 texCoord;
+
+layout (std140, binding = 0) uniform FrameConstants {
+ mat4 view;
+ mat4 projection;
+ vec4 frameTime;
+};
+
+layout (binding = 1) uniform samplerBuffer JointMatrices;
+
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
+
+vec3 octDecode(vec2 oct) {
+ vec3 n = vec3(oct.xy, 1.0 - abs(oct.x) - abs(oct.y));
+ if (n.z < 0.0) {
+  n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+ }
+ return normalize(n);
+}
+
+mat4 getMatrix(int offset) {
+ return mat4(texelFetch(JointMatrices, offset),
+ texelFetch(JointMatrices, offset + 1),
+ texelFetch(JointMatrices, offset + 2),
+ texelFetch(JointMatrices, offset + 3));
+}
+
+void main() {
+mat4 skinMat = aJointWeight.x * getMatrix((int(aJointNum.x) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.y * getMatrix((int(aJointNum.y) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.z * getMatrix((int(aJointNum.z) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4) +
+ aJointWeight.w * getMatrix((int(aJointNum.w) + (palette.y + gl_BaseInstance + gl_InstanceID) * palette.x) * 4);
+
+ gl_Position = projection * view * world * skinMat * vec4(aPos, 1.0);
+ normal = octDecode(aNormal);
+ texCoord = aTexCoord;
+}
\ No newline at end of file
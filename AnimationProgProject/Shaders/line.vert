@@ -5,9 +5,10 @@ layout (location = 2) in vec2 aTexCoord; // ignored
 
 layout (location = 0) out vec4 lineColor;
 
-layout (std140, binding = 0) uniform Matrices {
+layout (std140, binding = 0) uniform FrameConstants {
     mat4 view;
     mat4 projection;
+    vec4 frameTime;
 };
 
 void main() {
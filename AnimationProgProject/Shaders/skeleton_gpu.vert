@@ -0,0 +1,52 @@
+#version 460 core
+layout (location = 0) out vec4 lineColor;
+
+layout (std140, binding = 0) uniform FrameConstants {
+ mat4 view;
+ mat4 projection;
+ vec4 frameTime;
+};
+
+layout (binding = 1) uniform samplerBuffer JointMatrices;
+
+// parent and child joint of every bone, static per model
+layout (std430, binding = 3) readonly buffer SkeletonBones {
+ ivec2 bones[];
+};
+
+// joint origin in bind pose (inverse of the inverse bind matrix)
+layout (std430, binding = 4) readonly buffer SkeletonBindPositions {
+ vec4 bindPositions[];
+};
+
+// palette slot of every instance with skeleton drawing enabled
+layout (std430, binding = 5) readonly buffer SkeletonInstances {
+ int paletteInstances[];
+};
+
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
+
+mat4 getMatrix(int offset) {
+ return mat4(texelFetch(JointMatrices, offset),
+ texelFetch(JointMatrices, offset + 1),
+ texelFetch(JointMatrices, offset + 2),
+ texelFetch(JointMatrices, offset + 3));
+}
+
+void main() {
+ // two vertices per bone, first the parent, then the child joint
+ ivec2 bone = bones[gl_VertexID / 2];
+ bool isChild = (gl_VertexID % 2) == 1;
+ int joint = isChild ? bone.y : bone.x;
+
+ int paletteOffset = (palette.y + paletteInstances[gl_InstanceID]) * palette.x;
+ vec4 worldPos = getMatrix((joint + paletteOffset) * 4) * bindPositions[joint];
+
+ gl_Position = projection * view * world * vec4(worldPos.xyz, 1.0);
+ lineColor = isChild ? vec4(0.0, 0.0, 1.0, 1.0) : vec4(0.0, 1.0, 1.0, 1.0);
+}
@@ -0,0 +1,74 @@
+#version 460 core
+layout (location = 0) out vec4 lineColor;
+
+layout (std140, binding = 0) uniform FrameConstants {
+  mat4 view;
+  mat4 projection;
+  vec4 frameTime;
+};
+
+layout (std430, binding = 2) readonly buffer JointDualQuats {
+  mat2x4 jointDQs[];
+};
+
+// parent and child joint of every bone, static per model
+layout (std430, binding = 3) readonly buffer SkeletonBones {
+  ivec2 bones[];
+};
+
+// joint origin in bind pose (inverse of the inverse bind matrix)
+layout (std430, binding = 4) readonly buffer SkeletonBindPositions {
+  vec4 bindPositions[];
+};
+
+// palette slot of every instance with skeleton drawing enabled
+layout (std430, binding = 5) readonly buffer SkeletonInstances {
+  int paletteInstances[];
+};
+
+// per draw: world transform, palette stride and first slot, crowd time and baked frame rate
+layout (std140, binding = 8) uniform DrawConstants {
+ mat4 world;
+ ivec4 palette;
+ vec4 clipInfo;
+};
+
+// same conversion as in gltf_gpu_dquat.vert, without blending
+mat4 dualQuatToMat(mat2x4 bone) {
+  vec4 r = bone[0]; // rotation
+  vec4 t = bone[1]; // translation
+
+  return mat4(
+      1.0 - (2.0 * r.y * r.y) - (2.0 * r.z * r.z),
+            (2.0 * r.x * r.y) + (2.0 * r.w * r.z),
+            (2.0 * r.x * r.z) - (2.0 * r.w * r.y),
+      0.0,
+
+            (2.0 * r.x * r.y) - (2.0 * r.w * r.z),
+      1.0 - (2.0 * r.x * r.x) - (2.0 * r.z * r.z),
+            (2.0 * r.y * r.z) + (2.0 * r.w * r.x),
+      0.0,
+
+            (2.0 * r.x * r.z) + (2.0 * r.w * r.y),
+            (2.0 * r.y * r.z) - (2.0 * r.w * r.x),
+      1.0 - (2.0 * r.x * r.x) - (2.0 * r.y * r.y),
+      0.0,
+
+      2.0 * (-t.w * r.x + t.x * r.w - t.y * r.z + t.z * r.y),
+      2.0 * (-t.w * r.y + t.x * r.z + t.y * r.w - t.z * r.x),
+      2.0 * (-t.w * r.z - t.x * r.y + t.y * r.x + t.z * r.w),
+      1);
+}
+
+void main() {
+  // two vertices per bone, first the parent, then the child joint
+  ivec2 bone = bones[gl_VertexID / 2];
+  bool isChild = (gl_VertexID % 2) == 1;
+  int joint = isChild ? bone.y : bone.x;
+
+  int paletteOffset = (palette.y + paletteInstances[gl_InstanceID]) * palette.x;
+  vec4 worldPos = dualQuatToMat(jointDQs[joint + paletteOffset]) * bindPositions[joint];
+
+  gl_Position = projection * view * world * vec4(worldPos.xyz, 1.0);
+  lineColor = isChild ? vec4(0.0, 0.0, 1.0, 1.0) : vec4(0.0, 1.0, 1.0, 1.0);
+}
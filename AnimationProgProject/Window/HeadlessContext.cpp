@@ -0,0 +1,179 @@
+#include "HeadlessContext.h"
+#include "../Logger/Logger.h"
+#include "../timer/Timer.h"
+
+#include <algorithm>
+
+#ifdef ANIMPROG_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+bool HeadlessContext::init(unsigned int width, unsigned int height) {
+
+#ifdef ANIMPROG_HEADLESS
+	// Prefer the surfaceless Mesa platform, it needs neither X11 nor Wayland
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		Logger::log(0, "%s: Error - Could not init EGL display.\n", __FUNCTION__);
+		return false;
+	}
+	mDisplay = display;
+	Logger::log(1, "%s: EGL %i.%i initialized\n", __FUNCTION__, major, minor);
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		Logger::log(0, "%s: Error - EGL does not support desktop OpenGL.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+		Logger::log(0, "%s: Error - No EGL config with pbuffer and OpenGL support.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+
+	const EGLint surfaceAttribs[] = {
+		EGL_WIDTH, static_cast<EGLint>(width),
+		EGL_HEIGHT, static_cast<EGLint>(height),
+		EGL_NONE
+	};
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+	if (surface == EGL_NO_SURFACE) {
+		Logger::log(0, "%s: Error - Could not create pbuffer surface.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+	mSurface = surface;
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 6,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT) {
+		Logger::log(0, "%s: Error - Could not create OpenGL 4.6 core context.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+	mContext = context;
+
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		Logger::log(0, "%s: Error - Could not make context current.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+
+	// No window: the renderer loads the GL functions via EGL and skips UI and input
+	mRenderer = std::make_unique<OGLRenderer>(nullptr);
+	if (!mRenderer->init(width, height, (GLADloadproc)eglGetProcAddress)) {
+		Logger::log(0, "%s: Error - Could not init Renderer.\n", __FUNCTION__);
+		cleanup();
+		return false;
+	}
+
+	mModel = std::make_unique<Model>();
+	mModel->init();
+
+	Logger::log(1, "%s: Headless context was successfully initialized.\n", __FUNCTION__);
+	return true;
+#else
+	Logger::log(0, "%s: Error - Built without headless support, configure with -DANIMPROG_HEADLESS=ON.\n", __FUNCTION__);
+	return false;
+#endif
+}
+
+void HeadlessContext::mainLoop(unsigned int frameCount, std::string screenshotFileName) {
+
+	if (!mRenderer) {
+		Logger::log(0, "%s: Error - No context initialized. try calling the init method first.\n", __FUNCTION__);
+		return;
+	}
+
+	mRenderer->uploadData(mModel->getVertexData());
+
+	// the model is loaded in the background, frames before it is drawn would distort the timings
+	while (mRenderer->isModelLoading()) {
+		mRenderer->draw();
+	}
+
+	Logger::log(1, "%s: Rendering %u frames...\n", __FUNCTION__, frameCount);
+
+	Timer frameTimer{};
+	float totalTime = 0.0f;
+	float minTime = 0.0f;
+	float maxTime = 0.0f;
+
+	for (unsigned int i = 0; i < frameCount; ++i) {
+		frameTimer.start();
+		mRenderer->draw();
+		// wait for the GPU, otherwise only the command submission is measured
+		glFinish();
+		float frameTime = frameTimer.stop();
+
+		totalTime += frameTime;
+		minTime = (i == 0) ? frameTime : std::min(minTime, frameTime);
+		maxTime = std::max(maxTime, frameTime);
+	}
+
+	if (frameCount > 0) {
+		Logger::log(0, "%s: %u frames, avg %.3f ms, min %.3f ms, max %.3f ms\n", __FUNCTION__, frameCount,
+			totalTime / frameCount, minTime, maxTime);
+	}
+
+	if (!screenshotFileName.empty() && !mRenderer->saveFrame(screenshotFileName)) {
+		Logger::log(0, "%s: Error - Could not save frame to '%s'.\n", __FUNCTION__, screenshotFileName.c_str());
+	}
+}
+
+void HeadlessContext::cleanup() {
+
+	if (mRenderer) {
+		mRenderer->cleanup();
+		mRenderer.reset();
+	}
+
+#ifdef ANIMPROG_HEADLESS
+	if (mDisplay) {
+		eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (mContext) {
+			eglDestroyContext(mDisplay, mContext);
+		}
+		if (mSurface) {
+			eglDestroySurface(mDisplay, mSurface);
+		}
+		eglTerminate(mDisplay);
+	}
+#endif
+
+	mContext = nullptr;
+	mSurface = nullptr;
+	mDisplay = nullptr;
+
+	Logger::log(1, "%s: Headless context terminated.\n", __FUNCTION__);
+}
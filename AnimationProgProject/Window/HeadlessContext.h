@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include "./MainRenderer/OGLRenderer.h"
+#include "../models/Model.h"
+
+// OpenGL 4.6 context without a window, created with an EGL pbuffer (Mesa llvmpipe works too).
+// Only available if built with ANIMPROG_HEADLESS, used for automated performance runs.
+class HeadlessContext {
+	public:
+		// Creates the EGL context and the renderer
+		// @param width - Width of the offscreen surface
+		// @param height - Height of the offscreen surface
+		bool init(unsigned int width, unsigned int height);
+
+		// Renders a fixed number of frames and logs the frame times
+		// @param frameCount - Number of frames to render
+		// @param screenshotFileName - PNG file for the last frame, empty to skip
+		void mainLoop(unsigned int frameCount, std::string screenshotFileName);
+
+		// Destroys renderer and context
+		void cleanup();
+
+	private:
+		// EGL handles, kept as void pointers to avoid the EGL headers here
+		void* mDisplay = nullptr;
+		void* mSurface = nullptr;
+		void* mContext = nullptr;
+
+		std::unique_ptr<OGLRenderer> mRenderer;
+		std::unique_ptr<Model> mModel;
+};
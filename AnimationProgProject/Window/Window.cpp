@@ -10,18 +10,13 @@ bool Window::init(unsigned int width, unsigned int height, std::string title) {
 		return false;
 	}
 
-	// If no vulkan support
-	if (!glfwVulkanSupported()) {
-		glfwTerminate();
-		Logger::log(0, "%s: Error - Vulkan is not supported.\n", __FUNCTION__);
-		return false;
-	}
-
 	// Setting properties or "Hints" for the next window to be created.
 	// glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+	// The scene may be drawn straight into the window, it needs its own depth buffer
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
 
 	
 	mApplicationName = title;
@@ -4,7 +4,7 @@
 // Note : Vulkan include has to be before GLFW so that GLFW can detect Vulkan
 
 #include <memory>
-#include "./mainRenderer/OGLRenderer.h"
+#include "./MainRenderer/OGLRenderer.h"
 #include "../models/Model.h"
 //#include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
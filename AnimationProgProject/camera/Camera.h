@@ -1,6 +1,6 @@
 #pragma once
 #include <glm/glm.hpp>
-#include "./../opengl/mainRenderer/OGLRenderData.h"
+#include "../opengl/MainRenderer/OGLRenderData.h"
 
 class Camera {
 public:
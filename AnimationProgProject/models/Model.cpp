@@ -1,5 +1,5 @@
 #include "Model.h"
-#include "./../logger/Logger.h"
+#include "../Logger/Logger.h"
 
 OGLMesh Model::getVertexData() {
     if (mVertexData.vertices.size() == 0) {
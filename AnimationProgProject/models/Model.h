@@ -1,7 +1,7 @@
 #pragma once
 #include <vector>
 #include <glm/glm.hpp>
-#include "./mainRenderer/OGLRenderData.h"
+#include "./MainRenderer/OGLRenderData.h"
 
 class Model {
 public:
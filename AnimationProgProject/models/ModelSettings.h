@@ -1,8 +1,17 @@
 #pragma once
 #include <glm/glm.hpp>
-#include <mainRenderer/OGLRenderData.h>
+#include <MainRenderer/OGLRenderData.h>
 
 
+// One IK chain of an instance, from the effector node up to the root node
+struct IKChainSettings {
+	ikMode mode = ikMode::off;
+	int iterations = 10;
+	glm::vec3 targetPos = glm::vec3(0.0f, 3.0f, 1.0f);
+	int effectorNode = 0;
+	int rootNode = 0;
+	glm::vec3 targetWorldPos = glm::vec3(0.0f, 0.0f, 1.0f);
+};
 
 struct ModelSettings {
 	glm::vec2 msWorldPosition = glm::vec2(0.0f);
@@ -25,12 +34,9 @@ struct ModelSettings {
 	float msAnimCrossBlendFactor = 0.0f;
 	int msSkelSplitNode = 0;
 
-	ikMode msIkMode = ikMode::off;
-	int msIkIterations = 10;
-	glm::vec3 msIkTargetPos = glm::vec3(0.0f, 3.0f, 1.0f);
-	int msIkEffectorNode = 0;
-	int msIkRootNode = 0;
-	glm::vec3 msIkTargetWorldPos = glm::vec3(0.0f, 0.0f, 01.0f);
+	// Every chain has its own mode and target, the UI edits the selected one
+	std::vector<IKChainSettings> msIkChains{};
+	int msIkSelectedChain = 0;
 
 	std::vector<std::string> msClipNames{};
 	std::vector<std::string> msSkelNodeNames{};
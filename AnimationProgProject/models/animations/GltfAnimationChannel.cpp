@@ -1,22 +1,16 @@
 #include "GltfAnimationChannel.h"
 
-void GltfAnimationChannel::loadChannelData(std::shared_ptr<tinygltf::Model> model, tinygltf::Animation anim, tinygltf::AnimationChannel channel)
+void GltfAnimationChannel::loadChannelData(const tinygltf::Model& model, const std::shared_ptr<GltfBufferData>& bufferData,
+	const tinygltf::Animation& anim, const tinygltf::AnimationChannel& channel)
 {
 	mTargetNode = channel.target_node;
 
-	// Get Accesser for input sampler from animation object, index stored in channel object
-	const tinygltf::Accessor& inputAccessor = model->accessors.at(anim.samplers.at(channel.sampler).input);
-	const tinygltf::BufferView& inputBufferView = model->bufferViews.at(inputAccessor.bufferView);
-	const tinygltf::Buffer& inputBuffer = model->buffers.at(inputBufferView.buffer);
-
-	// Get timings
-	std::vector<float> timings;
-	timings.resize(inputAccessor.count);
-	std::memcpy(timings.data(), &inputBuffer.data.at(0) + inputBufferView.byteOffset, inputBufferView.byteLength);
-	setTimings(timings);
-
 	// Get sampler object
-	const tinygltf::AnimationSampler sampler = anim.samplers.at(channel.sampler);
+	const tinygltf::AnimationSampler& sampler = anim.samplers.at(channel.sampler);
+
+	// Timings from the input accessor of the sampler, used in place if they are stored as plain floats
+	GltfAccessorView<float> timings(model, *bufferData, sampler.input);
+	setKeyframes(timings, bufferData, mTimings, mTimingStorage);
 
 	// Get interpolation type from sampler 
 	if (sampler.interpolation.compare("STEP") == 0) 
@@ -33,53 +27,118 @@ void GltfAnimationChannel::loadChannelData(std::shared_ptr<tinygltf::Model> mode
 	}
 
 
-	// Get Accesser for oupput sampler from animation object, index stored in channel object
-	const tinygltf::Accessor& outputAccessor = model->accessors.at(anim.samplers.at(channel.sampler).output);
-	const tinygltf::BufferView& outputBufferView = model->bufferViews.at(outputAccessor.bufferView);
-	const tinygltf::Buffer& outputBuffer = model->buffers.at(outputBufferView.buffer);
-
-	// Get target type
+	// Values from the output accessor, normalized integer rotations are converted to float
+	int outputAccessor = sampler.output;
 	if (channel.target_path.compare("rotation") == 0) 
 	{
 		mTargetPath = ETargetPath::ROTATION;
-		std::vector<glm::quat> rotations;
-		rotations.resize(outputAccessor.count);
-		std::memcpy(rotations.data(), &outputBuffer.data.at(0) + outputBufferView.byteOffset, outputBufferView.byteLength);
-		setRotations(rotations);
+		setKeyframes(GltfAccessorView<glm::quat>(model, *bufferData, outputAccessor), bufferData, mRotations, mRotationStorage);
 	}
 	else if (channel.target_path.compare("translation") == 0)
 	{
 		mTargetPath = ETargetPath::TRANSLATION;
-		std::vector<glm::vec3> translations;
-		translations.resize(outputAccessor.count);
-		std::memcpy(translations.data(), &outputBuffer.data.at(0) + outputBufferView.byteOffset, outputBufferView.byteLength);
-		setTranslations(translations);
+		setKeyframes(GltfAccessorView<glm::vec3>(model, *bufferData, outputAccessor), bufferData, mTranslations, mTranslationStorage);
 	}
 	else
 	{
 		mTargetPath = ETargetPath::SCALE;
-		std::vector<glm::vec3> scales;
-		scales.resize(outputAccessor.count);
-		std::memcpy(scales.data(), &outputBuffer.data.at(0) + outputBufferView.byteOffset, outputBufferView.byteLength);
-		setScalings(scales);
+		setKeyframes(GltfAccessorView<glm::vec3>(model, *bufferData, outputAccessor), bufferData, mScaling, mScalingStorage);
 	}
 
 }
 
-void GltfAnimationChannel::setTimings(std::vector<float> timinings) {
-	mTimings = timinings;
+void GltfAnimationChannel::loadCookedChannelData(const GltfCookedChannel& channel, const float* keys)
+{
+	mTargetNode = channel.targetNode;
+	mTargetPath = static_cast<ETargetPath>(channel.targetPath);
+	mInterType = static_cast<EInterpolationType>(channel.interpolation);
+
+	mTimings.set(keys + channel.timeOffset, channel.keyCount);
+	setValues(keys + channel.valueOffset, channel.valueCount);
 }
 
-void GltfAnimationChannel::setScalings(std::vector<glm::vec3> scalings) {
-	mScaling = scalings;
+void GltfAnimationChannel::setValues(const float* values, size_t valueCount)
+{
+	switch (mTargetPath)
+	{
+	case ETargetPath::ROTATION:
+		mRotations.set(reinterpret_cast<const glm::quat*>(values), valueCount / 4);
+		break;
+	case ETargetPath::TRANSLATION:
+		mTranslations.set(reinterpret_cast<const glm::vec3*>(values), valueCount / 3);
+		break;
+	default:
+		mScaling.set(reinterpret_cast<const glm::vec3*>(values), valueCount / 3);
+		break;
+	}
 }
 
-void GltfAnimationChannel::setTranslations(std::vector<glm::vec3> tranlations) {
-	mTranslations = tranlations;
+template <typename T>
+void GltfAnimationChannel::setKeyframes(const GltfAccessorView<T>& view, const std::shared_ptr<GltfBufferData>& bufferData,
+	KeyframeView<T>& keyframes, std::vector<T>& storage) {
+
+	if (view.data()) {
+		mBufferData = bufferData;
+		keyframes.set(view.data(), view.size());
+		return;
+	}
+
+	view.copyTo(storage);
+	keyframes.set(storage.data(), storage.size());
 }
 
-void GltfAnimationChannel::setRotations(std::vector<glm::quat> rotations) {
-	mRotations = rotations;
+void GltfAnimationChannel::detachSourceData() {
+	// streamed channels keep reading their windows from the source
+	if (mStreamed) {
+		return;
+	}
+	detachKeyframes(mTimings, mTimingStorage);
+	detachKeyframes(mScaling, mScalingStorage);
+	detachKeyframes(mTranslations, mTranslationStorage);
+	detachKeyframes(mRotations, mRotationStorage);
+	mBufferData.reset();
+}
+
+template <typename T>
+void GltfAnimationChannel::detachKeyframes(KeyframeView<T>& keyframes, std::vector<T>& storage) {
+
+	if (keyframes.size() == 0 || keyframes.data() == storage.data()) {
+		return;
+	}
+	storage.assign(keyframes.data(), keyframes.data() + keyframes.size());
+	keyframes.set(storage.data(), storage.size());
+}
+
+bool GltfAnimationChannel::usesSourceData() {
+	return mTimingStorage.empty() && mScalingStorage.empty() && mTranslationStorage.empty() && mRotationStorage.empty();
+}
+
+void GltfAnimationChannel::startStreaming() {
+	mSourceTimings = mTimings;
+	mSourceValues = getValueData();
+	mSourceValueCount = getValueCount();
+	mStreamed = true;
+}
+
+void GltfAnimationChannel::readWindow(float startTime, float endTime, GltfKeyframeWindow& window) const {
+	const float* timings = mSourceTimings.data();
+	size_t keyCount = mSourceTimings.size();
+	if (keyCount == 0) {
+		window.timings.clear();
+		window.values.clear();
+		return;
+	}
+
+	// last key at or before the start up to the first key at or after the end, so both keys around every time inside are there
+	size_t firstKey = std::upper_bound(timings, timings + keyCount, startTime) - timings;
+	firstKey = firstKey > 0 ? firstKey - 1 : 0;
+	size_t lastKey = std::lower_bound(timings, timings + keyCount, endTime) - timings;
+	lastKey = std::max(std::min(lastKey, keyCount - 1), firstKey);
+
+	// cubic spline keys carry their tangents
+	size_t valuesPerKey = mSourceValueCount / keyCount;
+	window.timings.assign(timings + firstKey, timings + lastKey + 1);
+	window.values.assign(mSourceValues + firstKey * valuesPerKey, mSourceValues + (lastKey + 1) * valuesPerKey);
 }
 
 int GltfAnimationChannel::getTargetNode() {
@@ -90,25 +149,34 @@ ETargetPath GltfAnimationChannel::getTargetPath() {
 	return mTargetPath;
 }
 
-glm::vec3 GltfAnimationChannel::getTranslation(float time) {
-	if (mTranslations.size() == 0)
+glm::vec3 GltfAnimationChannel::getTranslation(float time, const GltfKeyframeWindow* window) {
+	// a window of a streamed clip, or the whole channel
+	KeyframeView<float> timings = mTimings;
+	KeyframeView<glm::vec3> translations = mTranslations;
+	if (window)
+	{
+		timings.set(window->timings.data(), window->timings.size());
+		translations.set(reinterpret_cast<const glm::vec3*>(window->values.data()), window->values.size() / 3);
+	}
+
+	if (translations.size() == 0)
 	{
 		return glm::vec3(1.0f);
 	}
-	if (time < mTimings.at(0))
+	if (time < timings.at(0))
 	{
-		return mTranslations.at(0);
+		return translations.at(0);
 	}
-	if (time > mTimings.at(mTimings.size() - 1))
+	if (time > timings.at(timings.size() - 1))
 	{
-		return mTranslations.at(mTranslations.size() - 1);
+		return translations.at(translations.size() - 1);
 	}
 
 	int prevTimeIndex = 0;
 	int nextTimeIndex = 0;
-	for (int i = 0; i < mTimings.size(); ++i)
+	for (int i = 0; i < timings.size(); ++i)
 	{
-		if (mTimings.at(i) > time)
+		if (timings.at(i) > time)
 		{
 			nextTimeIndex = i;
 			break;
@@ -118,7 +186,7 @@ glm::vec3 GltfAnimationChannel::getTranslation(float time) {
 
 	if (prevTimeIndex == nextTimeIndex)
 	{
-		return mTranslations.at(prevTimeIndex);
+		return translations.at(prevTimeIndex);
 	}
 
 	glm::vec3 finalTranslation = glm::vec3(1.0f);
@@ -126,15 +194,15 @@ glm::vec3 GltfAnimationChannel::getTranslation(float time) {
 	switch (mInterType)
 	{
 	case EInterpolationType::STEP:
-		finalTranslation = mTranslations.at(prevTimeIndex);
+		finalTranslation = translations.at(prevTimeIndex);
 		break;
 
 	case EInterpolationType::LINEAR:
 	{
-		float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+		float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 
-		glm::vec3 prevTranslation = mTranslations.at(prevTimeIndex);
-		glm::vec3 nextTranslation = mTranslations.at(nextTimeIndex);
+		glm::vec3 prevTranslation = translations.at(prevTimeIndex);
+		glm::vec3 nextTranslation = translations.at(nextTimeIndex);
 		finalTranslation = prevTranslation + interpolatedTime * (nextTranslation - prevTranslation);
 	}
 	break;
@@ -142,19 +210,19 @@ glm::vec3 GltfAnimationChannel::getTranslation(float time) {
 	case EInterpolationType::CUBICSPLINE:
 	{
 		// Values stored as in-tangent, data value, out-tangent for each time entry
-		float deltaTime = mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex);
+		float deltaTime = timings.at(nextTimeIndex) - timings.at(prevTimeIndex);
 
 		// Tangents are normalized, so we need to scale it according to deltaTime
-		glm::vec3 prevTangent = deltaTime * mTranslations.at(prevTimeIndex * 3 + 2);
-		glm::vec3 nextTangent = deltaTime * mTranslations.at(nextTimeIndex * 3);
+		glm::vec3 prevTangent = deltaTime * translations.at(prevTimeIndex * 3 + 2);
+		glm::vec3 nextTangent = deltaTime * translations.at(nextTimeIndex * 3);
 
 
 		// Get final scale by using the hermite formula
-		float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+		float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 		float interpolatedTimeSq = interpolatedTime * interpolatedTime;
 		float interpolatedTimeCub = interpolatedTimeSq * interpolatedTime;
-		glm::vec3 prevPoint = mTranslations.at(prevTimeIndex * 3 + 1);
-		glm::vec3 nextPoint = mTranslations.at(nextTimeIndex * 3 + 1);
+		glm::vec3 prevPoint = translations.at(prevTimeIndex * 3 + 1);
+		glm::vec3 nextPoint = translations.at(nextTimeIndex * 3 + 1);
 
 
 		finalTranslation = (2 * interpolatedTimeCub - 3 * interpolatedTimeSq + 1) * prevPoint + (interpolatedTimeCub - 2 * interpolatedTimeSq + interpolatedTime) * prevTangent + (-2 * interpolatedTimeCub + 3 * interpolatedTimeSq) * nextPoint + (interpolatedTimeCub - interpolatedTimeSq) * nextTangent;
@@ -165,25 +233,34 @@ glm::vec3 GltfAnimationChannel::getTranslation(float time) {
 	return finalTranslation;
 }
 
-glm::vec3 GltfAnimationChannel::getScaling(float time) {
-	if (mScaling.size() == 0)
+glm::vec3 GltfAnimationChannel::getScaling(float time, const GltfKeyframeWindow* window) {
+	// a window of a streamed clip, or the whole channel
+	KeyframeView<float> timings = mTimings;
+	KeyframeView<glm::vec3> scaling = mScaling;
+	if (window)
+	{
+		timings.set(window->timings.data(), window->timings.size());
+		scaling.set(reinterpret_cast<const glm::vec3*>(window->values.data()), window->values.size() / 3);
+	}
+
+	if (scaling.size() == 0)
 	{
 		return glm::vec3(1.0f);
 	}
-	if (time < mTimings.at(0))
+	if (time < timings.at(0))
 	{
-		return mScaling.at(0);
+		return scaling.at(0);
 	}
-	if (time > mTimings.at(mTimings.size() - 1))
+	if (time > timings.at(timings.size() - 1))
 	{
-		return mScaling.at(mScaling.size() - 1);
+		return scaling.at(scaling.size() - 1);
 	}
 
 	int prevTimeIndex = 0;
 	int nextTimeIndex = 0;
-	for (int i = 0; i < mTimings.size(); ++i)
+	for (int i = 0; i < timings.size(); ++i)
 	{
-		if (mTimings.at(i) > time)
+		if (timings.at(i) > time)
 		{
 			nextTimeIndex = i;
 			break;
@@ -193,7 +270,7 @@ glm::vec3 GltfAnimationChannel::getScaling(float time) {
 
 	if (prevTimeIndex == nextTimeIndex)
 	{
-		return mScaling.at(prevTimeIndex);
+		return scaling.at(prevTimeIndex);
 	}
 
 	glm::vec3 finalScale = glm::vec3(1.0f);
@@ -201,15 +278,15 @@ glm::vec3 GltfAnimationChannel::getScaling(float time) {
 	switch (mInterType)
 	{
 		case EInterpolationType::STEP:
-			finalScale = mScaling.at(prevTimeIndex);
+			finalScale = scaling.at(prevTimeIndex);
 			break;
 
 		case EInterpolationType::LINEAR:
 		{
-			float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+			float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 
-			glm::vec3 prevScale = mScaling.at(prevTimeIndex);
-			glm::vec3 nextScale = mScaling.at(nextTimeIndex);
+			glm::vec3 prevScale = scaling.at(prevTimeIndex);
+			glm::vec3 nextScale = scaling.at(nextTimeIndex);
 			finalScale = prevScale + interpolatedTime * (nextScale - prevScale);
 		}
 		break;
@@ -217,19 +294,19 @@ glm::vec3 GltfAnimationChannel::getScaling(float time) {
 		case EInterpolationType::CUBICSPLINE:
 		{
 			// Values stored as in-tangent, data value, out-tangent for each time entry
-			float deltaTime = mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex);
+			float deltaTime = timings.at(nextTimeIndex) - timings.at(prevTimeIndex);
 
 			// Tangents are normalized, so we need to scale it according to deltaTime
-			glm::vec3 prevTangent = deltaTime * mScaling.at(prevTimeIndex * 3 + 2);
-			glm::vec3 nextTangent = deltaTime * mScaling.at(nextTimeIndex * 3);
+			glm::vec3 prevTangent = deltaTime * scaling.at(prevTimeIndex * 3 + 2);
+			glm::vec3 nextTangent = deltaTime * scaling.at(nextTimeIndex * 3);
 
 
 			// Get final scale by using the hermite formula
-			float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+			float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 			float interpolatedTimeSq = interpolatedTime * interpolatedTime;
 			float interpolatedTimeCub = interpolatedTimeSq * interpolatedTime;
-			glm::vec3 prevPoint = mScaling.at(prevTimeIndex * 3 + 1);
-			glm::vec3 nextPoint = mScaling.at(nextTimeIndex * 3 + 1);
+			glm::vec3 prevPoint = scaling.at(prevTimeIndex * 3 + 1);
+			glm::vec3 nextPoint = scaling.at(nextTimeIndex * 3 + 1);
 
 
 			finalScale = (2 * interpolatedTimeCub - 3 * interpolatedTimeSq + 1) * prevPoint + (interpolatedTimeCub - 2 * interpolatedTimeSq + interpolatedTime) * prevTangent + (-2 * interpolatedTimeCub + 3 * interpolatedTimeSq) * nextPoint + (interpolatedTimeCub - interpolatedTimeSq) * nextTangent;
@@ -240,25 +317,34 @@ glm::vec3 GltfAnimationChannel::getScaling(float time) {
 	return finalScale;
 }
 
-glm::quat GltfAnimationChannel::getRotation(float time) {
-	if (mRotations.size() == 0)
+glm::quat GltfAnimationChannel::getRotation(float time, const GltfKeyframeWindow* window) {
+	// a window of a streamed clip, or the whole channel
+	KeyframeView<float> timings = mTimings;
+	KeyframeView<glm::quat> rotations = mRotations;
+	if (window)
+	{
+		timings.set(window->timings.data(), window->timings.size());
+		rotations.set(reinterpret_cast<const glm::quat*>(window->values.data()), window->values.size() / 4);
+	}
+
+	if (rotations.size() == 0)
 	{
 		return glm::identity<glm::quat>();
 	}
-	if (time < mTimings.at(0))
+	if (time < timings.at(0))
 	{
-		return mRotations.at(0);
+		return rotations.at(0);
 	}
-	if (time > mTimings.at(mTimings.size() - 1))
+	if (time > timings.at(timings.size() - 1))
 	{
-		return mRotations.at(mRotations.size() - 1);
+		return rotations.at(rotations.size() - 1);
 	}
 
 	int prevTimeIndex = 0;
 	int nextTimeIndex = 0;
-	for (int i = 0; i < mTimings.size(); ++i)
+	for (int i = 0; i < timings.size(); ++i)
 	{
-		if (mTimings.at(i) > time)
+		if (timings.at(i) > time)
 		{
 			nextTimeIndex = i;
 			break;
@@ -268,7 +354,7 @@ glm::quat GltfAnimationChannel::getRotation(float time) {
 
 	if (prevTimeIndex == nextTimeIndex)
 	{
-		return mRotations.at(prevTimeIndex);
+		return rotations.at(prevTimeIndex);
 	}
 
 	glm::quat finalRotation = glm::identity<glm::quat>();
@@ -276,15 +362,15 @@ glm::quat GltfAnimationChannel::getRotation(float time) {
 	switch (mInterType)
 	{
 	case EInterpolationType::STEP:
-		finalRotation = mRotations.at(prevTimeIndex);
+		finalRotation = rotations.at(prevTimeIndex);
 		break;
 
 	case EInterpolationType::LINEAR:
 	{
-		float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+		float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 
-		glm::quat prevRotation = mRotations.at(prevTimeIndex);
-		glm::quat nextRotation = mRotations.at(nextTimeIndex);
+		glm::quat prevRotation = rotations.at(prevTimeIndex);
+		glm::quat nextRotation = rotations.at(nextTimeIndex);
 		finalRotation = prevRotation + interpolatedTime * (nextRotation - prevRotation);
 	}
 	break;
@@ -292,19 +378,19 @@ glm::quat GltfAnimationChannel::getRotation(float time) {
 	case EInterpolationType::CUBICSPLINE:
 	{
 		// Values stored as in-tangent, data value, out-tangent for each time entry
-		float deltaTime = mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex);
+		float deltaTime = timings.at(nextTimeIndex) - timings.at(prevTimeIndex);
 
 		// Tangents are normalized, so we need to scale it according to deltaTime
-		glm::quat prevTangent = deltaTime * mRotations.at(prevTimeIndex * 3 + 2);
-		glm::quat nextTangent = deltaTime * mRotations.at(nextTimeIndex * 3);
+		glm::quat prevTangent = deltaTime * rotations.at(prevTimeIndex * 3 + 2);
+		glm::quat nextTangent = deltaTime * rotations.at(nextTimeIndex * 3);
 
 
 		// Get final scale by using the hermite formula
-		float interpolatedTime = (time - mTimings.at(prevTimeIndex)) / (mTimings.at(nextTimeIndex) - mTimings.at(prevTimeIndex));
+		float interpolatedTime = (time - timings.at(prevTimeIndex)) / (timings.at(nextTimeIndex) - timings.at(prevTimeIndex));
 		float interpolatedTimeSq = interpolatedTime * interpolatedTime;
 		float interpolatedTimeCub = interpolatedTimeSq * interpolatedTime;
-		glm::quat prevPoint = mRotations.at(prevTimeIndex * 3 + 1);
-		glm::quat nextPoint = mRotations.at(nextTimeIndex * 3 + 1);
+		glm::quat prevPoint = rotations.at(prevTimeIndex * 3 + 1);
+		glm::quat nextPoint = rotations.at(nextTimeIndex * 3 + 1);
 
 
 		finalRotation = (2 * interpolatedTimeCub - 3 * interpolatedTimeSq + 1) * prevPoint + (interpolatedTimeCub - 2 * interpolatedTimeSq + interpolatedTime) * prevTangent + (-2 * interpolatedTimeCub + 3 * interpolatedTimeSq) * nextPoint + (interpolatedTimeCub - interpolatedTimeSq) * nextTangent;
@@ -317,5 +403,55 @@ glm::quat GltfAnimationChannel::getRotation(float time) {
 
 float GltfAnimationChannel::getMaxTime()
 {
-	return mTimings.at(mTimings.size() - 1);
-}
\ No newline at end of file
+	const KeyframeView<float>& timings = getTimings();
+	return timings.at(timings.size() - 1);
+}
+
+size_t GltfAnimationChannel::getKeyframeBytes()
+{
+	return (getTimings().size() + getValueCount()) * sizeof(float);
+}
+
+EInterpolationType GltfAnimationChannel::getInterpolationType()
+{
+	return mInterType;
+}
+
+const KeyframeView<float>& GltfAnimationChannel::getTimings()
+{
+	return mStreamed ? mSourceTimings : mTimings;
+}
+
+const float* GltfAnimationChannel::getValueData()
+{
+	if (mStreamed)
+	{
+		return mSourceValues;
+	}
+	switch (mTargetPath)
+	{
+	case ETargetPath::ROTATION:
+		return reinterpret_cast<const float*>(mRotations.data());
+	case ETargetPath::TRANSLATION:
+		return reinterpret_cast<const float*>(mTranslations.data());
+	default:
+		return reinterpret_cast<const float*>(mScaling.data());
+	}
+}
+
+size_t GltfAnimationChannel::getValueCount()
+{
+	if (mStreamed)
+	{
+		return mSourceValueCount;
+	}
+	switch (mTargetPath)
+	{
+	case ETargetPath::ROTATION:
+		return mRotations.size() * 4;
+	case ETargetPath::TRANSLATION:
+		return mTranslations.size() * 3;
+	default:
+		return mScaling.size() * 3;
+	}
+}
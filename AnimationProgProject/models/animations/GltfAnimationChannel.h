@@ -1,10 +1,14 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
 #include <tiny_gltf.h>
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include "../gltf/GltfBufferData.h"
+#include "../gltf/GltfAccessorView.h"
+#include "../gltf/GltfCookedFormat.h"
 
 
 enum class ETargetPath 
@@ -22,35 +26,125 @@ enum class EInterpolationType
 };
 
 
+// Read only array of keyframe data, points to the storage of the channel or into a mapped cooked model
+template <typename T>
+class KeyframeView
+{
+public:
+	void set(const T* data, size_t size)
+	{
+		mData = data;
+		mSize = size;
+	}
+
+	const T& at(size_t index) const
+	{
+		return mData[index];
+	}
+
+	size_t size() const
+	{
+		return mSize;
+	}
+
+	const T* data() const
+	{
+		return mData;
+	}
+
+private:
+	const T* mData = nullptr;
+	size_t mSize = 0;
+};
+
+
+// Keyframes of a channel between two times, copied out of the source data of a streamed clip
+struct GltfKeyframeWindow
+{
+	std::vector<float> timings{};
+	std::vector<float> values{};
+};
+
+
 class GltfAnimationChannel 
 {
 public:
 
-	void loadChannelData(std::shared_ptr<tinygltf::Model> model, tinygltf::Animation anim, tinygltf::AnimationChannel channel);
+	// Reads the keyframes of a glTF channel, only reads the model and the buffers, so channels can be loaded in parallel
+	void loadChannelData(const tinygltf::Model& model, const std::shared_ptr<GltfBufferData>& bufferData,
+		const tinygltf::Animation& anim, const tinygltf::AnimationChannel& channel);
+
+	// Uses the keyframes of a cooked model in place, the mapping has to stay alive as long as the channel
+	// @param channel - Channel description of the cooked model
+	// @param keys - Start of the keyframe section
+	void loadCookedChannelData(const GltfCookedChannel& channel, const float* keys);
+
+	// Copies keyframes used in place into the own storage, the glTF buffers or the cooked file can be freed afterwards
+	void detachSourceData();
+
+	// True if the keyframes are used in place, in the glTF buffers or the cooked file
+	bool usesSourceData();
+
+	// Keeps the current keyframes as the source of the windows, the samplers pass their window to the getters
+	void startStreaming();
+
+	// Copies the keys from startTime to endTime out of the source, safe to call on worker threads
+	// @param window - Receives the keys, sampling inside the times gives the same result as the whole channel
+	void readWindow(float startTime, float endTime, GltfKeyframeWindow& window) const;
 
 	/*Getters*/
 	int getTargetNode();
 	ETargetPath getTargetPath();
-	glm::vec3 getTranslation(float time);
-	glm::quat getRotation(float time);
-	glm::vec3 getScaling(float time);
+	// @param window - Keys read by readWindow around the time, nullptr samples the whole channel
+	glm::vec3 getTranslation(float time, const GltfKeyframeWindow* window = nullptr);
+	glm::quat getRotation(float time, const GltfKeyframeWindow* window = nullptr);
+	glm::vec3 getScaling(float time, const GltfKeyframeWindow* window = nullptr);
 	float getMaxTime();
 
+	// Raw keyframe data for the asset cooker, the whole source of a streamed channel
+	EInterpolationType getInterpolationType();
+	const KeyframeView<float>& getTimings();
+	const float* getValueData();
+	size_t getValueCount();
+
+	// Bytes of the timings and values, in the own storage or used in place
+	size_t getKeyframeBytes();
+
 private:
 	int mTargetNode = -1;
 
 	ETargetPath mTargetPath = ETargetPath::ROTATION;
 	EInterpolationType mInterType = EInterpolationType::LINEAR;
 
-	std::vector<float> mTimings{};
-	std::vector<glm::vec3> mScaling{};
-	std::vector<glm::vec3> mTranslations{};
-	std::vector<glm::quat> mRotations{};
+	KeyframeView<float> mTimings{};
+	KeyframeView<glm::vec3> mScaling{};
+	KeyframeView<glm::vec3> mTranslations{};
+	KeyframeView<glm::quat> mRotations{};
+
+	// Keyframes converted from a glTF file, empty if they are used in place or come from a cooked model
+	std::vector<float> mTimingStorage{};
+	std::vector<glm::vec3> mScalingStorage{};
+	std::vector<glm::vec3> mTranslationStorage{};
+	std::vector<glm::quat> mRotationStorage{};
+
+	// Keeps the glTF buffers alive while keyframes point into them
+	std::shared_ptr<GltfBufferData> mBufferData = nullptr;
+
+	// All keyframes of a streamed channel, the windows are read from them
+	bool mStreamed = false;
+	KeyframeView<float> mSourceTimings{};
+	const float* mSourceValues = nullptr;
+	size_t mSourceValueCount = 0;
+
+	// Points the value view of the target path at the floats
+	void setValues(const float* values, size_t valueCount);
+
+	// Points the keyframes at the accessor if its layout matches, converts them into the storage otherwise
+	template <typename T>
+	void setKeyframes(const GltfAccessorView<T>& view, const std::shared_ptr<GltfBufferData>& bufferData,
+		KeyframeView<T>& keyframes, std::vector<T>& storage);
 
-	/* Setters */
-	void setTimings(std::vector<float> timinings);
-	void setScalings(std::vector<glm::vec3> scalings);
-	void setTranslations(std::vector<glm::vec3> tranlations);
-	void setRotations(std::vector<glm::quat> rotations);
+	template <typename T>
+	void detachKeyframes(KeyframeView<T>& keyframes, std::vector<T>& storage);
 
 };
\ No newline at end of file
@@ -1,31 +1,336 @@
+#include <cmath>
+#include <ThreadPool.h>
 #include "GltfAnimationClip.h"
+#include "../Logger/Logger.h"
 
 GltfAnimationClip::GltfAnimationClip(std::string name) : mClipName(name) {}
 
-void GltfAnimationClip::addChannel(std::shared_ptr<tinygltf::Model> model, tinygltf::Animation anim, tinygltf::AnimationChannel channel)
+GltfAnimationClip::GltfAnimationClip(std::string name, GltfClipLoader loader, float endTime) :
+	mClipName(name), mLoader(loader), mEndTime(endTime) {}
+
+bool GltfAnimationClip::load()
+{
+	mUsed = true;
+	if (!mAnimationChannels.empty() || !mLoader)
+	{
+		return !mAnimationChannels.empty();
+	}
+
+	if (!mLoader(*this) || mAnimationChannels.empty())
+	{
+		Logger::log(0, "%s error: could not load clip '%s'\n", __FUNCTION__, mClipName.c_str());
+		mAnimationChannels.clear();
+		return false;
+	}
+	++mLoadCount;
+	Logger::log(2, "%s: loaded clip '%s' with %i channels\n", __FUNCTION__, mClipName.c_str(), mAnimationChannels.size());
+	startStreaming();
+	return true;
+}
+
+void GltfAnimationClip::unload()
+{
+	// eager clips cannot be loaded again
+	if (!mLoader)
+	{
+		return;
+	}
+	stopStreaming();
+	mAnimationChannels.clear();
+	mAnimationChannels.shrink_to_fit();
+}
+
+bool GltfAnimationClip::isLoaded()
+{
+	return !mAnimationChannels.empty();
+}
+
+bool GltfAnimationClip::isLazy()
+{
+	return mLoader != nullptr;
+}
+
+bool GltfAnimationClip::checkUsed()
+{
+	bool used = mUsed;
+	mUsed = false;
+	return used;
+}
+
+size_t GltfAnimationClip::getMemoryBytes()
+{
+	size_t bytes = 0;
+	if (mStreamed)
+	{
+		for (const auto& window : mWindows)
+		{
+			bytes += window->bytes;
+		}
+		return bytes;
+	}
+
+	for (const auto& channel : mAnimationChannels)
+	{
+		bytes += channel->getKeyframeBytes();
+	}
+	return bytes;
+}
+
+unsigned int GltfAnimationClip::getLoadCount()
+{
+	return mLoadCount;
+}
+
+void GltfAnimationClip::setStreaming(const GltfClipStreaming& streaming)
+{
+	mStreaming = streaming;
+	mStreaming.maxWindows = std::max(mStreaming.maxWindows, 3);
+	startStreaming();
+}
+
+bool GltfAnimationClip::isStreamed()
+{
+	return mStreamed;
+}
+
+unsigned int GltfAnimationClip::getStreamMisses()
+{
+	return mStreamMisses;
+}
+
+void GltfAnimationClip::startStreaming()
+{
+	if (mStreamed || !mStreaming.source || mStreaming.windowTime <= 0.0f || mAnimationChannels.empty())
+	{
+		return;
+	}
+
+	size_t bytes = getMemoryBytes();
+	if (bytes < mStreaming.minBytes)
+	{
+		return;
+	}
+
+	// converted keyframes are in memory anyway, windows would only add a copy
+	float endTime = 0.0f;
+	for (const auto& channel : mAnimationChannels)
+	{
+		if (!channel->usesSourceData())
+		{
+			Logger::log(1, "%s: keyframes of clip '%s' were converted, the clip stays resident\n", __FUNCTION__, mClipName.c_str());
+			return;
+		}
+		endTime = std::max(endTime, channel->getMaxTime());
+	}
+
+	for (auto& channel : mAnimationChannels)
+	{
+		channel->startStreaming();
+	}
+	mStreamed = true;
+	mWindowCount = std::max(static_cast<int>(std::ceil(endTime / mStreaming.windowTime)), 1);
+
+	// playback usually starts at the beginning, the first window is read right away
+	mWindows.push_back(readWindow(mAnimationChannels, 0, 0.0f, mStreaming.windowTime));
+	mWindows.back()->lastUse = ++mWindowUseCounter;
+
+	Logger::log(1, "%s: clip '%s' (%i KB) streams in %i windows of %.1f s\n", __FUNCTION__, mClipName.c_str(),
+		bytes / 1024, mWindowCount, mStreaming.windowTime);
+}
+
+void GltfAnimationClip::stopStreaming()
+{
+	// reads still running finish on their own, they hold the channels and the source
+	mWindowReads.clear();
+	mWindows.clear();
+	mDefaultCursor.window.reset();
+	mStreamed = false;
+}
+
+const GltfClipWindow& GltfAnimationClip::selectWindow(float time, GltfClipCursor& cursor)
+{
+	// windows read in the background meanwhile become resident
+	for (auto iter = mWindowReads.begin(); iter != mWindowReads.end();)
+	{
+		if (iter->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++iter;
+			continue;
+		}
+		mWindows.push_back(iter->second.get());
+		mWindows.back()->lastUse = ++mWindowUseCounter;
+		iter = mWindowReads.erase(iter);
+	}
+
+	int index = std::clamp(static_cast<int>(time / mStreaming.windowTime), 0, mWindowCount - 1);
+	std::shared_ptr<GltfClipWindow> window = findWindow(index);
+	if (!window)
+	{
+		// without a thread pool the window is read right here
+		requestWindow(index);
+		window = findWindow(index);
+	}
+	if (!window)
+	{
+		// never wait for the file, the nearest window holds its first or last pose until the right one is read
+		++mStreamMisses;
+		window = cursor.window;
+		for (const auto& resident : mWindows)
+		{
+			if (!window || std::abs(resident->index - index) < std::abs(window->index - index))
+			{
+				window = resident;
+			}
+		}
+	}
+	if (!window)
+	{
+		// all windows were evicted and the cursor is new, the only read the sampler waits for
+		window = readWindow(mAnimationChannels, index, index * mStreaming.windowTime, (index + 1) * mStreaming.windowTime);
+		mWindows.push_back(window);
+	}
+	window->lastUse = ++mWindowUseCounter;
+	cursor.window = window;
+
+	// both neighbours, instances play the clips backwards too, and loop around at the ends
+	requestWindow((index + 1) % mWindowCount);
+	requestWindow((index + mWindowCount - 1) % mWindowCount);
+
+	// windows a cursor still points to stay, every sampler keeps at least its own window
+	while (mWindows.size() > static_cast<size_t>(mStreaming.maxWindows))
+	{
+		auto oldest = mWindows.end();
+		for (auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+		{
+			if (iter->use_count() == 1 && (oldest == mWindows.end() || (*iter)->lastUse < (*oldest)->lastUse))
+			{
+				oldest = iter;
+			}
+		}
+		if (oldest == mWindows.end())
+		{
+			break;
+		}
+		mWindows.erase(oldest);
+	}
+	return *window;
+}
+
+void GltfAnimationClip::requestWindow(int index)
+{
+	if (findWindow(index))
+	{
+		return;
+	}
+	for (const auto& read : mWindowReads)
+	{
+		if (read.first == index)
+		{
+			return;
+		}
+	}
+
+	float startTime = index * mStreaming.windowTime;
+	float endTime = startTime + mStreaming.windowTime;
+	if (!mStreaming.threadPool)
+	{
+		mWindows.push_back(readWindow(mAnimationChannels, index, startTime, endTime));
+		mWindows.back()->lastUse = ++mWindowUseCounter;
+		return;
+	}
+
+	// no more reads in flight than windows can stay resident
+	if (mWindowReads.size() >= static_cast<size_t>(mStreaming.maxWindows))
+	{
+		return;
+	}
+	std::vector<std::shared_ptr<GltfAnimationChannel>> channels = mAnimationChannels;
+	std::shared_ptr<void> source = mStreaming.source;
+	mWindowReads.emplace_back(index, mStreaming.threadPool->submit([channels, source, index, startTime, endTime]() {
+		return readWindow(channels, index, startTime, endTime);
+	}));
+}
+
+std::shared_ptr<GltfClipWindow> GltfAnimationClip::findWindow(int index)
+{
+	for (const auto& window : mWindows)
+	{
+		if (window->index == index)
+		{
+			return window;
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr<GltfClipWindow> GltfAnimationClip::readWindow(
+	const std::vector<std::shared_ptr<GltfAnimationChannel>>& channels, int index, float startTime, float endTime)
+{
+	std::shared_ptr<GltfClipWindow> window = std::make_shared<GltfClipWindow>();
+	window->index = index;
+	window->channels.resize(channels.size());
+	for (size_t i = 0; i < channels.size(); ++i)
+	{
+		channels.at(i)->readWindow(startTime, endTime, window->channels.at(i));
+		window->bytes += (window->channels.at(i).timings.size() + window->channels.at(i).values.size()) * sizeof(float);
+	}
+	return window;
+}
+
+void GltfAnimationClip::addChannel(const tinygltf::Model& model, const std::shared_ptr<GltfBufferData>& bufferData,
+	const tinygltf::Animation& anim, const tinygltf::AnimationChannel& channel)
 {
 	std::shared_ptr<GltfAnimationChannel> chan = std::make_shared<GltfAnimationChannel>();
-	chan->loadChannelData(model, anim, channel);
+	chan->loadChannelData(model, bufferData, anim, channel);
 	mAnimationChannels.push_back(chan);
 }
 
-void GltfAnimationClip::setAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time)
+void GltfAnimationClip::addChannel(std::shared_ptr<GltfAnimationChannel> channel)
+{
+	mAnimationChannels.push_back(channel);
+}
+
+void GltfAnimationClip::addCookedChannel(const GltfCookedChannel& channel, const float* keys)
 {
+	std::shared_ptr<GltfAnimationChannel> chan = std::make_shared<GltfAnimationChannel>();
+	chan->loadCookedChannelData(channel, keys);
+	mAnimationChannels.push_back(chan);
+}
+
+void GltfAnimationClip::detachSourceData()
+{
+	// streamed clips keep reading their windows from the source
+	if (mStreamed)
+	{
+		return;
+	}
 	for (auto& channel : mAnimationChannels)
 	{
+		channel->detachSourceData();
+	}
+}
+
+void GltfAnimationClip::setAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time, GltfClipCursor* cursor)
+{
+	load();
+	const GltfClipWindow* window = mStreamed ? &selectWindow(time, cursor ? *cursor : mDefaultCursor) : nullptr;
+	for (size_t i = 0; i < mAnimationChannels.size(); ++i)
+	{
+		const std::shared_ptr<GltfAnimationChannel>& channel = mAnimationChannels.at(i);
+		const GltfKeyframeWindow* channelWindow = window ? &window->channels.at(i) : nullptr;
 		int targetNode = channel->getTargetNode();
 		if (additiveMask.at(targetNode)) 
 		{
 			switch (channel->getTargetPath())
 			{
 			case ETargetPath::ROTATION:
-				nodes.at(targetNode)->setRotation(channel->getRotation(time));
+				nodes.at(targetNode)->setRotation(channel->getRotation(time, channelWindow));
 				break;
 			case ETargetPath::TRANSLATION:
-				nodes.at(targetNode)->setTranslation(channel->getTranslation(time));
+				nodes.at(targetNode)->setTranslation(channel->getTranslation(time, channelWindow));
 				break;
 			case ETargetPath::SCALE:
-				nodes.at(targetNode)->setScale(channel->getScaling(time));
+				nodes.at(targetNode)->setScale(channel->getScaling(time, channelWindow));
 				break;
 			}
 		}
@@ -40,23 +345,27 @@ void GltfAnimationClip::setAnimationFrame(std::vector<std::shared_ptr<GltfNode>>
 	}
 }
 
-void GltfAnimationClip::blendAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time,float blendFactor)
+void GltfAnimationClip::blendAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time,float blendFactor, GltfClipCursor* cursor)
 {
-	for (auto& channel : mAnimationChannels)
+	load();
+	const GltfClipWindow* window = mStreamed ? &selectWindow(time, cursor ? *cursor : mDefaultCursor) : nullptr;
+	for (size_t i = 0; i < mAnimationChannels.size(); ++i)
 	{
+		const std::shared_ptr<GltfAnimationChannel>& channel = mAnimationChannels.at(i);
+		const GltfKeyframeWindow* channelWindow = window ? &window->channels.at(i) : nullptr;
 		int targetNode = channel->getTargetNode();
 		if (additiveMask.at(targetNode)) 
 		{
 			switch (channel->getTargetPath())
 			{
 			case ETargetPath::ROTATION:
-				nodes.at(targetNode)->blendRotation(channel->getRotation(time),blendFactor);
+				nodes.at(targetNode)->blendRotation(channel->getRotation(time, channelWindow),blendFactor);
 				break;
 			case ETargetPath::TRANSLATION:
-				nodes.at(targetNode)->blendTranslation(channel->getTranslation(time),blendFactor);
+				nodes.at(targetNode)->blendTranslation(channel->getTranslation(time, channelWindow),blendFactor);
 				break;
 			case ETargetPath::SCALE:
-				nodes.at(targetNode)->blendScale(channel->getScaling(time),blendFactor);
+				nodes.at(targetNode)->blendScale(channel->getScaling(time, channelWindow),blendFactor);
 				break;
 			}
 		}
@@ -73,10 +382,21 @@ void GltfAnimationClip::blendAnimationFrame(std::vector<std::shared_ptr<GltfNode
 
 float GltfAnimationClip::getClipEndTime()
 {
-	return mAnimationChannels.at(0)->getMaxTime();;
+	// unloaded clips keep the length they were created with
+	if (mAnimationChannels.empty())
+	{
+		return mEndTime;
+	}
+	return mAnimationChannels.at(0)->getMaxTime();
 }
 
 std::string GltfAnimationClip::getClipName()
 {
 	return mClipName;
 }
+
+std::vector<std::shared_ptr<GltfAnimationChannel>> GltfAnimationClip::getChannels()
+{
+	load();
+	return mAnimationChannels;
+}
\ No newline at end of file
@@ -2,30 +2,140 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <future>
 #include <tiny_gltf.h>
 #include "../gltf/GltfNode.h"
 #include "GltfAnimationChannel.h"
 
 
+class GltfAnimationClip;
+class ThreadPool;
+
+// Adds the channels of a clip, called on the first use of a lazy clip and again after it was unloaded
+using GltfClipLoader = std::function<bool(GltfAnimationClip& clip)>;
+
+// Streaming of long clips, see GltfAnimationClip::setStreaming
+struct GltfClipStreaming
+{
+	// Reads the windows in the background, nullptr reads them on the calling thread
+	ThreadPool* threadPool = nullptr;
+	// Clips with less keyframe data stay resident as a whole
+	size_t minBytes = 1024 * 1024;
+	float windowTime = 2.0f;
+	int maxWindows = 4;
+	// Keeps the mapped .glb buffers or the cooked file alive while the windows are read from it,
+	// nullptr keeps the clip resident
+	std::shared_ptr<void> source = nullptr;
+};
+
+// Keys of all channels of a streamed clip between two times
+struct GltfClipWindow
+{
+	int index = 0;
+	uint64_t lastUse = 0;
+	size_t bytes = 0;
+	std::vector<GltfKeyframeWindow> channels{};
+};
+
+// Window a sampler of a streamed clip is in. Every instance keeps one cursor per clip, so instances playing the
+// same clip at different times select their windows independently and keep them resident while they use them.
+struct GltfClipCursor
+{
+	std::shared_ptr<GltfClipWindow> window = nullptr;
+};
+
 class GltfAnimationClip {
 public:
 	GltfAnimationClip(std::string name);
 
+	// Lazy clip: only the name and the length are known until the clip is used for the first time
+	// @param loader - Adds the channels
+	// @param endTime - Length of the clip, known without the channels
+	GltfAnimationClip(std::string name, GltfClipLoader loader, float endTime);
+
+	// Creates the channels of a lazy clip if they are missing, marks the clip as used
+	bool load();
+
+	// Drops the channels of a lazy clip, the next use loads them again
+	void unload();
+
+	bool isLoaded();
+	bool isLazy();
+
+	// Returns whether the clip was used since the last call and clears the flag
+	bool checkUsed();
+
+	// Keyframe bytes of the loaded channels, only the resident windows of a streamed clip
+	size_t getMemoryBytes();
+	unsigned int getLoadCount();
+
+	// Large clips keep only a few time windows of keyframes resident, the windows next to the sampled ones are
+	// read in the background. Sampling never waits for a window, the nearest resident one is used until it arrives.
+	// Windows held by a cursor are never evicted, so the resident windows can exceed maxWindows with many samplers.
+	// @param streaming - Applied now, or when a lazy clip is loaded, if the keyframes are used in place
+	void setStreaming(const GltfClipStreaming& streaming);
+
+	bool isStreamed();
+
+	// Samples that used another window because the right one was not read yet
+	unsigned int getStreamMisses();
+
 
 	// Store the loaded channels in a vector and forward the parameters to the new channel object
-	void addChannel(std::shared_ptr<tinygltf::Model> model, tinygltf::Animation anim, tinygltf::AnimationChannel channel);
+	void addChannel(const tinygltf::Model& model, const std::shared_ptr<GltfBufferData>& bufferData,
+		const tinygltf::Animation& anim, const tinygltf::AnimationChannel& channel);
+
+	// Adds a channel that was already loaded, e.g. on a worker thread
+	void addChannel(std::shared_ptr<GltfAnimationChannel> channel);
+
+	// Adds a channel using the keyframes of a cooked model in place
+	void addCookedChannel(const GltfCookedChannel& channel, const float* keys);
+
+	// Moves the keyframes of all channels into their own storage, see GltfAnimationChannel::detachSourceData
+	void detachSourceData();
 
 	// Update the model nodes with data from a specific time point
-	void setAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time);
+	// @param cursor - Window of the sampler in a streamed clip, nullptr uses the cursor of the clip (one sampler only)
+	void setAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time,
+		GltfClipCursor* cursor = nullptr);
 
-	void blendAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time,float blendFactor);
+	void blendAnimationFrame(std::vector<std::shared_ptr<GltfNode>> nodes, std::vector<bool> additiveMask, float time,float blendFactor,
+		GltfClipCursor* cursor = nullptr);
 
 	float getClipEndTime();
 
 	std::string getClipName();
 
+	std::vector<std::shared_ptr<GltfAnimationChannel>> getChannels();
+
 private:
 	std::vector<std::shared_ptr<GltfAnimationChannel>> mAnimationChannels;
 	std::string mClipName;
 
+	GltfClipLoader mLoader = nullptr;
+	float mEndTime = 0.0f;
+	bool mUsed = false;
+	unsigned int mLoadCount = 0;
+
+	GltfClipStreaming mStreaming{};
+	bool mStreamed = false;
+	int mWindowCount = 0;
+	std::vector<std::shared_ptr<GltfClipWindow>> mWindows{};
+	std::vector<std::pair<int, std::future<std::shared_ptr<GltfClipWindow>>>> mWindowReads{};
+	GltfClipCursor mDefaultCursor{};
+	uint64_t mWindowUseCounter = 0;
+	unsigned int mStreamMisses = 0;
+
+	void startStreaming();
+	void stopStreaming();
+
+	// Moves the cursor to the window of the time, requests the missing and neighbouring windows
+	const GltfClipWindow& selectWindow(float time, GltfClipCursor& cursor);
+	void requestWindow(int index);
+	std::shared_ptr<GltfClipWindow> findWindow(int index);
+
+	static std::shared_ptr<GltfClipWindow> readWindow(const std::vector<std::shared_ptr<GltfAnimationChannel>>& channels,
+		int index, float startTime, float endTime);
+
 };
\ No newline at end of file
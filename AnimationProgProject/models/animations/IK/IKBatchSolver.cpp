@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <glm/gtx/quaternion.hpp>
+#include "IKBatchSolver.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IK_BATCH_SSE2
+#endif
+
+namespace {
+	// Moves the "to" node of every active lane onto the line from the "from" node, one bone length away from it
+	void moveLanes(const float* fromX, const float* fromY, const float* fromZ, float* toX, float* toY, float* toZ,
+		const float* boneLengths, const float* active)
+	{
+#ifdef IK_BATCH_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		for (int lane = 0; lane < IKBatchSolver::laneCount; lane += 4)
+		{
+			__m128 oldX = _mm_loadu_ps(toX + lane);
+			__m128 oldY = _mm_loadu_ps(toY + lane);
+			__m128 oldZ = _mm_loadu_ps(toZ + lane);
+			__m128 baseX = _mm_loadu_ps(fromX + lane);
+			__m128 baseY = _mm_loadu_ps(fromY + lane);
+			__m128 baseZ = _mm_loadu_ps(fromZ + lane);
+
+			__m128 dirX = _mm_sub_ps(oldX, baseX);
+			__m128 dirY = _mm_sub_ps(oldY, baseY);
+			__m128 dirZ = _mm_sub_ps(oldZ, baseZ);
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, dirX), _mm_mul_ps(dirY, dirY)),
+				_mm_mul_ps(dirZ, dirZ)));
+
+			// nodes on top of each other have no direction and stay, like the lanes that are done or empty
+			__m128 mask = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_cmpgt_ps(_mm_loadu_ps(active + lane), zero));
+			__m128 scale = _mm_div_ps(_mm_loadu_ps(boneLengths + lane), length);
+
+			__m128 newX = _mm_add_ps(baseX, _mm_mul_ps(dirX, scale));
+			__m128 newY = _mm_add_ps(baseY, _mm_mul_ps(dirY, scale));
+			__m128 newZ = _mm_add_ps(baseZ, _mm_mul_ps(dirZ, scale));
+			_mm_storeu_ps(toX + lane, _mm_or_ps(_mm_and_ps(mask, newX), _mm_andnot_ps(mask, oldX)));
+			_mm_storeu_ps(toY + lane, _mm_or_ps(_mm_and_ps(mask, newY), _mm_andnot_ps(mask, oldY)));
+			_mm_storeu_ps(toZ + lane, _mm_or_ps(_mm_and_ps(mask, newZ), _mm_andnot_ps(mask, oldZ)));
+		}
+#else
+		for (int lane = 0; lane < IKBatchSolver::laneCount; ++lane)
+		{
+			float dirX = toX[lane] - fromX[lane];
+			float dirY = toY[lane] - fromY[lane];
+			float dirZ = toZ[lane] - fromZ[lane];
+			float length = std::sqrt(dirX * dirX + dirY * dirY + dirZ * dirZ);
+			if (length > 0.0f && active[lane] > 0.0f)
+			{
+				float scale = boneLengths[lane] / length;
+				toX[lane] = fromX[lane] + dirX * scale;
+				toY[lane] = fromY[lane] + dirY * scale;
+				toZ[lane] = fromZ[lane] + dirZ * scale;
+			}
+		}
+#endif
+	}
+
+	// Places the node of every active lane at the position
+	void setLanes(float* x, float* y, float* z, const float* positionX, const float* positionY, const float* positionZ,
+		const float* active)
+	{
+		for (int lane = 0; lane < IKBatchSolver::laneCount; ++lane)
+		{
+			if (active[lane] > 0.0f)
+			{
+				x[lane] = positionX[lane];
+				y[lane] = positionY[lane];
+				z[lane] = positionZ[lane];
+			}
+		}
+	}
+}
+
+void IKBatchSolver::clear()
+{
+	mChains.clear();
+	mBatchCount = 0;
+}
+
+bool IKBatchSolver::addChain(const std::vector<std::shared_ptr<GltfNode>>& nodes, glm::vec3 target, unsigned int iterations)
+{
+	if (nodes.size() < 2)
+	{
+		return false;
+	}
+	for (const auto& node : nodes)
+	{
+		if (!node)
+		{
+			return false;
+		}
+	}
+
+	Chain chain{};
+	chain.nodes = &nodes;
+	chain.target = target;
+	chain.iterations = iterations;
+	mChains.push_back(chain);
+	return true;
+}
+
+void IKBatchSolver::solve()
+{
+	// chains of the same length next to each other, every run of them is split into batches
+	mChainOrder.resize(mChains.size());
+	std::iota(mChainOrder.begin(), mChainOrder.end(), 0);
+	std::stable_sort(mChainOrder.begin(), mChainOrder.end(), [this](size_t a, size_t b)
+		{
+			return mChains.at(a).nodes->size() < mChains.at(b).nodes->size();
+		});
+
+	mBatchCount = 0;
+	size_t first = 0;
+	while (first < mChainOrder.size())
+	{
+		size_t nodeCount = mChains.at(mChainOrder.at(first)).nodes->size();
+		int chainCount = 1;
+		while (chainCount < laneCount && first + chainCount < mChainOrder.size() &&
+			mChains.at(mChainOrder.at(first + chainCount)).nodes->size() == nodeCount)
+		{
+			++chainCount;
+		}
+
+		solveBatch(mChainOrder.data() + first, chainCount, nodeCount);
+		++mBatchCount;
+		first += chainCount;
+	}
+}
+
+void IKBatchSolver::solveBatch(const size_t* chains, int chainCount, size_t nodeCount)
+{
+	mPositionX.resize(nodeCount * laneCount);
+	mPositionY.resize(nodeCount * laneCount);
+	mPositionZ.resize(nodeCount * laneCount);
+	mBoneLengths.resize((nodeCount - 1) * laneCount);
+	float* x = mPositionX.data();
+	float* y = mPositionY.data();
+	float* z = mPositionZ.data();
+
+	// empty lanes repeat the first chain and stay inactive
+	unsigned int maxIterations = 0;
+	for (int lane = 0; lane < laneCount; ++lane)
+	{
+		const Chain& chain = mChains.at(chains[lane < chainCount ? lane : 0]);
+		for (size_t i = 0; i < nodeCount; ++i)
+		{
+			glm::vec3 position = glm::vec3(chain.nodes->at(i)->getNodeMatrix()[3]);
+			x[i * laneCount + lane] = position.x;
+			y[i * laneCount + lane] = position.y;
+			z[i * laneCount + lane] = position.z;
+		}
+		for (size_t i = 0; i < nodeCount - 1; ++i)
+		{
+			size_t start = i * laneCount + lane;
+			size_t end = start + laneCount;
+			glm::vec3 bone = glm::vec3(x[end] - x[start], y[end] - y[start], z[end] - z[start]);
+			mBoneLengths.at(start) = glm::length(bone);
+		}
+
+		size_t root = (nodeCount - 1) * laneCount + lane;
+		mBaseX[lane] = x[root];
+		mBaseY[lane] = y[root];
+		mBaseZ[lane] = z[root];
+		mTargetX[lane] = chain.target.x;
+		mTargetY[lane] = chain.target.y;
+		mTargetZ[lane] = chain.target.z;
+		mActive[lane] = lane < chainCount ? 1.0f : 0.0f;
+		if (lane < chainCount)
+		{
+			maxIterations = std::max(maxIterations, chain.iterations);
+		}
+	}
+
+	for (unsigned int iteration = 0; iteration < maxIterations; ++iteration)
+	{
+		// lanes out of iterations or with the effector at the target are done, like in IKSolver::solveFABRIK
+		bool anyActive = false;
+		for (int lane = 0; lane < chainCount; ++lane)
+		{
+			if (mActive[lane] == 0.0f)
+			{
+				continue;
+			}
+			glm::vec3 toTarget = glm::vec3(mTargetX[lane] - x[lane], mTargetY[lane] - y[lane], mTargetZ[lane] - z[lane]);
+			if (iteration >= mChains.at(chains[lane]).iterations || glm::length(toTarget) < mThreshold)
+			{
+				mActive[lane] = 0.0f;
+				continue;
+			}
+			anyActive = true;
+		}
+		if (!anyActive)
+		{
+			break;
+		}
+
+		// forward: the effector onto the target, every node towards its predecessor
+		setLanes(x, y, z, mTargetX, mTargetY, mTargetZ, mActive);
+		for (size_t i = 1; i < nodeCount; ++i)
+		{
+			size_t from = (i - 1) * laneCount;
+			size_t to = i * laneCount;
+			moveLanes(x + from, y + from, z + from, x + to, y + to, z + to, mBoneLengths.data() + from, mActive);
+		}
+
+		// backward: the root back onto its base, every node towards its successor
+		size_t root = (nodeCount - 1) * laneCount;
+		setLanes(x + root, y + root, z + root, mBaseX, mBaseY, mBaseZ, mActive);
+		for (size_t i = nodeCount - 1; i-- > 0;)
+		{
+			size_t from = (i + 1) * laneCount;
+			size_t to = i * laneCount;
+			moveLanes(x + from, y + from, z + from, x + to, y + to, z + to, mBoneLengths.data() + to, mActive);
+		}
+	}
+
+	for (int lane = 0; lane < chainCount; ++lane)
+	{
+		adjustNodes(mChains.at(chains[lane]), lane);
+	}
+}
+
+void IKBatchSolver::adjustNodes(const Chain& chain, int lane)
+{
+	auto solvedPosition = [this, lane](size_t node)
+		{
+			size_t index = node * laneCount + lane;
+			return glm::vec3(mPositionX.at(index), mPositionY.at(index), mPositionZ.at(index));
+		};
+
+	// from the root to the effector like IKSolver::adjustFABRIKNodes, but only the chain nodes are recalculated
+	// on the way instead of the whole subtree after every node
+	const std::vector<std::shared_ptr<GltfNode>>& nodes = *chain.nodes;
+	for (size_t i = nodes.size() - 1; i > 0; --i)
+	{
+		const std::shared_ptr<GltfNode>& node = nodes.at(i);
+		const std::shared_ptr<GltfNode>& nextNode = nodes.at(i - 1);
+		node->calculateNodeMatrix();
+		nextNode->calculateNodeMatrix();
+
+		glm::vec3 position = glm::vec3(node->getNodeMatrix()[3]);
+		glm::quat rotation = node->getGlobalRotation();
+		glm::vec3 nextPosition = glm::vec3(nextNode->getNodeMatrix()[3]);
+
+		glm::vec3 toNext = glm::normalize(nextPosition - position);
+		glm::vec3 toDesired = glm::normalize(solvedPosition(i - 1) - solvedPosition(i));
+
+		glm::quat nodeRotation = glm::rotation(toNext, toDesired);
+		glm::quat localRotation = rotation * nodeRotation * glm::conjugate(rotation);
+		node->blendRotation(node->getLocalRotation() * localRotation, 1.0f);
+		node->calculateNodeMatrix();
+	}
+}
+
+unsigned int IKBatchSolver::getChainCount()
+{
+	return static_cast<unsigned int>(mChains.size());
+}
+
+unsigned int IKBatchSolver::getBatchCount()
+{
+	return mBatchCount;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+#include "../models/gltf/GltfNode.h"
+
+// FABRIK for the chains of many instances at once. Chains with the same number of nodes are solved together in
+// batches of laneCount chains, the node positions of a batch are stored per component and node (SoA), so every
+// step of the forward and backward passes handles all chains of the batch with a few SIMD operations.
+class IKBatchSolver {
+public:
+	static constexpr int laneCount = 8;
+
+	// Removes the chains of the last frame, the memory is kept
+	void clear();
+
+	// Adds a chain, the node matrices have to be up to date
+	// @param nodes - Chain from the effector to the root, like IKSolver::setNodes
+	// @param target - World position for the effector
+	// @param iterations - Maximum number of forward and backward passes
+	bool addChain(const std::vector<std::shared_ptr<GltfNode>>& nodes, glm::vec3 target, unsigned int iterations);
+
+	// Runs the passes for all chains and writes the rotations back, the children of the chain roots
+	// still need one hierarchy update afterwards
+	void solve();
+
+	unsigned int getChainCount();
+	unsigned int getBatchCount();
+
+private:
+	struct Chain
+	{
+		const std::vector<std::shared_ptr<GltfNode>>* nodes = nullptr;
+		glm::vec3 target = glm::vec3(0.0f);
+		unsigned int iterations = 0;
+	};
+
+	std::vector<Chain> mChains{};
+	std::vector<size_t> mChainOrder{};
+	unsigned int mBatchCount = 0;
+	float mThreshold = 0.00001f;
+
+	// SoA data of the current batch, node by node, laneCount floats per node
+	std::vector<float> mPositionX{};
+	std::vector<float> mPositionY{};
+	std::vector<float> mPositionZ{};
+	std::vector<float> mBoneLengths{};
+	float mTargetX[laneCount] = {};
+	float mTargetY[laneCount] = {};
+	float mTargetZ[laneCount] = {};
+	float mBaseX[laneCount] = {};
+	float mBaseY[laneCount] = {};
+	float mBaseZ[laneCount] = {};
+	float mActive[laneCount] = {};
+
+	void solveBatch(const size_t* chains, int chainCount, size_t nodeCount);
+	void adjustNodes(const Chain& chain, int lane);
+};
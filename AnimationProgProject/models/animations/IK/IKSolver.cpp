@@ -1,6 +1,6 @@
 #include <glm/gtx/quaternion.hpp>
 #include "IKSolver.h"
-#include "../logger/Logger.h"
+#include "../Logger/Logger.h"
 
 IKSolver::IKSolver() : IKSolver(10) {}
 
@@ -23,6 +23,16 @@ void IKSolver::setNodes(std::vector<std::shared_ptr<GltfNode>> nodes)
 	mFABRIKNodePositions.resize(mNodes.size());
 }
 
+const std::vector<std::shared_ptr<GltfNode>>& IKSolver::getNodes()
+{
+	return mNodes;
+}
+
+unsigned int IKSolver::getNumIterations()
+{
+	return mIterations;
+}
+
 std::shared_ptr<GltfNode> IKSolver::getIkChainRootNode()
 {
 	return mNodes.at(mNodes.size() - 1);
@@ -61,7 +71,7 @@ bool IKSolver::solveCCD(glm::vec3 target)
 			glm::quat currentRotation = node->getLocalRotation();
 
 			node->blendRotation(currentRotation * localRotation, 1.0f);
-			node->updateNodeAndChildMatrices();
+			updateChainMatrices(j);
 
 			if (glm::length(target - effector) < mThreshold)
 			{
@@ -137,6 +147,36 @@ void IKSolver::solveFABRIKBackward(glm::vec3 base)
 	}
 }
 
+void IKSolver::updatePathMatrices()
+{
+	if (mNodes.empty())
+	{
+		return;
+	}
+
+	std::vector<std::shared_ptr<GltfNode>> ancestors{};
+	for (std::shared_ptr<GltfNode> node = getIkChainRootNode()->getParentNode(); node; node = node->getParentNode())
+	{
+		ancestors.push_back(node);
+	}
+	for (auto iter = ancestors.rbegin(); iter != ancestors.rend(); ++iter)
+	{
+		(*iter)->calculateNodeMatrix();
+	}
+	updateChainMatrices(mNodes.size() - 1);
+}
+
+void IKSolver::updateChainMatrices(size_t nodeIndex)
+{
+	for (size_t i = nodeIndex + 1; i-- > 0;)
+	{
+		if (mNodes.at(i))
+		{
+			mNodes.at(i)->calculateNodeMatrix();
+		}
+	}
+}
+
 void IKSolver::calculateBoneLengths()
 {
 	mBoneLengths.resize(mNodes.size() - 1);
@@ -168,7 +208,7 @@ void IKSolver::adjustFABRIKNodes()
 		glm::quat currentRotation = node->getLocalRotation();
 		node->blendRotation(currentRotation * localRotation, 1.0f);
 
-		node->updateNodeAndChildMatrices();
+		updateChainMatrices(i);
 	}
 
 }
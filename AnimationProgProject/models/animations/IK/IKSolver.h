@@ -14,9 +14,19 @@ public :
 
 	void setNumIterations(unsigned int iterations);
 
+	// Chain from the effector to the root and the iterations, for the IKBatchSolver
+	const std::vector<std::shared_ptr<GltfNode>>& getNodes();
+	unsigned int getNumIterations();
+
+	// Both solvers only recalculate the matrices of the chain nodes, the subtree of the chain root still needs
+	// one hierarchy update afterwards
 	bool solveCCD(glm::vec3 target);
 	bool solveFABRIK(glm::vec3 target);
 
+	// Recalculates the matrices from the tree root down to the effector, for chains solved after other chains
+	// that moved nodes above or inside this one
+	void updatePathMatrices();
+
 private:
 	std::vector<std::shared_ptr<GltfNode>> mNodes{};
 	unsigned int mIterations = 0;
@@ -30,6 +40,9 @@ private:
 	void calculateBoneLengths();
 	void adjustFABRIKNodes();
 
+	// The node and the chain nodes below it, down to the effector
+	void updateChainMatrices(size_t nodeIndex);
+
 
 
 
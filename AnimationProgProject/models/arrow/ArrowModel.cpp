@@ -1,5 +1,5 @@
 #include "ArrowModel.h"
-#include "../../logger/Logger.h"
+#include "../../Logger/Logger.h"
 
 OGLMesh ArrowModel::getVertexData() {
     if (mVertexData.vertices.size() == 0) {
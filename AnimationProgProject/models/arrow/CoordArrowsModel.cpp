@@ -1,5 +1,5 @@
 #include "CoordArrowsModel.h"
-#include "../../logger/Logger.h"
+#include "../../Logger/Logger.h"
 
 OGLMesh CoordArrowsModel::getVertexData() {
     if (mVertexData.vertices.size() == 0) {
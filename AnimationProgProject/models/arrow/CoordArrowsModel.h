@@ -3,7 +3,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 
-#include "../../opengl/mainRenderer/OGLRenderData.h"
+#include "../../opengl/MainRenderer/OGLRenderData.h"
 
 class CoordArrowsModel {
 public:
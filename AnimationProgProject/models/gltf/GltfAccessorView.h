@@ -0,0 +1,181 @@
+/* typed view of a glTF accessor, reads the elements in place: follows the accessor offset and the byte stride
+   of interleaved buffer views and converts the components while reading them */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <tiny_gltf.h>
+#include "GltfBufferData.h"
+#include "../Logger/Logger.h"
+
+/* component type of glm vectors, quaternions and matrices, the type itself for scalars */
+template <typename T, typename = void>
+struct GltfAccessorScalar
+{
+    using type = T;
+};
+
+template <typename T>
+struct GltfAccessorScalar<T, std::void_t<typename T::value_type>>
+{
+    using type = typename T::value_type;
+};
+
+template <typename T>
+class GltfAccessorView
+{
+public:
+    using Scalar = typename GltfAccessorScalar<T>::type;
+    static constexpr int componentCount = static_cast<int>(sizeof(T) / sizeof(Scalar));
+
+    GltfAccessorView(const tinygltf::Model& model, GltfBufferData& bufferData, int accessorIndex)
+    {
+        const tinygltf::Accessor& accessor = model.accessors.at(accessorIndex);
+        mComponentType = accessor.componentType;
+        mComponentCount = tinygltf::GetNumComponentsInType(accessor.type);
+        mComponentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+        mNormalized = accessor.normalized;
+
+        if (mComponentCount <= 0 || mComponentSize <= 0)
+        {
+            Logger::log(0, "%s error: accessor %i has unknown type %i/%i\n", __FUNCTION__, accessorIndex,
+                accessor.type, accessor.componentType);
+            return;
+        }
+
+        /* accessors without a buffer view are all zero (sparse data is not supported) */
+        mCount = accessor.count;
+        if (accessor.bufferView < 0)
+        {
+            return;
+        }
+
+        const tinygltf::BufferView& bufferView = model.bufferViews.at(accessor.bufferView);
+        mStride = accessor.ByteStride(bufferView);
+        size_t elementSize = static_cast<size_t>(mComponentSize) * mComponentCount;
+        size_t lastByte = accessor.byteOffset + (mCount > 0 ? (mCount - 1) * mStride + elementSize : 0);
+        if (mStride <= 0 || lastByte > bufferView.byteLength ||
+            bufferView.byteOffset + bufferView.byteLength > bufferData.getSize(bufferView.buffer))
+        {
+            Logger::log(0, "%s error: accessor %i does not fit into buffer view %i\n", __FUNCTION__, accessorIndex,
+                accessor.bufferView);
+            mCount = 0;
+            return;
+        }
+
+        mData = bufferData.getData(bufferView) + accessor.byteOffset;
+    }
+
+    size_t size() const
+    {
+        return mCount;
+    }
+
+    /* the accessor stores tightly packed elements of exactly type T, they can be used without a copy */
+    bool isContiguous() const
+    {
+        return mData && mStride == static_cast<int>(sizeof(T)) && mComponentCount == componentCount &&
+            mComponentType == getComponentType() && (!mNormalized || std::is_integral_v<Scalar>) &&
+            reinterpret_cast<uintptr_t>(mData) % alignof(T) == 0;
+    }
+
+    /* elements in place, nullptr if the accessor needs a conversion or is interleaved */
+    const T* data() const
+    {
+        return isContiguous() ? reinterpret_cast<const T*>(mData) : nullptr;
+    }
+
+    /* missing components are 0, normalized integers become [0, 1] or [-1, 1] for float targets */
+    T operator[](size_t index) const
+    {
+        T element;
+        std::memset(&element, 0, sizeof(T));
+        if (!mData)
+        {
+            return element;
+        }
+
+        Scalar* components = reinterpret_cast<Scalar*>(&element);
+        const unsigned char* source = mData + index * mStride;
+        int count = std::min(componentCount, mComponentCount);
+        for (int i = 0; i < count; ++i)
+        {
+            components[i] = readComponent(source + i * mComponentSize);
+        }
+        return element;
+    }
+
+    /* one memcpy if the layout matches, a converting loop otherwise */
+    void copyTo(std::vector<T>& target) const
+    {
+        target.resize(mCount);
+        if (isContiguous())
+        {
+            std::memcpy(target.data(), mData, mCount * sizeof(T));
+            return;
+        }
+        for (size_t i = 0; i < mCount; ++i)
+        {
+            target[i] = (*this)[i];
+        }
+    }
+
+private:
+    const unsigned char* mData = nullptr;
+    size_t mCount = 0;
+    int mStride = 0;
+    int mComponentType = -1;
+    int mComponentCount = 0;
+    int mComponentSize = 0;
+    bool mNormalized = false;
+
+    static int getComponentType()
+    {
+        if (std::is_same_v<Scalar, float>) return TINYGLTF_COMPONENT_TYPE_FLOAT;
+        if (std::is_same_v<Scalar, int8_t>) return TINYGLTF_COMPONENT_TYPE_BYTE;
+        if (std::is_same_v<Scalar, uint8_t>) return TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        if (std::is_same_v<Scalar, int16_t>) return TINYGLTF_COMPONENT_TYPE_SHORT;
+        if (std::is_same_v<Scalar, uint16_t>) return TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+        if (std::is_same_v<Scalar, uint32_t>) return TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+        return -1;
+    }
+
+    template <typename C>
+    Scalar convertComponent(const unsigned char* source, float maxValue) const
+    {
+        C value;
+        std::memcpy(&value, source, sizeof(C));
+        if constexpr (std::is_floating_point_v<Scalar>)
+        {
+            if (mNormalized)
+            {
+                return static_cast<Scalar>(std::max(static_cast<float>(value) / maxValue, -1.0f));
+            }
+        }
+        return static_cast<Scalar>(value);
+    }
+
+    Scalar readComponent(const unsigned char* source) const
+    {
+        switch (mComponentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return convertComponent<float>(source, 1.0f);
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            return convertComponent<int8_t>(source, 127.0f);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return convertComponent<uint8_t>(source, 255.0f);
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            return convertComponent<int16_t>(source, 32767.0f);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return convertComponent<uint16_t>(source, 65535.0f);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return convertComponent<uint32_t>(source, 4294967295.0f);
+        default:
+            return Scalar(0);
+        }
+    }
+};
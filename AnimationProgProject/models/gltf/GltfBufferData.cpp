@@ -0,0 +1,35 @@
+#include "GltfBufferData.h"
+
+GltfBufferData::GltfBufferData(std::shared_ptr<tinygltf::Model> model) : mModel(model) {}
+
+GltfBufferData::GltfBufferData(std::shared_ptr<tinygltf::Model> model, std::shared_ptr<MappedFile> file,
+    int mappedBuffer, unsigned char* mappedData, size_t mappedSize) : mModel(model), mFile(file),
+    mMappedBuffer(mappedBuffer), mMappedData(mappedData), mMappedSize(mappedSize) {}
+
+unsigned char* GltfBufferData::getData(int bufferIndex)
+{
+    if (bufferIndex == mMappedBuffer)
+    {
+        return mMappedData;
+    }
+    return &mModel->buffers.at(bufferIndex).data.at(0);
+}
+
+unsigned char* GltfBufferData::getData(const tinygltf::BufferView& bufferView)
+{
+    return getData(bufferView.buffer) + bufferView.byteOffset;
+}
+
+size_t GltfBufferData::getSize(int bufferIndex)
+{
+    if (bufferIndex == mMappedBuffer)
+    {
+        return mMappedSize;
+    }
+    return mModel->buffers.at(bufferIndex).data.size();
+}
+
+bool GltfBufferData::isMapped()
+{
+    return mMappedBuffer >= 0;
+}
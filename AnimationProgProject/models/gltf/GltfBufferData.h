@@ -0,0 +1,31 @@
+/* raw bytes of the glTF buffers, either loaded by tinygltf or inside a memory mapped .glb file */
+#pragma once
+#include <memory>
+#include <cstddef>
+#include <tiny_gltf.h>
+#include <MappedFile.h>
+
+class GltfBufferData {
+public:
+    /* all buffers were loaded by tinygltf */
+    GltfBufferData(std::shared_ptr<tinygltf::Model> model);
+    /* the buffer with index mappedBuffer is the BIN chunk of the mapped file, tinygltf only holds a placeholder */
+    GltfBufferData(std::shared_ptr<tinygltf::Model> model, std::shared_ptr<MappedFile> file,
+        int mappedBuffer, unsigned char* mappedData, size_t mappedSize);
+
+    unsigned char* getData(int bufferIndex);
+    /* start of the buffer view, the accessor offset is not added */
+    unsigned char* getData(const tinygltf::BufferView& bufferView);
+    size_t getSize(int bufferIndex);
+
+    bool isMapped();
+
+private:
+    std::shared_ptr<tinygltf::Model> mModel = nullptr;
+
+    /* keeps the mapping alive as long as the data is used */
+    std::shared_ptr<MappedFile> mFile = nullptr;
+    int mMappedBuffer = -1;
+    unsigned char* mMappedData = nullptr;
+    size_t mMappedSize = 0;
+};
@@ -0,0 +1,96 @@
+/* binary layout of cooked models (.apmodel), written by the AssetCooker tool and mapped at runtime.
+   all offsets are relative to the start of the file, every section starts 16 byte aligned.
+   the file is little endian, the structs are read in place and must not change without a new version */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+static const uint32_t GltfCookedMagic = 0x444D5041; /* "APMD" */
+static const uint32_t GltfCookedVersion = 1;
+static const size_t GltfCookedAlignment = 16;
+
+enum class GltfCookedSectionType : uint32_t
+{
+    NODES = 0,      /* GltfCookedNode per node */
+    CHILDREN,       /* int32_t, child node numbers, referenced by GltfCookedNode::firstChild */
+    NAMES,          /* zero terminated node and clip names */
+    SKIN_JOINTS,    /* int32_t node number per joint */
+    INVERSE_BINDS,  /* glm::mat4 per joint */
+    VERTICES,       /* GltfPackedVertex per vertex, uploaded as is */
+    INDICES,        /* uint32_t, all LOD levels back to back */
+    LODS,           /* GltfCookedLod per level, level 0 is the full mesh */
+    CLIPS,          /* GltfCookedClip per animation clip */
+    CHANNELS,       /* GltfCookedChannel, the channels of a clip are stored in a row */
+    KEYS,           /* float keyframe times and values of all channels */
+    TEXTURE,        /* RGBA8 pixels of the base color texture, mip level 0 */
+    COUNT
+};
+
+struct GltfCookedSection
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct GltfCookedHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+
+    int32_t rootNode;
+    uint32_t nodeCount;
+    uint32_t jointCount;
+    uint32_t vertexCount;
+    uint32_t lodCount;
+    uint32_t clipCount;
+    uint32_t textureWidth;
+    uint32_t textureHeight;
+
+    float boundingSphere[4];
+    /* vertex cache stats of the optimizer, ACMR and ATVR before and after */
+    float meshStats[4];
+
+    GltfCookedSection sections[static_cast<size_t>(GltfCookedSectionType::COUNT)];
+};
+
+/* local transform is always set, defaults are written for missing values */
+struct GltfCookedNode
+{
+    float translation[3];
+    float rotation[4];  /* x, y, z, w like glTF */
+    float scale[3];
+    int32_t skin;       /* -1 for skeleton nodes */
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t nameOffset;
+};
+
+struct GltfCookedLod
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;
+    uint32_t padding;
+};
+
+struct GltfCookedClip
+{
+    uint32_t nameOffset;
+    uint32_t firstChannel;
+    uint32_t channelCount;
+    uint32_t padding;
+};
+
+/* keyframe data offsets are in floats from the start of the KEYS section */
+struct GltfCookedChannel
+{
+    int32_t targetNode;
+    uint32_t targetPath;     /* ETargetPath */
+    uint32_t interpolation;  /* EInterpolationType */
+    uint32_t keyCount;
+    uint32_t timeOffset;
+    uint32_t valueOffset;
+    uint32_t valueCount;     /* in floats, 3x the keys for CUBICSPLINE */
+    uint32_t padding;
+};
@@ -1,11 +1,12 @@
 #include <chrono>
+#include <algorithm>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtx/dual_quaternion.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include <cstdlib> 
 #include "GltfInstance.h"
-#include "../logger/Logger.h"
+#include "../Logger/Logger.h"
 
 GltfInstance::~GltfInstance() 
 {
@@ -29,6 +30,7 @@ GltfInstance::GltfInstance(std::shared_ptr<GltfModel> model, glm::vec2 worldPos,
 
     mInverseBindMatrices = mGltfModel->getInverseBindMatrices();
     mNodeToJoint = mGltfModel->getNodeToJoint();
+    mNextNodeJoint = mGltfModel->getNextNodeJoints();
 
     mJointMatrices.resize(mInverseBindMatrices.size());
     mJointDualQuats.resize(mInverseBindMatrices.size());
@@ -67,6 +69,7 @@ GltfInstance::GltfInstance(std::shared_ptr<GltfModel> model, glm::vec2 worldPos,
     // mRootNode->printTree();
 
     mAnimClips = mGltfModel->getAnimClips();
+    mClipCursors.resize(mAnimClips.size());
     for (const auto& clip : mAnimClips) 
     {
         mModelSettings.msClipNames.push_back(clip->getClipName());
@@ -89,17 +92,9 @@ GltfInstance::GltfInstance(std::shared_ptr<GltfModel> model, glm::vec2 worldPos,
     /* update initial clips etc */
     checkForUpdates();
 
-    /* get Skeleton data */
-    mSkeletonMesh = std::make_shared<OGLMesh>();
-    mSkeletonMesh->vertices.resize(mNodeCount * 2);
-
     /* set values for inverse kinematics */
-    mModelSettings.msIkEffectorNode = 19;
-    mModelSettings.msIkRootNode = 26;
-    setInverseKinematicsNodes(mModelSettings.msIkEffectorNode, mModelSettings.msIkRootNode);
-    setNumIKIterations(mModelSettings.msIkIterations);
-
-    mModelSettings.msIkTargetWorldPos = getWorldRotation() * mModelSettings.msIkTargetPos + glm::vec3(worldPos.x, 0.0f, worldPos.y);
+    addDefaultIKChains();
+    updateIKChains();
 }
 
 void GltfInstance::resetNodeData() 
@@ -113,39 +108,6 @@ std::shared_ptr<GltfModel> GltfInstance::getModel()
     return mGltfModel;
 }
 
-std::shared_ptr<OGLMesh> GltfInstance::getSkeleton() 
-{
-    mSkeletonMesh->vertices.clear();
-
-    /* start from Armature child */
-    getSkeletonPerNode(mRootNode->getChilds().at(0));
-    return mSkeletonMesh;
-}
-
-void GltfInstance::getSkeletonPerNode(std::shared_ptr<GltfNode> treeNode)
-{
-    glm::vec3 parentPos = glm::vec3(0.0f);
-    parentPos = glm::vec3(treeNode->getNodeMatrix() * glm::vec4(1.0f));
-
-    OGLVertex parentVertex;
-    parentVertex.position = parentPos;
-    parentVertex.color = glm::vec3(0.0f, 1.0f, 1.0f);
-
-    for (const auto& childNode : treeNode->getChilds())
-    {
-        glm::vec3 childPos = glm::vec3(0.0f);
-        childPos = glm::vec3(childNode->getNodeMatrix() * glm::vec4(1.0f));
-
-        OGLVertex childVertex;
-        childVertex.position = childPos;
-        childVertex.color = glm::vec3(0.0f, 0.0f, 1.0f);
-        mSkeletonMesh->vertices.emplace_back(parentVertex);
-        mSkeletonMesh->vertices.emplace_back(childVertex);
-
-        getSkeletonPerNode(childNode);
-    }
-}
-
 void GltfInstance::updateNodeMatrices(std::shared_ptr<GltfNode> treeNode)
 {
     treeNode->calculateNodeMatrix();
@@ -164,32 +126,34 @@ void GltfInstance::updateNodeMatrices(std::shared_ptr<GltfNode> treeNode)
 
 void GltfInstance::updateJointMatrices(std::shared_ptr<GltfNode> treeNode) 
 {
+    /* a node in several skins with different bind poses has one palette entry per bind pose */
     int nodeNum = treeNode->getNodeNum();
-    mJointMatrices.at(mNodeToJoint.at(nodeNum)) =
-        treeNode->getNodeMatrix() * mInverseBindMatrices.at(mNodeToJoint.at(nodeNum));
+    for (int joint = mNodeToJoint.at(nodeNum); joint >= 0; joint = mNextNodeJoint.at(joint)) {
+        mJointMatrices.at(joint) = treeNode->getNodeMatrix() * mInverseBindMatrices.at(joint);
+    }
 }
 
 void GltfInstance::updateJointDualQuats(std::shared_ptr<GltfNode> treeNode) 
 {
     int nodeNum = treeNode->getNodeNum();
-
-    glm::quat orientation;
-    glm::vec3 scale;
-    glm::vec3 translation;
-    glm::vec3 skew;
-    glm::vec4 perspective;
-    glm::dualquat dq;
-
-    /* extract components from updated node matrix and create dual quaternion */
-    glm::mat4 nodeJointMat = treeNode->getNodeMatrix() *
-        mInverseBindMatrices.at(mNodeToJoint.at(nodeNum));
-    if (glm::decompose(nodeJointMat, scale, orientation, translation, skew, perspective)) {
-        dq[0] = orientation;
-        dq[1] = glm::quat(0.0, translation.x, translation.y, translation.z) * orientation * 0.5f;
-        mJointDualQuats.at(mNodeToJoint.at(nodeNum)) = glm::mat2x4_cast(dq);
-    }
-    else {
-        Logger::log(1, "%s error: could not decompose matrix for node %i\n", __FUNCTION__,  nodeNum);
+    for (int joint = mNodeToJoint.at(nodeNum); joint >= 0; joint = mNextNodeJoint.at(joint)) {
+        glm::quat orientation;
+        glm::vec3 scale;
+        glm::vec3 translation;
+        glm::vec3 skew;
+        glm::vec4 perspective;
+        glm::dualquat dq;
+
+        /* extract components from updated node matrix and create dual quaternion */
+        glm::mat4 nodeJointMat = treeNode->getNodeMatrix() * mInverseBindMatrices.at(joint);
+        if (glm::decompose(nodeJointMat, scale, orientation, translation, skew, perspective)) {
+            dq[0] = orientation;
+            dq[1] = glm::quat(0.0, translation.x, translation.y, translation.z) * orientation * 0.5f;
+            mJointDualQuats.at(joint) = glm::mat2x4_cast(dq);
+        }
+        else {
+            Logger::log(1, "%s error: could not decompose matrix for node %i\n", __FUNCTION__,  nodeNum);
+        }
     }
 }
 
@@ -219,11 +183,6 @@ void GltfInstance::checkForUpdates()
     static int skelSplitNode = mModelSettings.msSkelSplitNode;
     static glm::vec2 worldPos = mModelSettings.msWorldPosition;
     static glm::vec3 worldRot = mModelSettings.msWorldRotation;
-    static glm::vec3 ikTargetPos = mModelSettings.msIkTargetPos;
-    static ikMode lastIkMode = mModelSettings.msIkMode;
-    static int numIKIterations = mModelSettings.msIkIterations;
-    static int ikEffectorNode = mModelSettings.msIkEffectorNode;
-    static int ikRootNode = mModelSettings.msIkRootNode;
 
     if (skelSplitNode != mModelSettings.msSkelSplitNode) {
         setSkeletonSplitNode(mModelSettings.msSkelSplitNode);
@@ -243,41 +202,192 @@ void GltfInstance::checkForUpdates()
         mRootNode->setWorldPosition(glm::vec3(mModelSettings.msWorldPosition.x, 0.0f,
             mModelSettings.msWorldPosition.y));
         worldPos = mModelSettings.msWorldPosition;
-        mModelSettings.msIkTargetWorldPos = getWorldRotation() *
-            mModelSettings.msIkTargetPos + glm::vec3(worldPos.x, 0.0f, worldPos.y);
+        updateIKTargets();
     }
 
     if (worldRot != mModelSettings.msWorldRotation) {
         mRootNode->setWorldRotation(mModelSettings.msWorldRotation);
         worldRot = mModelSettings.msWorldRotation;
-        mModelSettings.msIkTargetWorldPos = getWorldRotation() *
-            mModelSettings.msIkTargetPos + glm::vec3(worldPos.x, 0.0f, worldPos.y);
+        updateIKTargets();
     }
 
-    if (ikTargetPos != mModelSettings.msIkTargetPos) {
-        ikTargetPos = mModelSettings.msIkTargetPos;
-        mModelSettings.msIkTargetWorldPos = getWorldRotation() *
-            mModelSettings.msIkTargetPos + glm::vec3(worldPos.x, 0.0f, worldPos.y);
+    updateIKChains();
+}
+
+void GltfInstance::addDefaultIKChains()
+{
+    /* hands, feet and head of the usual humanoid skeletons, the right arm chain comes first */
+    const std::vector<std::pair<std::string, std::string>> defaultChains = {
+        { "RightHandIndex4", "RightShoulder" },
+        { "LeftHandIndex4", "LeftShoulder" },
+        { "RightToe_End", "RightUpLeg" },
+        { "LeftToe_End", "LeftUpLeg" },
+        { "HeadTop_End", "Neck" }
+    };
+
+    /* node names may have a prefix like "mixamorig:" */
+    auto findNode = [this](const std::string& name) {
+        for (const auto& node : mNodeList) {
+            if (!node) {
+                continue;
+            }
+            std::string nodeName = node->getNodeName();
+            if (nodeName.size() >= name.size() &&
+                nodeName.compare(nodeName.size() - name.size(), name.size(), name) == 0) {
+                return node;
+            }
+        }
+        return std::shared_ptr<GltfNode>();
+    };
+
+    mModelSettings.msIkChains.clear();
+    for (const auto& defaultChain : defaultChains) {
+        std::shared_ptr<GltfNode> effectorNode = findNode(defaultChain.first);
+        std::shared_ptr<GltfNode> rootNode = findNode(defaultChain.second);
+        if (!effectorNode || !rootNode || !isIKNodeBelow(effectorNode, rootNode)) {
+            continue;
+        }
+
+        IKChainSettings chain{};
+        chain.effectorNode = effectorNode->getNodeNum();
+        chain.rootNode = rootNode->getNodeNum();
+        mModelSettings.msIkChains.push_back(chain);
     }
 
-    if (lastIkMode != mModelSettings.msIkMode) {
-        resetNodeData();
-        lastIkMode = mModelSettings.msIkMode;
+    /* unknown skeleton, the chain can be set up in the UI */
+    if (mModelSettings.msIkChains.empty()) {
+        mModelSettings.msIkChains.emplace_back();
     }
+    mModelSettings.msIkSelectedChain = 0;
 
-    if (numIKIterations != mModelSettings.msIkIterations) {
-        setNumIKIterations(mModelSettings.msIkIterations);
-        resetNodeData();
-        numIKIterations = mModelSettings.msIkIterations;
+    Logger::log(2, "%s: added %i IK chains\n", __FUNCTION__, static_cast<int>(mModelSettings.msIkChains.size()));
+}
+
+void GltfInstance::updateIKChains()
+{
+    std::vector<IKChainSettings>& chains = mModelSettings.msIkChains;
+    bool chainsChanged = chains.size() != mAppliedIkChains.size();
+    bool resetNodes = chains.size() < mAppliedIkChains.size();
+    bool targetsChanged = false;
+
+    mIKSolvers.resize(chains.size());
+    for (int i = 0; i < chains.size(); ++i) {
+        const IKChainSettings& chain = chains.at(i);
+
+        /* new chains only need their nodes, there is no solved pose to undo yet */
+        if (i >= mAppliedIkChains.size()) {
+            setInverseKinematicsNodes(i, chain.effectorNode, chain.rootNode);
+            setNumIKIterations(i, chain.iterations);
+            targetsChanged = true;
+            continue;
+        }
+
+        const IKChainSettings& appliedChain = mAppliedIkChains.at(i);
+        if (appliedChain.mode != chain.mode) {
+            chainsChanged = true;
+            resetNodes = true;
+        }
+
+        if (appliedChain.iterations != chain.iterations) {
+            setNumIKIterations(i, chain.iterations);
+            resetNodes = true;
+        }
+
+        if (appliedChain.effectorNode != chain.effectorNode ||
+            appliedChain.rootNode != chain.rootNode) {
+            setInverseKinematicsNodes(i, chain.effectorNode, chain.rootNode);
+            chainsChanged = true;
+            resetNodes = true;
+        }
+
+        if (appliedChain.targetPos != chain.targetPos) {
+            targetsChanged = true;
+        }
     }
 
-    if (ikEffectorNode != mModelSettings.msIkEffectorNode ||
-        ikRootNode != mModelSettings.msIkRootNode) {
-        setInverseKinematicsNodes(mModelSettings.msIkEffectorNode, mModelSettings.msIkRootNode);
+    if (targetsChanged) {
+        updateIKTargets();
+    }
+    if (resetNodes) {
         resetNodeData();
-        ikEffectorNode = mModelSettings.msIkEffectorNode;
-        ikRootNode = mModelSettings.msIkRootNode;
     }
+    if (chainsChanged) {
+        scheduleIKChains();
+    }
+
+    /* the fields were compared in place, the chains are only copied after a change */
+    if (chainsChanged || resetNodes || targetsChanged) {
+        mAppliedIkChains = chains;
+    }
+    mModelSettings.msIkSelectedChain = std::clamp(mModelSettings.msIkSelectedChain, 0,
+        std::max(static_cast<int>(chains.size()) - 1, 0));
+}
+
+void GltfInstance::updateIKTargets()
+{
+    glm::vec3 worldPos = glm::vec3(mModelSettings.msWorldPosition.x, 0.0f, mModelSettings.msWorldPosition.y);
+    for (auto& chain : mModelSettings.msIkChains) {
+        chain.targetWorldPos = getWorldRotation() * chain.targetPos + worldPos;
+    }
+}
+
+void GltfInstance::scheduleIKChains()
+{
+    mIKSchedule.clear();
+    mIKUpdateRoots.clear();
+    mIKChainsBatchable = true;
+
+    /* the depth of the chain root decides the order, parents are solved before their children */
+    std::vector<std::pair<int, int>> chainDepths{};
+    for (int i = 0; i < mModelSettings.msIkChains.size(); ++i) {
+        if (mModelSettings.msIkChains.at(i).mode == ikMode::off || mIKSolvers.at(i).getNodes().size() < 2) {
+            continue;
+        }
+
+        int depth = 0;
+        for (std::shared_ptr<GltfNode> node = mIKSolvers.at(i).getIkChainRootNode()->getParentNode();
+            node; node = node->getParentNode()) {
+            ++depth;
+        }
+        chainDepths.emplace_back(depth, i);
+    }
+    std::stable_sort(chainDepths.begin(), chainDepths.end(),
+        [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+
+    for (const auto& chainDepth : chainDepths) {
+        int chainNum = chainDepth.second;
+        std::shared_ptr<GltfNode> chainRoot = mIKSolvers.at(chainNum).getIkChainRootNode();
+
+        /* a chain inside the subtree of an earlier chain is moved by it, and the joints of the
+           subtree are updated together with the earlier chain */
+        IKChainStep step{};
+        step.chainNum = chainNum;
+        for (const auto& updateRoot : mIKUpdateRoots) {
+            if (isIKNodeBelow(chainRoot, updateRoot)) {
+                step.updatePath = true;
+                break;
+            }
+        }
+        if (!step.updatePath) {
+            mIKUpdateRoots.push_back(chainRoot);
+        }
+        mIKSchedule.push_back(step);
+
+        /* the batch solver reads all chains before moving any of them */
+        if (step.updatePath || mModelSettings.msIkChains.at(chainNum).mode != ikMode::fabrik) {
+            mIKChainsBatchable = false;
+        }
+    }
+}
+
+bool GltfInstance::isIKNodeBelow(std::shared_ptr<GltfNode> node, std::shared_ptr<GltfNode> ancestor)
+{
+    for (; node; node = node->getParentNode()) {
+        if (node == ancestor) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void GltfInstance::updateAnimation()
@@ -307,19 +417,36 @@ void GltfInstance::updateAnimation()
     }
 }
 
-void GltfInstance::solveIK() 
+unsigned int GltfInstance::solveIK() 
 {
-    switch (mModelSettings.msIkMode) 
+    /* the solvers only recalculate the chain nodes, the joints below are updated once per subtree */
+    for (const auto& step : mIKSchedule)
     {
-    case ikMode::ccd:
-        solveIKByCCD(mModelSettings.msIkTargetWorldPos);
-        break;
-    case ikMode::fabrik:
-        solveIKByFABRIK(mModelSettings.msIkTargetWorldPos);
-        break;
-    default:
-        break;
+        IKSolver& solver = mIKSolvers.at(step.chainNum);
+        const IKChainSettings& chain = mModelSettings.msIkChains.at(step.chainNum);
+        if (step.updatePath)
+        {
+            solver.updatePathMatrices();
+        }
+
+        switch (chain.mode)
+        {
+        case ikMode::ccd:
+            solver.solveCCD(chain.targetWorldPos);
+            break;
+        case ikMode::fabrik:
+            solver.solveFABRIK(chain.targetWorldPos);
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (const auto& updateRoot : mIKUpdateRoots)
+    {
+        updateNodeMatrices(updateRoot);
     }
+    return static_cast<unsigned int>(mIKSchedule.size());
 }
 
 void GltfInstance::playAnimation(int animNum, float speedDivider, float blendFactor, replayDirection direction) 
@@ -351,7 +478,8 @@ void GltfInstance::playAnimation(int sourceAnimNumber, int destAnimNumber,float
 
 void GltfInstance::blendAnimationFrame(int animNum, float time, float blendFactor) 
 {
-    mAnimClips.at(animNum)->blendAnimationFrame(mNodeList, mAdditiveAnimationMask, time,  blendFactor);
+    mAnimClips.at(animNum)->blendAnimationFrame(mNodeList, mAdditiveAnimationMask, time,  blendFactor,
+        &mClipCursors.at(animNum));
     updateNodeMatrices(mRootNode);
 }
 
@@ -363,11 +491,14 @@ void GltfInstance::crossBlendAnimationFrame(int sourceAnimNumber, int destAnimNu
 
     float scaledTime = time * (destAnimDuration / sourceAnimDuration);
 
-    mAnimClips.at(sourceAnimNumber)->setAnimationFrame(mNodeList, mAdditiveAnimationMask, time);
-    mAnimClips.at(destAnimNumber)->blendAnimationFrame(mNodeList, mAdditiveAnimationMask, scaledTime, blendFactor);
+    GltfClipCursor* sourceCursor = &mClipCursors.at(sourceAnimNumber);
+    GltfClipCursor* destCursor = &mClipCursors.at(destAnimNumber);
+
+    mAnimClips.at(sourceAnimNumber)->setAnimationFrame(mNodeList, mAdditiveAnimationMask, time, sourceCursor);
+    mAnimClips.at(destAnimNumber)->blendAnimationFrame(mNodeList, mAdditiveAnimationMask, scaledTime, blendFactor, destCursor);
 
-    mAnimClips.at(destAnimNumber)->setAnimationFrame(mNodeList, mInvertedAdditiveAnimationMask, scaledTime);
-    mAnimClips.at(sourceAnimNumber)->blendAnimationFrame(mNodeList, mInvertedAdditiveAnimationMask, time, blendFactor);
+    mAnimClips.at(destAnimNumber)->setAnimationFrame(mNodeList, mInvertedAdditiveAnimationMask, scaledTime, destCursor);
+    mAnimClips.at(sourceAnimNumber)->blendAnimationFrame(mNodeList, mInvertedAdditiveAnimationMask, time, blendFactor, sourceCursor);
 
     updateNodeMatrices(mRootNode);
 }
@@ -422,8 +553,14 @@ float GltfInstance::getAnimationEndTime(int animNum)
     return mAnimClips.at(animNum)->getClipEndTime();
 }
 
-void GltfInstance::setInverseKinematicsNodes(int effectorNodeNum, int ikChainRootNodeNum) 
+void GltfInstance::setInverseKinematicsNodes(int chainNum, int effectorNodeNum, int ikChainRootNodeNum) 
 {
+    if (chainNum < 0 || chainNum >= mIKSolvers.size())
+    {
+        Logger::log(1, "%s error: IK chain %i is out of range\n", __FUNCTION__, chainNum);
+        return;
+    }
+
     if (effectorNodeNum < 0 || effectorNodeNum >(mNodeList.size() - 1)) 
     {
         Logger::log(1, "%s error: effector node %i is out of range\n", __FUNCTION__, effectorNodeNum);
@@ -459,22 +596,39 @@ void GltfInstance::setInverseKinematicsNodes(int effectorNodeNum, int ikChainRoo
         }
     }
 
-    mIKSolver.setNodes(ikNodes);
+    mIKSolvers.at(chainNum).setNodes(ikNodes);
 }
 
-void GltfInstance::setNumIKIterations(int iterations)
+void GltfInstance::setNumIKIterations(int chainNum, int iterations)
 {
-    mIKSolver.setNumIterations(iterations);
+    if (chainNum < 0 || chainNum >= mIKSolvers.size())
+    {
+        Logger::log(1, "%s error: IK chain %i is out of range\n", __FUNCTION__, chainNum);
+        return;
+    }
+    mIKSolvers.at(chainNum).setNumIterations(iterations);
 }
 
-void GltfInstance::solveIKByCCD(glm::vec3 target) 
+bool GltfInstance::addIKChains(IKBatchSolver& solver)
 {
-    mIKSolver.solveCCD(target);
-    updateNodeMatrices(mIKSolver.getIkChainRootNode());
+    if (mIKSchedule.empty() || !mIKChainsBatchable)
+    {
+        return false;
+    }
+
+    for (const auto& step : mIKSchedule)
+    {
+        IKSolver& ikSolver = mIKSolvers.at(step.chainNum);
+        solver.addChain(ikSolver.getNodes(), mModelSettings.msIkChains.at(step.chainNum).targetWorldPos,
+            ikSolver.getNumIterations());
+    }
+    return true;
 }
 
-void GltfInstance::solveIKByFABRIK(glm::vec3 target) 
+void GltfInstance::finishBatchedIK()
 {
-    mIKSolver.solveFABRIK(target);
-    updateNodeMatrices(mIKSolver.getIkChainRootNode());
+    for (const auto& updateRoot : mIKUpdateRoots)
+    {
+        updateNodeMatrices(updateRoot);
+    }
 }
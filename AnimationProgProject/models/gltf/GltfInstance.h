@@ -11,6 +11,7 @@
 
 #include "../ModelSettings.h"
 #include "../animations/IK/IKSolver.h"
+#include "../animations/IK/IKBatchSolver.h"
 
 class GltfInstance {
 public:
@@ -21,7 +22,6 @@ public:
 
     std::shared_ptr<GltfModel> getModel();
 
-    std::shared_ptr<OGLMesh> getSkeleton();
     void setSkeletonSplitNode(int nodeNum);
 
     int getJointMatrixSize();
@@ -38,9 +38,15 @@ public:
     glm::vec2 getWorldPosition();
     glm::quat getWorldRotation();
 
-    void solveIK();
-    void setInverseKinematicsNodes(int effectorNodeNum, int ikChainRootNodeNum);
-    void setNumIKIterations(int iterations);
+    /* solves all active chains in one pass, returns the number of solved chains */
+    unsigned int solveIK();
+    void setInverseKinematicsNodes(int chainNum, int effectorNodeNum, int ikChainRootNodeNum);
+    void setNumIKIterations(int chainNum, int iterations);
+
+    /* FABRIK chains of all instances are solved together, finishBatchedIK updates the joints afterwards.
+       Instances with CCD chains or chains below other chains return false and need solveIK */
+    bool addIKChains(IKBatchSolver& solver);
+    void finishBatchedIK();
 
 private:
     void playAnimation(int animNum, float speedDivider, float blendFactor,
@@ -54,7 +60,6 @@ private:
 
     float getAnimationEndTime(int animNum);
 
-    void getSkeletonPerNode(std::shared_ptr<GltfNode> treeNode);
     void updateNodeMatrices(std::shared_ptr<GltfNode> treeNode);
     void updateJointMatrices(std::shared_ptr<GltfNode> treeNode);
     void updateJointDualQuats(std::shared_ptr<GltfNode> treeNode);
@@ -68,20 +73,38 @@ private:
     std::vector<std::shared_ptr<GltfNode>> mNodeList{};
 
     std::vector<std::shared_ptr<GltfAnimationClip>> mAnimClips{};
+    /* window of every streamed clip this instance samples, the clips are shared by all instances */
+    std::vector<GltfClipCursor> mClipCursors{};
     std::vector<glm::mat4> mInverseBindMatrices{};
     std::vector<glm::mat4> mJointMatrices{};
     std::vector<glm::mat2x4> mJointDualQuats{};
 
     std::vector<int> mNodeToJoint{};
+    std::vector<int> mNextNodeJoint{};
 
     std::vector<bool> mAdditiveAnimationMask{};
     std::vector<bool> mInvertedAdditiveAnimationMask{};
 
-    std::shared_ptr<OGLMesh> mSkeletonMesh = nullptr;
-
     ModelSettings mModelSettings{};
 
-    IKSolver mIKSolver{};
-    void solveIKByCCD(glm::vec3 target);
-    void solveIKByFABRIK(glm::vec3 target);
+    /* one solver per entry of msIkChains, the applied chains are used to find changed settings */
+    std::vector<IKSolver> mIKSolvers{};
+    std::vector<IKChainSettings> mAppliedIkChains{};
+
+    /* active chains with the chain roots closest to the tree root first, chains below an already
+       solved chain need the matrices of their path recalculated before they are solved */
+    struct IKChainStep {
+        int chainNum = 0;
+        bool updatePath = false;
+    };
+    std::vector<IKChainStep> mIKSchedule{};
+    /* top-most chain roots, every subtree is updated once after all chains are solved */
+    std::vector<std::shared_ptr<GltfNode>> mIKUpdateRoots{};
+    bool mIKChainsBatchable = false;
+
+    void addDefaultIKChains();
+    void updateIKChains();
+    void updateIKTargets();
+    void scheduleIKChains();
+    bool isIKNodeBelow(std::shared_ptr<GltfNode> node, std::shared_ptr<GltfNode> ancestor);
 };
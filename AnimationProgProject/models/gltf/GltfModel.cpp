@@ -1,170 +1,1612 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <type_traits>
+#include <json.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/dual_quaternion.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include "GltfModel.h"
-#include "../logger/Logger.h"
+#include "GltfAccessorView.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "../Logger/Logger.h"
+#include "../timer/Timer.h"
+#include <stateCache/OGLStateCache.h>
+#include <ProcessMemory.h>
+#include <stb_image.h>
+
+/* octahedral mapping of a unit vector, stored as two snorm16 values */
+static glm::tvec2<int16_t> packOctNormal(glm::vec3 normal)
+{
+    float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (sum == 0.0f)
+    {
+        return glm::tvec2<int16_t>(0, 0);
+    }
+
+    float x = normal.x / sum;
+    float y = normal.y / sum;
+    if (normal.z < 0.0f)
+    {
+        float foldX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldX;
+        y = foldY;
+    }
+
+    return glm::tvec2<int16_t>(
+        static_cast<int16_t>(std::round(std::clamp(x, -1.0f, 1.0f) * 32767.0f)),
+        static_cast<int16_t>(std::round(std::clamp(y, -1.0f, 1.0f) * 32767.0f)));
+}
+
+/* unorm8 weights, rounding error goes to the biggest weight so the sum stays at 255 */
+static glm::tvec4<uint8_t> packWeights(glm::vec4 weights)
+{
+    int quantized[4];
+    int sum = 0;
+    int biggest = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        quantized[i] = static_cast<int>(std::round(std::clamp(weights[i], 0.0f, 1.0f) * 255.0f));
+        sum += quantized[i];
+        if (quantized[i] > quantized[biggest])
+        {
+            biggest = i;
+        }
+    }
+    quantized[biggest] = std::clamp(quantized[biggest] + 255 - sum, 0, 255);
+
+    return glm::tvec4<uint8_t>(quantized[0], quantized[1], quantized[2], quantized[3]);
+}
 
 bool GltfModel::loadModel(OGLRenderData& renderData, std::string modelFilename, std::string textureFilename) 
 {
-    if (!mTex.loadTexture(textureFilename, false))
+    if (!prepareModel(renderData, modelFilename, textureFilename))
+    {
+        return false;
+    }
+
+    createModelBuffers();
+    uploadModelData(0);
+
+    renderData.rdGltfVertexBytes = mVertexDataSize;
+    renderData.rdGltfUnpackedVertexBytes = mUnpackedVertexDataSize;
+    return true;
+}
+
+bool GltfModel::prepareModel(OGLRenderData& renderData, std::string modelFilename, std::string textureFilename,
+    ThreadPool* threadPool)
+{
+    Timer loadTimer{};
+    loadTimer.start();
+    mResidentMinimal = renderData.rdResidentMinimal;
+    mLazyClips = renderData.rdLazyClips;
+    size_t peakRssBefore = ProcessMemory::getPeakResidentBytes();
+
+    /* cooked models contain the texture */
+    bool cooked = isCookedModel(modelFilename);
+    if (cooked)
+    {
+        if (!mapCookedModel(renderData, modelFilename))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        /* texture decode and mip levels run next to the import, the pool runs the job inline without workers */
+        mTextureData.resize(1);
+        std::future<bool> textureJob{};
+        if (threadPool)
+        {
+            textureJob = threadPool->submit([this, textureFilename, threadPool]() {
+                return Texture::prepareTexture(textureFilename, mTextureData.at(0), false, threadPool);
+            });
+        }
+
+        bool imported = importModel(renderData, modelFilename, threadPool);
+        bool textureLoaded = threadPool ? threadPool->wait(textureJob) :
+            Texture::prepareTexture(textureFilename, mTextureData.at(0), false);
+        if (!textureLoaded)
+        {
+            Logger::log(1, "%s: texture loading failed\n", __FUNCTION__);
+            return false;
+        }
+        Logger::log(1, "%s: glTF model texture '%s' successfully loaded\n", __FUNCTION__, textureFilename.c_str());
+
+        if (!imported)
+        {
+            return false;
+        }
+
+        /* the images of the other materials are known after the import */
+        mTextureData.resize(mTextureFiles.size());
+        for (size_t i = 1; i < mTextureFiles.size(); ++i)
+        {
+            if (!Texture::prepareTexture(mTextureFiles.at(i), mTextureData.at(i), false, threadPool))
+            {
+                Logger::log(1, "%s: material texture '%s' could not be loaded\n", __FUNCTION__, mTextureFiles.at(i).c_str());
+                return false;
+            }
+        }
+    }
+
+    /* glTF: texture decode and import, cooked: mapping only, the vertex, index and texture uploads happen later */
+    renderData.rdModelLoadTime = loadTimer.stop();
+    renderData.rdModelCooked = cooked;
+    renderData.rdModelMapped = cooked || mBufferData->isMapped();
+    size_t peakRssAfter = ProcessMemory::getPeakResidentBytes();
+    renderData.rdModelLoadPeakRss = peakRssAfter > peakRssBefore ? peakRssAfter - peakRssBefore : 0;
+    Logger::log(0, "%s: '%s' loaded in %.2f ms (%s), peak resident memory grew by %.1f KB\n", __FUNCTION__,
+        modelFilename.c_str(), renderData.rdModelLoadTime, cooked ? "cooked" : (renderData.rdModelMapped ? "mapped" : "copied"),
+        renderData.rdModelLoadPeakRss / 1024.0f);
+
+    if (renderData.rdBakeAnimations)
+    {
+        bakeAnimations(renderData);
+    }
+
+    /* after baking, which samples every clip completely: large clips keep only a few windows resident.
+       the copied buffers of an ASCII glTF stay in memory with the tinygltf model, windows would only add to them */
+    if (!renderData.rdModelMapped)
+    {
+        Logger::log(1, "%s: buffers of '%s' are not mapped, the clips stay resident\n", __FUNCTION__, modelFilename.c_str());
+        return true;
+    }
+
+    GltfClipStreaming streaming{};
+    streaming.threadPool = threadPool;
+    streaming.minBytes = static_cast<size_t>(std::max(renderData.rdStreamClipKB, 0)) * 1024;
+    streaming.windowTime = renderData.rdStreamWindowTime;
+    streaming.maxWindows = renderData.rdStreamWindows;
+    streaming.source = cooked ? std::static_pointer_cast<void>(mCookedFile) : std::static_pointer_cast<void>(mBufferData);
+    for (auto& clip : mAnimClips)
+    {
+        clip->setStreaming(streaming);
+    }
+
+    return true;
+}
+
+bool GltfModel::importModel(OGLRenderData& renderData, std::string modelFilename, ThreadPool* threadPool)
+{
+    mModel = std::make_shared<tinygltf::Model>();
+
+    tinygltf::TinyGLTF gltfLoader;
+    std::string loaderErrors;
+    std::string loaderWarnings;
+    bool result = false;
+
+    std::string extension = std::filesystem::path(modelFilename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension.compare(".glb") == 0)
+    {
+        result = loadBinaryModel(gltfLoader, modelFilename, loaderErrors, loaderWarnings);
+    }
+    else
+    {
+        result = gltfLoader.LoadASCIIFromFile(mModel.get(), &loaderErrors, &loaderWarnings, modelFilename);
+        mBufferData = std::make_shared<GltfBufferData>(mModel);
+    }
+
+    if (!loaderWarnings.empty()) {
+        Logger::log(1, "%s: warnings while loading glTF model:\n%s\n", __FUNCTION__, loaderWarnings.c_str());
+    }
+
+    if (!loaderErrors.empty())
+    {
+        Logger::log(1, "%s: errors while loading glTF model:\n%s\n", __FUNCTION__, loaderErrors.c_str());
+    }
+
+    if (!result)
+    {
+        Logger::log(1, "%s error: could not load file '%s'\n", __FUNCTION__, modelFilename.c_str());
+        return false;
+    }
+
+    mModelFilename = modelFilename;
+    mDrawMode = GL_TRIANGLES;
+    /* entry 0 stands for the texture file given to loadModel, mergeMeshes adds the images of the materials */
+    mTextureFiles.assign(1, std::string{});
+
+    /* node tree, then every primitive and skin merged into one vertex range and one joint palette */
+    getSkeleton();
+    if (!mergeMeshes())
+    {
+        return false;
+    }
+
+    /* reorder the merged indices and vertices, everything below uses the optimized data */
+    if (renderData.rdOptimizeMesh)
+    {
+        optimizeMesh(renderData);
+    }
+
+    /* simplified index buffers for distant instances */
+    generateLods(renderData);
+
+    /* position, normal, texture coords, joints and weights in one interleaved stream */
+    mPackedVertices = false;
+    if (renderData.rdPackVertices)
+    {
+        mPackedVertices = packVertices();
+    }
+
+    /* extract animation data */
+    Timer clipTimer{};
+    clipTimer.start();
+    getAnimations(threadPool);
+    renderData.rdClipImportTime = clipTimer.stop();
+
+    return true;
+}
+
+void GltfModel::createModelBuffers()
+{
+    mPendingUploads.clear();
+    mNextUpload = 0;
+    mUploadBytes = 0;
+    mUploadedBytes = 0;
+    mBufferBytes = 0;
+    mUploadFinished = false;
+
+    /* storage only, the pixels and vertices follow in uploadModelData */
+    mTex.resize(mTextureData.size());
+    for (size_t i = 0; i < mTextureData.size(); ++i)
+    {
+        mTex.at(i).createStorage(mTextureData.at(i));
+        queueUpload(GL_TEXTURE_2D, i, mTextureData.at(i).pixels, mTextureData.at(i).size);
+    }
+
+    glGenVertexArrays(1, &mVAO);
+    OGLStateCache::bindVertexArray(mVAO);
+
+    if (mPackedVertices)
+    {
+        createPackedVertexBuffer();
+    }
+    else
+    {
+        createVertexBuffers();
+    }
+    createIndexBuffer();
+
+    OGLStateCache::bindVertexArray(0);
+
+    queueVertexUploads();
+    queueIndexUpload();
+
+    /* a few KB, created right away */
+    createSkeletonBuffers();
+
+    /* the unpacked vertex sizes are known after the attribute setup */
+    Logger::log(1, "%s: vertex data uses %i bytes (%i bytes unpacked, %i%% saved)\n", __FUNCTION__,
+        mVertexDataSize, mUnpackedVertexDataSize,
+        mUnpackedVertexDataSize > 0 ? static_cast<int>(100 - mVertexDataSize * 100 / mUnpackedVertexDataSize) : 0);
+}
+
+void GltfModel::queueUpload(GLenum target, GLuint buffer, const unsigned char* data, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (target != GL_TEXTURE_2D)
+    {
+        OGLStateCache::bindBuffer(target, buffer);
+        glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+        mBufferBytes += size;
+    }
+
+    mPendingUploads.push_back({ target, buffer, data, size, 0 });
+    mUploadBytes += size;
+}
+
+size_t GltfModel::uploadModelData(size_t byteBudget)
+{
+    size_t uploadedBytes = 0;
+    while (mNextUpload < mPendingUploads.size())
+    {
+        GltfPendingUpload& upload = mPendingUploads.at(mNextUpload);
+        size_t chunkSize = upload.size - upload.uploaded;
+        if (byteBudget > 0)
+        {
+            chunkSize = std::min(chunkSize, byteBudget - uploadedBytes);
+        }
+
+        if (upload.target == GL_TEXTURE_2D)
+        {
+            /* whole rows of one mip level, at least one row even if it is bigger than the budget */
+            chunkSize = mTex.at(upload.buffer).uploadData(mTextureData.at(upload.buffer), upload.uploaded, chunkSize);
+        }
+        else
+        {
+            /* the element buffer binding is part of the VAO, bind ours instead of changing the current one */
+            if (upload.target == GL_ELEMENT_ARRAY_BUFFER)
+            {
+                OGLStateCache::bindVertexArray(mVAO);
+            }
+            OGLStateCache::bindBuffer(upload.target, upload.buffer);
+            glBufferSubData(upload.target, upload.uploaded, chunkSize, upload.data + upload.uploaded);
+            OGLStateCache::countUpload(chunkSize);
+        }
+
+        upload.uploaded += chunkSize;
+        uploadedBytes += chunkSize;
+        if (upload.uploaded == upload.size)
+        {
+            ++mNextUpload;
+        }
+        if (byteBudget > 0 && uploadedBytes >= byteBudget)
+        {
+            break;
+        }
+    }
+    mUploadedBytes += uploadedBytes;
+
+    if (mNextUpload == mPendingUploads.size() && !mUploadFinished)
+    {
+        for (size_t i = 0; i < mTex.size(); ++i)
+        {
+            mTex.at(i).finishUpload(mTextureData.at(i));
+        }
+
+        /* the GPU has its copy now, the level sizes stay for the stats */
+        mPackedVertexData.clear();
+        mPackedVertexData.shrink_to_fit();
+        mPositions = std::vector<glm::vec3>{};
+        mNormals = std::vector<glm::vec3>{};
+        mUVs = std::vector<glm::vec2>{};
+        mJointVec = std::vector<glm::tvec4<uint16_t>>{};
+        mWeightVec = std::vector<glm::vec4>{};
+        mLodIndexData = std::vector<uint32_t>{};
+        for (TextureData& textureData : mTextureData)
+        {
+            textureData.pixelStorage.clear();
+            textureData.pixelStorage.shrink_to_fit();
+            textureData.pixels = nullptr;
+        }
+        mPendingUploads.clear();
+        mNextUpload = 0;
+        mUploadFinished = true;
+        Logger::log(1, "%s: %i bytes of model data uploaded\n", __FUNCTION__, mUploadedBytes);
+
+        if (mResidentMinimal)
+        {
+            releaseSourceData();
+        }
+    }
+    return uploadedBytes;
+}
+
+bool GltfModel::isUploaded()
+{
+    return mUploadFinished;
+}
+
+size_t GltfModel::getUploadBytes()
+{
+    return mUploadBytes;
+}
+
+size_t GltfModel::getUploadedBytes()
+{
+    return mUploadedBytes;
+}
+
+size_t GltfModel::getGpuBytes()
+{
+    size_t textureBytes = 0;
+    for (Texture& texture : mTex)
+    {
+        textureBytes += texture.getGpuBytes();
+    }
+    return mBufferBytes + textureBytes;
+}
+
+void GltfModel::releaseSourceData()
+{
+    /* lazy clips are created from the source data whenever they are used again */
+    if (mLazyClips)
+    {
+        Logger::log(1, "%s: lazy clips need the source data of '%s', keeping it\n", __FUNCTION__, mModelFilename.c_str());
+        return;
+    }
+
+    size_t residentBefore = ProcessMemory::getResidentBytes();
+
+    for (auto& clip : mAnimClips)
+    {
+        clip->detachSourceData();
+    }
+    mBufferData.reset();
+    mModel.reset();
+    mCookedHeader = nullptr;
+    mCookedFile.reset();
+
+    /* freed heap memory may stay in the process, mapped files are returned right away */
+    size_t residentAfter = ProcessMemory::getResidentBytes();
+    mReleasedBytes = residentBefore > residentAfter ? residentBefore - residentAfter : 0;
+    Logger::log(1, "%s: source data of '%s' released, resident memory shrank by %.1f KB\n", __FUNCTION__,
+        mModelFilename.c_str(), mReleasedBytes / 1024.0f);
+}
+
+size_t GltfModel::getReleasedBytes()
+{
+    return mReleasedBytes;
+}
+
+void GltfModel::setClipMemoryBudget(size_t bytes)
+{
+    mClipMemoryBudget = bytes;
+}
+
+void GltfModel::collectClips()
+{
+    ++mClipFrame;
+    mClipLastUse.resize(mAnimClips.size(), 0);
+
+    size_t residentBytes = 0;
+    for (size_t i = 0; i < mAnimClips.size(); ++i)
+    {
+        if (mAnimClips.at(i)->checkUsed())
+        {
+            mClipLastUse.at(i) = mClipFrame;
+        }
+        residentBytes += mAnimClips.at(i)->getMemoryBytes();
+    }
+
+    /* least recently used clip first, clips used since the last call are never dropped */
+    while (residentBytes > mClipMemoryBudget)
+    {
+        int oldestClip = -1;
+        for (size_t i = 0; i < mAnimClips.size(); ++i)
+        {
+            if (mAnimClips.at(i)->isLazy() && mAnimClips.at(i)->isLoaded() && mClipLastUse.at(i) < mClipFrame &&
+                (oldestClip < 0 || mClipLastUse.at(i) < mClipLastUse.at(oldestClip)))
+            {
+                oldestClip = static_cast<int>(i);
+            }
+        }
+        if (oldestClip < 0)
+        {
+            break;
+        }
+
+        std::shared_ptr<GltfAnimationClip> clip = mAnimClips.at(oldestClip);
+        residentBytes -= clip->getMemoryBytes();
+        clip->unload();
+        ++mClipEvictions;
+        Logger::log(2, "%s: unloaded clip '%s'\n", __FUNCTION__, clip->getClipName().c_str());
+    }
+}
+
+GltfClipStats GltfModel::getClipStats()
+{
+    GltfClipStats stats{};
+    stats.clipCount = mAnimClips.size();
+    stats.evictions = mClipEvictions;
+    for (const auto& clip : mAnimClips)
+    {
+        if (clip->isLoaded())
+        {
+            ++stats.residentCount;
+            stats.residentBytes += clip->getMemoryBytes();
+        }
+        stats.loads += clip->getLoadCount();
+        stats.streamedCount += clip->isStreamed() ? 1 : 0;
+        stats.streamMisses += clip->getStreamMisses();
+    }
+    return stats;
+}
+
+std::vector<OGLTextureInfo> GltfModel::getTextureInfos()
+{
+    std::vector<OGLTextureInfo> infos{};
+    for (size_t i = 0; i < mTextureData.size() && i < mTex.size(); ++i)
+    {
+        const TextureData& textureData = mTextureData.at(i);
+        OGLTextureInfo info{};
+        info.name = std::filesystem::path(textureData.name).filename().string();
+        info.width = textureData.width;
+        info.height = textureData.height;
+        info.levels = textureData.levels.size();
+        info.gpuBytes = mTex.at(i).getGpuBytes();
+        info.loadTime = textureData.loadTime;
+        info.fromCache = textureData.fromCache;
+        info.compressed = textureData.format != GL_RGBA8;
+        infos.push_back(info);
+    }
+    return infos;
+}
+
+bool GltfModel::isCookedModel(std::string modelFilename)
+{
+    std::string extension = std::filesystem::path(modelFilename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension.compare(".apmodel") == 0;
+}
+
+const unsigned char* GltfModel::getCookedSection(GltfCookedSectionType type)
+{
+    return mCookedFile->getData() + mCookedHeader->sections[static_cast<size_t>(type)].offset;
+}
+
+bool GltfModel::mapCookedModel(OGLRenderData& renderData, std::string cookedFilename)
+{
+    mCookedFile = std::make_shared<MappedFile>();
+    if (!mCookedFile->open(cookedFilename))
+    {
+        return false;
+    }
+
+    const GltfCookedHeader* header = reinterpret_cast<const GltfCookedHeader*>(mCookedFile->getData());
+    size_t fileSize = mCookedFile->getSize();
+    if (fileSize < sizeof(GltfCookedHeader) || header->magic != GltfCookedMagic)
+    {
+        Logger::log(0, "%s: Error - '%s' is not a cooked model\n", __FUNCTION__, cookedFilename.c_str());
+        return false;
+    }
+    if (header->version != GltfCookedVersion)
+    {
+        Logger::log(0, "%s: Error - '%s' has version %i instead of %i, cook the model again\n", __FUNCTION__,
+            cookedFilename.c_str(), header->version, GltfCookedVersion);
+        return false;
+    }
+    if (header->fileSize != fileSize)
+    {
+        Logger::log(0, "%s: Error - '%s' is truncated\n", __FUNCTION__, cookedFilename.c_str());
+        return false;
+    }
+
+    for (const GltfCookedSection& section : header->sections)
+    {
+        if (section.offset % GltfCookedAlignment != 0 || section.offset > fileSize || section.size > fileSize - section.offset)
+        {
+            Logger::log(0, "%s: Error - '%s' has a broken section table\n", __FUNCTION__, cookedFilename.c_str());
+            return false;
+        }
+    }
+
+    /* the sizes have to match the counts, everything below reads the sections in place */
+    auto sectionSize = [&](GltfCookedSectionType type) { return header->sections[static_cast<size_t>(type)].size; };
+    size_t nameSize = sectionSize(GltfCookedSectionType::NAMES);
+    if (sectionSize(GltfCookedSectionType::NODES) != header->nodeCount * sizeof(GltfCookedNode) ||
+        sectionSize(GltfCookedSectionType::SKIN_JOINTS) != header->jointCount * sizeof(int32_t) ||
+        sectionSize(GltfCookedSectionType::INVERSE_BINDS) != header->jointCount * sizeof(glm::mat4) ||
+        sectionSize(GltfCookedSectionType::VERTICES) != header->vertexCount * sizeof(GltfPackedVertex) ||
+        sectionSize(GltfCookedSectionType::LODS) != header->lodCount * sizeof(GltfCookedLod) ||
+        sectionSize(GltfCookedSectionType::CLIPS) != header->clipCount * sizeof(GltfCookedClip) ||
+        sectionSize(GltfCookedSectionType::TEXTURE) != static_cast<uint64_t>(header->textureWidth) * header->textureHeight * 4 ||
+        header->lodCount == 0 || header->rootNode < 0 || static_cast<uint32_t>(header->rootNode) >= header->nodeCount ||
+        nameSize == 0)
+    {
+        Logger::log(0, "%s: Error - '%s' has inconsistent sections\n", __FUNCTION__, cookedFilename.c_str());
+        return false;
+    }
+
+    mCookedHeader = header;
+    mModelFilename = cookedFilename;
+    mTextureFiles.assign(1, cookedFilename);
+    mTextureData.resize(1);
+    Texture::setPixels(mTextureData.at(0), getCookedSection(GltfCookedSectionType::TEXTURE), header->textureWidth,
+        header->textureHeight);
+    mTextureData.at(0).name = cookedFilename;
+
+    const GltfCookedNode* nodes = reinterpret_cast<const GltfCookedNode*>(getCookedSection(GltfCookedSectionType::NODES));
+    const int32_t* children = reinterpret_cast<const int32_t*>(getCookedSection(GltfCookedSectionType::CHILDREN));
+    const char* names = reinterpret_cast<const char*>(getCookedSection(GltfCookedSectionType::NAMES));
+    const int32_t* skinJoints = reinterpret_cast<const int32_t*>(getCookedSection(GltfCookedSectionType::SKIN_JOINTS));
+    const glm::mat4* inverseBinds = reinterpret_cast<const glm::mat4*>(getCookedSection(GltfCookedSectionType::INVERSE_BINDS));
+
+    /* the node tree and skin are a few KB, one bulk copy each */
+    mRootNode = header->rootNode;
+    mNodes.assign(nodes, nodes + header->nodeCount);
+    mNodeChildren.assign(children, children + sectionSize(GltfCookedSectionType::CHILDREN) / sizeof(int32_t));
+    mNames.assign(names, names + nameSize);
+    mSkinJoints.assign(skinJoints, skinJoints + header->jointCount);
+    mInverseBindMatrices.assign(inverseBinds, inverseBinds + header->jointCount);
+    mNodeCount = mNodes.size();
+
+    bool indicesValid = mNames.back() == '\0';
+    for (const GltfCookedNode& node : mNodes)
+    {
+        indicesValid = indicesValid && node.nameOffset < nameSize &&
+            node.firstChild <= mNodeChildren.size() && node.childCount <= mNodeChildren.size() - node.firstChild;
+    }
+    for (const int32_t child : mNodeChildren)
+    {
+        indicesValid = indicesValid && child >= 0 && child < mNodeCount;
+    }
+    for (const int32_t joint : mSkinJoints)
+    {
+        indicesValid = indicesValid && joint >= 0 && joint < mNodeCount;
+    }
+    if (!indicesValid)
+    {
+        Logger::log(0, "%s: Error - '%s' has invalid node references\n", __FUNCTION__, cookedFilename.c_str());
+        mCookedHeader = nullptr;
+        return false;
+    }
+    createNodeToJoint(mSkinJoints);
+
+    /* all LOD levels share one 32 bit index buffer */
+    const GltfCookedLod* lods = reinterpret_cast<const GltfCookedLod*>(getCookedSection(GltfCookedSectionType::LODS));
+    mLodLevels.clear();
+    for (uint32_t i = 0; i < header->lodCount; ++i)
+    {
+        /* cooked models have a single texture, all material ranges of a level are drawn at once */
+        GltfMeshRange range{ lods[i].indexOffset, static_cast<int>(lods[i].indexCount), 0 };
+        mLodLevels.push_back({ lods[i].indexOffset, static_cast<int>(lods[i].indexCount), lods[i].error, { range } });
+    }
+    mIndexType = GL_UNSIGNED_INT;
+    mDrawMode = GL_TRIANGLES;
+    mBoundingSphere = glm::make_vec4(header->boundingSphere);
+
+    mPackedVertices = true;
+    mVertexDataSize = sectionSize(GltfCookedSectionType::VERTICES);
+    mUnpackedVertexDataSize = header->vertexCount * (2 * sizeof(glm::vec3) + sizeof(glm::vec2) +
+        sizeof(glm::tvec4<uint16_t>) + sizeof(glm::vec4));
+
+    /* the channels point to the keyframes in the mapped file */
+    const GltfCookedClip* clips = reinterpret_cast<const GltfCookedClip*>(getCookedSection(GltfCookedSectionType::CLIPS));
+    const GltfCookedChannel* channels = reinterpret_cast<const GltfCookedChannel*>(getCookedSection(GltfCookedSectionType::CHANNELS));
+    const float* keys = reinterpret_cast<const float*>(getCookedSection(GltfCookedSectionType::KEYS));
+    size_t channelCount = sectionSize(GltfCookedSectionType::CHANNELS) / sizeof(GltfCookedChannel);
+    size_t keyCount = sectionSize(GltfCookedSectionType::KEYS) / sizeof(float);
+
+    mAnimClips.clear();
+    for (uint32_t i = 0; i < header->clipCount; ++i)
+    {
+        const GltfCookedClip& cookedClip = clips[i];
+        if (cookedClip.nameOffset >= nameSize || cookedClip.firstChannel > channelCount ||
+            cookedClip.channelCount > channelCount - cookedClip.firstChannel || cookedClip.channelCount == 0)
+        {
+            Logger::log(0, "%s: Error - clip %i of '%s' is invalid\n", __FUNCTION__, i, cookedFilename.c_str());
+            mCookedHeader = nullptr;
+            return false;
+        }
+
+        for (uint32_t j = cookedClip.firstChannel; j < cookedClip.firstChannel + cookedClip.channelCount; ++j)
+        {
+            const GltfCookedChannel& channel = channels[j];
+            if (channel.targetNode < 0 || channel.targetNode >= mNodeCount || channel.keyCount == 0 ||
+                channel.timeOffset > keyCount || channel.keyCount > keyCount - channel.timeOffset ||
+                channel.valueOffset > keyCount || channel.valueCount > keyCount - channel.valueOffset)
+            {
+                Logger::log(0, "%s: Error - channel %i of '%s' is invalid\n", __FUNCTION__, j, cookedFilename.c_str());
+                mCookedHeader = nullptr;
+                return false;
+            }
+        }
+
+        const GltfCookedChannel* clipChannels = channels + cookedClip.firstChannel;
+        uint32_t clipChannelCount = cookedClip.channelCount;
+        auto addChannels = [clipChannels, clipChannelCount, keys](GltfAnimationClip& clip)
+        {
+            for (uint32_t j = 0; j < clipChannelCount; ++j)
+            {
+                clip.addCookedChannel(clipChannels[j], keys);
+            }
+            return true;
+        };
+
+        std::string clipName = &mNames.at(cookedClip.nameOffset);
+        if (mLazyClips)
+        {
+            /* the loader keeps the mapping alive, the length is the last key of the first channel */
+            std::shared_ptr<MappedFile> cookedFile = mCookedFile;
+            float endTime = clipChannelCount > 0 && clipChannels->keyCount > 0 ?
+                keys[clipChannels->timeOffset + clipChannels->keyCount - 1] : 0.0f;
+            mAnimClips.push_back(std::make_shared<GltfAnimationClip>(clipName,
+                [cookedFile, addChannels](GltfAnimationClip& clip) { return addChannels(clip); }, endTime));
+            continue;
+        }
+
+        std::shared_ptr<GltfAnimationClip> clip = std::make_shared<GltfAnimationClip>(clipName);
+        addChannels(*clip);
+        mAnimClips.push_back(clip);
+    }
+
+    renderData.rdMeshACMRBefore = header->meshStats[0];
+    renderData.rdMeshACMRAfter = header->meshStats[1];
+    renderData.rdMeshATVRBefore = header->meshStats[2];
+    renderData.rdMeshATVRAfter = header->meshStats[3];
+    renderData.rdLodLevels = mLodLevels.size();
+
+    Logger::log(1, "%s: mapped cooked model with %i nodes, %i vertices, %i LODs and %i clips\n", __FUNCTION__,
+        mNodeCount, header->vertexCount, header->lodCount, header->clipCount);
+    return true;
+}
+
+bool GltfModel::saveCookedModel(OGLRenderData& renderData, std::string cookedFilename, std::string textureFilename)
+{
+    if (!mModel || !mPackedVertices || mPackedVertexData.empty())
+    {
+        Logger::log(0, "%s: Error - only imported models with packed vertices can be cooked\n", __FUNCTION__);
+        return false;
+    }
+    if (mTextureFiles.size() > 1)
+    {
+        Logger::log(0, "%s: Error - the materials use %i textures, cooked models carry a single texture\n", __FUNCTION__,
+            mTextureFiles.size());
+        return false;
+    }
+
+    /* decoded once here, the runtime uploads the pixels as they are */
+    int texWidth = 0;
+    int texHeight = 0;
+    int texChannels = 0;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char* texData = stbi_load(textureFilename.c_str(), &texWidth, &texHeight, &texChannels, 4);
+    if (!texData)
+    {
+        Logger::log(0, "%s: Error - could not decode texture '%s'\n", __FUNCTION__, textureFilename.c_str());
+        return false;
+    }
+
+    const std::vector<uint32_t>& indices = mLodIndexData;
+    std::vector<GltfCookedLod> lods{};
+    for (const GltfLodLevel& level : mLodLevels)
+    {
+        lods.push_back({ static_cast<uint32_t>(level.indexOffset), static_cast<uint32_t>(level.indexCount), level.error, 0 });
+    }
+
+    /* clip names go behind the node names, keyframe times and values of all channels into one float array */
+    std::vector<char> names = mNames;
+    std::vector<GltfCookedClip> clips{};
+    std::vector<GltfCookedChannel> channels{};
+    std::vector<float> keys{};
+    for (const auto& clip : mAnimClips)
+    {
+        GltfCookedClip cookedClip{};
+        cookedClip.nameOffset = names.size();
+        std::string clipName = clip->getClipName();
+        names.insert(names.end(), clipName.begin(), clipName.end());
+        names.push_back('\0');
+
+        cookedClip.firstChannel = channels.size();
+        for (const auto& channel : clip->getChannels())
+        {
+            GltfCookedChannel cookedChannel{};
+            cookedChannel.targetNode = channel->getTargetNode();
+            cookedChannel.targetPath = static_cast<uint32_t>(channel->getTargetPath());
+            cookedChannel.interpolation = static_cast<uint32_t>(channel->getInterpolationType());
+
+            const KeyframeView<float>& timings = channel->getTimings();
+            cookedChannel.keyCount = timings.size();
+            cookedChannel.timeOffset = keys.size();
+            keys.insert(keys.end(), timings.data(), timings.data() + timings.size());
+
+            cookedChannel.valueCount = channel->getValueCount();
+            cookedChannel.valueOffset = keys.size();
+            keys.insert(keys.end(), channel->getValueData(), channel->getValueData() + channel->getValueCount());
+
+            channels.push_back(cookedChannel);
+        }
+        cookedClip.channelCount = channels.size() - cookedClip.firstChannel;
+        clips.push_back(cookedClip);
+    }
+
+    GltfCookedHeader header{};
+    header.magic = GltfCookedMagic;
+    header.version = GltfCookedVersion;
+    header.rootNode = mRootNode;
+    header.nodeCount = mNodes.size();
+    header.jointCount = mSkinJoints.size();
+    header.vertexCount = mPackedVertexData.size();
+    header.lodCount = lods.size();
+    header.clipCount = clips.size();
+    header.textureWidth = texWidth;
+    header.textureHeight = texHeight;
+    std::memcpy(header.boundingSphere, &mBoundingSphere, sizeof(header.boundingSphere));
+    header.meshStats[0] = renderData.rdMeshACMRBefore;
+    header.meshStats[1] = renderData.rdMeshACMRAfter;
+    header.meshStats[2] = renderData.rdMeshATVRBefore;
+    header.meshStats[3] = renderData.rdMeshATVRAfter;
+
+    std::vector<unsigned char> fileData(sizeof(GltfCookedHeader));
+    auto addSection = [&](GltfCookedSectionType type, const void* data, size_t size)
+    {
+        fileData.resize((fileData.size() + GltfCookedAlignment - 1) / GltfCookedAlignment * GltfCookedAlignment);
+        header.sections[static_cast<size_t>(type)] = { fileData.size(), size };
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        fileData.insert(fileData.end(), bytes, bytes + size);
+    };
+
+    addSection(GltfCookedSectionType::NODES, mNodes.data(), mNodes.size() * sizeof(GltfCookedNode));
+    addSection(GltfCookedSectionType::CHILDREN, mNodeChildren.data(), mNodeChildren.size() * sizeof(int32_t));
+    addSection(GltfCookedSectionType::NAMES, names.data(), names.size());
+    addSection(GltfCookedSectionType::SKIN_JOINTS, mSkinJoints.data(), mSkinJoints.size() * sizeof(int32_t));
+    addSection(GltfCookedSectionType::INVERSE_BINDS, mInverseBindMatrices.data(), mInverseBindMatrices.size() * sizeof(glm::mat4));
+    addSection(GltfCookedSectionType::VERTICES, mPackedVertexData.data(), mPackedVertexData.size() * sizeof(GltfPackedVertex));
+    addSection(GltfCookedSectionType::INDICES, indices.data(), indices.size() * sizeof(uint32_t));
+    addSection(GltfCookedSectionType::LODS, lods.data(), lods.size() * sizeof(GltfCookedLod));
+    addSection(GltfCookedSectionType::CLIPS, clips.data(), clips.size() * sizeof(GltfCookedClip));
+    addSection(GltfCookedSectionType::CHANNELS, channels.data(), channels.size() * sizeof(GltfCookedChannel));
+    addSection(GltfCookedSectionType::KEYS, keys.data(), keys.size() * sizeof(float));
+    addSection(GltfCookedSectionType::TEXTURE, texData, static_cast<size_t>(texWidth) * texHeight * 4);
+    stbi_image_free(texData);
+
+    header.fileSize = fileData.size();
+    std::memcpy(fileData.data(), &header, sizeof(header));
+
+    std::ofstream outFile(cookedFilename, std::ios::binary | std::ios::trunc);
+    outFile.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+    if (!outFile.good())
+    {
+        Logger::log(0, "%s: Error - could not write '%s'\n", __FUNCTION__, cookedFilename.c_str());
+        return false;
+    }
+
+    Logger::log(1, "%s: wrote %i bytes to '%s'\n", __FUNCTION__, static_cast<int>(fileData.size()), cookedFilename.c_str());
+    return true;
+}
+
+/* the placeholder buffer and the image loader keep tinygltf from touching the binary data */
+static bool skipImageData(tinygltf::Image*, const int, std::string*, std::string*, int, int,
+    const unsigned char*, int, void*)
+{
+    return true;
+}
+
+bool GltfModel::loadBinaryModel(tinygltf::TinyGLTF& gltfLoader, std::string modelFilename, std::string& loaderErrors,
+    std::string& loaderWarnings)
+{
+    const uint32_t glbMagic = 0x46546C67;
+    const uint32_t jsonChunkType = 0x4E4F534A;
+    const uint32_t binChunkType = 0x004E4942;
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(modelFilename))
+    {
+        return false;
+    }
+
+    /* 12 byte header, then chunks of length, type, and data */
+    const unsigned char* fileData = file->getData();
+    size_t fileSize = file->getSize();
+    uint32_t header[3];
+    if (fileSize < sizeof(header))
+    {
+        loaderErrors = "file too small for a GLB header";
+        return false;
+    }
+    std::memcpy(header, fileData, sizeof(header));
+    if (header[0] != glbMagic || header[1] != 2 || header[2] > fileSize)
+    {
+        loaderErrors = "not a version 2 GLB file";
+        return false;
+    }
+
+    const char* jsonData = nullptr;
+    size_t jsonSize = 0;
+    unsigned char* binData = nullptr;
+    size_t binSize = 0;
+
+    size_t chunkOffset = sizeof(header);
+    while (chunkOffset + 8 <= header[2])
+    {
+        uint32_t chunkHeader[2];
+        std::memcpy(chunkHeader, fileData + chunkOffset, sizeof(chunkHeader));
+        chunkOffset += sizeof(chunkHeader);
+        if (chunkOffset + chunkHeader[0] > header[2])
+        {
+            loaderErrors = "GLB chunk exceeds the file size";
+            return false;
+        }
+
+        if (chunkHeader[1] == jsonChunkType && !jsonData)
+        {
+            jsonData = reinterpret_cast<const char*>(fileData + chunkOffset);
+            jsonSize = chunkHeader[0];
+        }
+        else if (chunkHeader[1] == binChunkType && !binData)
+        {
+            binData = file->getData() + chunkOffset;
+            binSize = chunkHeader[0];
+        }
+        /* chunks are 4 byte aligned */
+        chunkOffset += (chunkHeader[0] + 3) & ~3u;
+    }
+
+    if (!jsonData)
+    {
+        loaderErrors = "GLB file has no JSON chunk";
+        return false;
+    }
+
+    /* the buffer without uri is the BIN chunk, replace it by a one byte data uri so tinygltf does not copy it */
+    nlohmann::json gltfJson = nlohmann::json::parse(jsonData, jsonData + jsonSize, nullptr, false);
+    if (gltfJson.is_discarded())
+    {
+        loaderErrors = "invalid JSON chunk";
+        return false;
+    }
+
+    int binBuffer = -1;
+    if (gltfJson.contains("buffers"))
+    {
+        nlohmann::json& buffers = gltfJson["buffers"];
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            if (!buffers[i].contains("uri"))
+            {
+                if (!binData || buffers[i].value("byteLength", size_t(0)) > binSize)
+                {
+                    loaderErrors = "GLB buffer is bigger than the BIN chunk";
+                    return false;
+                }
+                buffers[i]["uri"] = "data:application/octet-stream;base64,AA==";
+                buffers[i]["byteLength"] = 1;
+                binBuffer = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+
+    std::string placeholderJson = gltfJson.dump();
+    std::string baseDir = std::filesystem::path(modelFilename).parent_path().string();
+
+    /* embedded images would be decoded from the placeholder, the model texture is loaded separately anyway */
+    gltfLoader.SetImageLoader(skipImageData, nullptr);
+    if (!gltfLoader.LoadASCIIFromString(mModel.get(), &loaderErrors, &loaderWarnings, placeholderJson.c_str(),
+        static_cast<unsigned int>(placeholderJson.size()), baseDir))
+    {
+        return false;
+    }
+
+    if (binBuffer >= 0)
+    {
+        /* drop the placeholder byte, all reads go through mBufferData */
+        mModel->buffers.at(binBuffer).data.clear();
+        mModel->buffers.at(binBuffer).data.shrink_to_fit();
+    }
+
+    mBufferData = std::make_shared<GltfBufferData>(mModel, file, binBuffer, binData, binSize);
+    return true;
+}
+
+std::string GltfModel::getModelFilename() 
+{
+    return mModelFilename;
+}
+
+int GltfModel::getNodeCount() 
+{
+    return mNodeCount;
+}
+
+GltfNodeData GltfModel::getGltfNodes() 
+{
+    GltfNodeData nodeData{};
+
+    int rootNodeNum = mRootNode;
+    Logger::log(2, "%s: model has %i nodes, root node is %i\n", __FUNCTION__, mNodeCount, rootNodeNum);
+
+    nodeData.rootNode = GltfNode::createRoot(rootNodeNum);
+
+    getNodeData(nodeData.rootNode);
+    getNodes(nodeData.rootNode);
+
+    nodeData.nodeList.resize(mNodeCount);
+    nodeData.nodeList.at(rootNodeNum) = nodeData.rootNode;
+    getNodeList(nodeData.nodeList, rootNodeNum);
+
+    return nodeData;
+}
+
+void GltfModel::getSkeleton()
+{
+    mRootNode = mModel->scenes.at(0).nodes.at(0);
+    mNodes.resize(mModel->nodes.size());
+    mNodeChildren.clear();
+    mNames.clear();
+
+    for (size_t i = 0; i < mModel->nodes.size(); ++i)
+    {
+        const tinygltf::Node& node = mModel->nodes.at(i);
+        GltfCookedNode& cookedNode = mNodes.at(i);
+
+        /* identity for missing values, the cooked layout always has all three */
+        const float identity[10] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int j = 0; j < 3; ++j)
+        {
+            cookedNode.translation[j] = node.translation.size() ? static_cast<float>(node.translation.at(j)) : identity[j];
+            cookedNode.scale[j] = node.scale.size() ? static_cast<float>(node.scale.at(j)) : identity[7 + j];
+        }
+        for (int j = 0; j < 4; ++j)
+        {
+            cookedNode.rotation[j] = node.rotation.size() ? static_cast<float>(node.rotation.at(j)) : identity[3 + j];
+        }
+
+        cookedNode.skin = node.skin;
+        cookedNode.firstChild = mNodeChildren.size();
+        cookedNode.childCount = node.children.size();
+        mNodeChildren.insert(mNodeChildren.end(), node.children.begin(), node.children.end());
+
+        cookedNode.nameOffset = mNames.size();
+        mNames.insert(mNames.end(), node.name.begin(), node.name.end());
+        mNames.push_back('\0');
+    }
+    mNodeCount = mNodes.size();
+}
+
+void GltfModel::createNodeToJoint(const std::vector<int32_t>& skinJoints)
+{
+    /* -1 for nodes that are not joints, the instances skip them when updating the palette */
+    mNodeToJoint.assign(mNodeCount, -1);
+    mNextNodeJoint.assign(skinJoints.size(), -1);
+    std::vector<int> lastNodeJoint(mNodeCount, -1);
+    for (int i = 0; i < skinJoints.size(); ++i)
+    {
+        int destinationNode = skinJoints.at(i);
+        if (mNodeToJoint.at(destinationNode) < 0)
+        {
+            mNodeToJoint.at(destinationNode) = i;
+        }
+        else
+        {
+            mNextNodeJoint.at(lastNodeJoint.at(destinationNode)) = i;
+        }
+        lastNodeJoint.at(destinationNode) = i;
+        Logger::log(2, "%s: joint %i affects node %i\n", __FUNCTION__, i, destinationNode);
+    }
+}
+
+std::vector<bool> GltfModel::getReachableNodes()
+{
+    /* same walk as getNodes, nodes with a skin are not part of the node tree of the instances */
+    std::vector<bool> reachable(mNodeCount, false);
+    std::vector<int> pendingNodes{ mRootNode };
+    while (!pendingNodes.empty())
+    {
+        int nodeNum = pendingNodes.back();
+        pendingNodes.pop_back();
+        if (reachable.at(nodeNum))
+        {
+            continue;
+        }
+        reachable.at(nodeNum) = true;
+
+        const GltfCookedNode& node = mNodes.at(nodeNum);
+        for (uint32_t i = node.firstChild; i < node.firstChild + node.childCount; ++i)
+        {
+            int childNode = mNodeChildren.at(i);
+            if (mNodes.at(childNode).skin == -1)
+            {
+                pendingNodes.push_back(childNode);
+            }
+        }
+    }
+    return reachable;
+}
+
+bool GltfModel::mergeMeshes()
+{
+    /* one palette for all skins, a node used by several skins with the same bind pose becomes a single joint,
+       every other bind pose of the node gets its own palette entry */
+    mSkinJoints.clear();
+    mInverseBindMatrices.clear();
+    std::vector<std::vector<int>> nodeToPalette(mNodeCount);
+    int extraBindPoses = 0;
+    auto addJoint = [&](int nodeNum, const glm::mat4& inverseBindMatrix)
+    {
+        for (const int joint : nodeToPalette.at(nodeNum))
+        {
+            if (mInverseBindMatrices.at(joint) == inverseBindMatrix)
+            {
+                return joint;
+            }
+        }
+        if (!nodeToPalette.at(nodeNum).empty())
+        {
+            ++extraBindPoses;
+        }
+
+        int joint = mSkinJoints.size();
+        nodeToPalette.at(nodeNum).push_back(joint);
+        mSkinJoints.push_back(nodeNum);
+        mInverseBindMatrices.push_back(inverseBindMatrix);
+        return joint;
+    };
+
+    /* joint indices of every skin in the combined palette */
+    std::vector<std::vector<int>> skinToPalette(mModel->skins.size());
+    for (size_t i = 0; i < mModel->skins.size(); ++i)
+    {
+        const tinygltf::Skin& skin = mModel->skins.at(i);
+
+        /* the matrices are optional, identity for every joint if missing */
+        std::vector<glm::mat4> inverseBindMatrices{};
+        if (skin.inverseBindMatrices >= 0)
+        {
+            GltfAccessorView<glm::mat4>(*mModel, *mBufferData, skin.inverseBindMatrices).copyTo(inverseBindMatrices);
+        }
+        inverseBindMatrices.resize(skin.joints.size(), glm::mat4(1.0f));
+
+        for (size_t j = 0; j < skin.joints.size(); ++j)
+        {
+            if (skin.joints.at(j) < 0 || skin.joints.at(j) >= mNodeCount)
+            {
+                Logger::log(0, "%s error: skin %i uses invalid node %i\n", __FUNCTION__, i, skin.joints.at(j));
+                return false;
+            }
+            skinToPalette.at(i).push_back(addJoint(skin.joints.at(j), inverseBindMatrices.at(j)));
+        }
+    }
+    if (extraBindPoses > 0)
     {
-        Logger::log(1, "%s: texture loading failed\n", __FUNCTION__);
-        return false;
+        Logger::log(1, "%s: %i joints are shared by skins with different bind poses, added a palette entry for each\n",
+            __FUNCTION__, extraBindPoses);
     }
-    Logger::log(1, "%s: glTF model texture '%s' successfully loaded\n", __FUNCTION__, modelFilename.c_str());
-
-    mModel = std::make_shared<tinygltf::Model>();
 
-    tinygltf::TinyGLTF gltfLoader;
-    std::string loaderErrors;
-    std::string loaderWarnings;
-    bool result = false;
+    struct MergedPrimitive {
+        int nodeNum;
+        int meshNum;
+        int primitiveNum;
+        int material;
+        int skin;
+    };
+
+    std::vector<bool> reachableNodes = getReachableNodes();
+    std::vector<MergedPrimitive> mergedPrimitives{};
+    for (int nodeNum = 0; nodeNum < mNodeCount; ++nodeNum)
+    {
+        const tinygltf::Node& node = mModel->nodes.at(nodeNum);
+        if (node.mesh < 0)
+        {
+            continue;
+        }
 
-    result = gltfLoader.LoadASCIIFromFile(mModel.get(), &loaderErrors, &loaderWarnings, modelFilename);
+        /* meshes without a skin follow their node, the node needs to be in the node tree of the instances */
+        int skin = node.skin < static_cast<int>(mModel->skins.size()) ? node.skin : -1;
+        if (skin < 0 && !reachableNodes.at(nodeNum))
+        {
+            Logger::log(1, "%s: mesh node %i is not part of the scene tree, skipping\n", __FUNCTION__, nodeNum);
+            continue;
+        }
 
-    if (!loaderWarnings.empty()) {
-        Logger::log(1, "%s: warnings while loading glTF model:\n%s\n", __FUNCTION__, loaderWarnings.c_str());
+        const tinygltf::Mesh& mesh = mModel->meshes.at(node.mesh);
+        for (size_t i = 0; i < mesh.primitives.size(); ++i)
+        {
+            const tinygltf::Primitive& primitive = mesh.primitives.at(i);
+            if ((primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != TINYGLTF_MODE_TRIANGLE_STRIP &&
+                primitive.mode != TINYGLTF_MODE_TRIANGLE_FAN) || primitive.attributes.count("POSITION") == 0)
+            {
+                Logger::log(1, "%s: primitive %i of mesh %i has draw mode %i or no positions, skipping\n", __FUNCTION__,
+                    i, node.mesh, primitive.mode);
+                continue;
+            }
+            if (!primitive.targets.empty())
+            {
+                Logger::log(1, "%s: morph targets of mesh %i are not supported, using the base shape\n", __FUNCTION__,
+                    node.mesh);
+            }
+            mergedPrimitives.push_back({ nodeNum, node.mesh, static_cast<int>(i), primitive.material, skin });
+        }
     }
 
-    if (!loaderErrors.empty())
+    /* primitives with the same material end up in one index range, inside it the ones with the same skin */
+    std::stable_sort(mergedPrimitives.begin(), mergedPrimitives.end(), [](const MergedPrimitive& a, const MergedPrimitive& b)
     {
-        Logger::log(1, "%s: errors while loading glTF model:\n%s\n", __FUNCTION__, loaderErrors.c_str());
-    }
+        return a.material != b.material ? a.material < b.material : a.skin < b.skin;
+    });
 
-    if (!result)
+    mPositions.clear();
+    mNormals.clear();
+    mUVs.clear();
+    mJointVec.clear();
+    mWeightVec.clear();
+    mLodIndexData.clear();
+
+    std::vector<GltfMeshRange> ranges{};
+    for (size_t primitiveNum = 0; primitiveNum < mergedPrimitives.size(); ++primitiveNum)
     {
-        Logger::log(1, "%s error: could not load file '%s'\n", __FUNCTION__, modelFilename.c_str());
-        return false;
-    }
+        const MergedPrimitive& merged = mergedPrimitives.at(primitiveNum);
+        const tinygltf::Primitive& primitive = mModel->meshes.at(merged.meshNum).primitives.at(merged.primitiveNum);
+        if (primitiveNum == 0 || merged.material != mergedPrimitives.at(primitiveNum - 1).material)
+        {
+            ranges.push_back({ mLodIndexData.size(), 0, getMaterialTexture(merged.material) });
+        }
 
-    mModelFilename = modelFilename;
+        size_t firstVertex = mPositions.size();
+        size_t vertexCount = mModel->accessors.at(primitive.attributes.at("POSITION")).count;
 
-    glGenVertexArrays(1, &mVAO);
-    glBindVertexArray(mVAO);
+        /* missing attributes keep the default value, u8 joints are widened and normalized weights converted */
+        auto appendAttribute = [&](const std::string& name, auto& target, auto defaultValue)
+        {
+            using T = typename std::decay_t<decltype(target)>::value_type;
+            target.resize(firstVertex + vertexCount, defaultValue);
+            auto attrib = primitive.attributes.find(name);
+            if (attrib == primitive.attributes.end())
+            {
+                return;
+            }
+
+            GltfAccessorView<T> view(*mModel, *mBufferData, attrib->second);
+            size_t count = std::min(vertexCount, view.size());
+            if (const T* data = view.data())
+            {
+                std::copy(data, data + count, target.begin() + firstVertex);
+                return;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                target.at(firstVertex + i) = view[i];
+            }
+        };
+
+        appendAttribute("POSITION", mPositions, glm::vec3(0.0f));
+        appendAttribute("NORMAL", mNormals, glm::vec3(0.0f, 0.0f, 1.0f));
+        appendAttribute("TEXCOORD_0", mUVs, glm::vec2(0.0f));
+
+        if (merged.skin >= 0)
+        {
+            appendAttribute("JOINTS_0", mJointVec, glm::tvec4<uint16_t>(0));
+            appendAttribute("WEIGHTS_0", mWeightVec, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+
+            const std::vector<int>& paletteJoints = skinToPalette.at(merged.skin);
+            for (size_t i = firstVertex; i < mJointVec.size(); ++i)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    uint16_t& joint = mJointVec.at(i)[j];
+                    joint = static_cast<uint16_t>(joint < paletteJoints.size() ? paletteJoints.at(joint) : 0);
+                }
+            }
+        }
+        else
+        {
+            /* rigid mesh, its node becomes a joint without a bind offset */
+            int rigidJoint = addJoint(merged.nodeNum, glm::mat4(1.0f));
+            mJointVec.resize(firstVertex + vertexCount, glm::tvec4<uint16_t>(rigidJoint, 0, 0, 0));
+            mWeightVec.resize(firstVertex + vertexCount, glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        }
 
-    /* extract position, normal, texture coords, and indices */
-    createVertexBuffers();
-    createIndexBuffer();
+        std::vector<uint32_t> indices{};
+        if (primitive.indices >= 0)
+        {
+            GltfAccessorView<uint32_t>(*mModel, *mBufferData, primitive.indices).copyTo(indices);
+        }
+        else
+        {
+            indices.resize(vertexCount);
+            std::iota(indices.begin(), indices.end(), 0);
+        }
 
-    glBindVertexArray(0);
+        /* strips and fans become lists with the same winding */
+        if (primitive.mode != TINYGLTF_MODE_TRIANGLES)
+        {
+            std::vector<uint32_t> triangles{};
+            for (size_t i = 2; i < indices.size(); ++i)
+            {
+                if (primitive.mode == TINYGLTF_MODE_TRIANGLE_FAN)
+                {
+                    triangles.insert(triangles.end(), { indices.at(0), indices.at(i - 1), indices.at(i) });
+                }
+                else if (i % 2 == 0)
+                {
+                    triangles.insert(triangles.end(), { indices.at(i - 2), indices.at(i - 1), indices.at(i) });
+                }
+                else
+                {
+                    triangles.insert(triangles.end(), { indices.at(i - 1), indices.at(i - 2), indices.at(i) });
+                }
+            }
+            indices.swap(triangles);
+        }
 
-    /* extract joints, weights, and invers bind matrices*/
-    getJointData();
-    getWeightData();
-    getInvBindMatrices();
+        for (size_t i = 0; i < indices.size() / 3 * 3; ++i)
+        {
+            if (indices.at(i) >= vertexCount)
+            {
+                Logger::log(0, "%s error: primitive %i of mesh %i uses vertex %i of %i\n", __FUNCTION__,
+                    merged.primitiveNum, merged.meshNum, indices.at(i), vertexCount);
+                return false;
+            }
+            mLodIndexData.push_back(static_cast<uint32_t>(firstVertex + indices.at(i)));
+        }
+        ranges.back().indexCount = static_cast<int>(mLodIndexData.size() - ranges.back().indexOffset);
+    }
 
-    mNodeCount = mModel->nodes.size();
+    if (mLodIndexData.empty())
+    {
+        Logger::log(0, "%s error: model has no triangles\n", __FUNCTION__);
+        return false;
+    }
 
-    /* extract animation data */
-    getAnimations();
+    /* level 0, generateLods adds the simplified levels */
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const GltfMeshRange& range) { return range.indexCount == 0; }),
+        ranges.end());
+    mLodLevels.clear();
+    mLodLevels.push_back({ 0, static_cast<int>(mLodIndexData.size()), 0.0f, ranges });
 
-    return true;
-}
+    /* the unpacked vertices store the joints as u16 */
+    if (mSkinJoints.size() > 65536)
+    {
+        Logger::log(0, "%s error: %i joints do not fit into 16 bit\n", __FUNCTION__, mSkinJoints.size());
+        return false;
+    }
+    createNodeToJoint(mSkinJoints);
 
-std::string GltfModel::getModelFilename() 
-{
-    return mModelFilename;
-}
+    mUnpackedVertexDataSize = mPositions.size() * (2 * sizeof(glm::vec3) + sizeof(glm::vec2) +
+        sizeof(glm::tvec4<uint16_t>) + sizeof(glm::vec4));
+    mVertexDataSize = mUnpackedVertexDataSize;
 
-int GltfModel::getNodeCount() 
-{
-    return mNodeCount;
+    Logger::log(1, "%s: merged %i primitives into %i vertices and %i triangles, %i materials, %i joints from %i skins\n",
+        __FUNCTION__, mergedPrimitives.size(), mPositions.size(), mLodIndexData.size() / 3, ranges.size(),
+        mSkinJoints.size(), mModel->skins.size());
+    return true;
 }
 
-GltfNodeData GltfModel::getGltfNodes() 
+int GltfModel::getMaterialTexture(int material)
 {
-    GltfNodeData nodeData{};
-
-    int rootNodeNum = mModel->scenes.at(0).nodes.at(0);
-    Logger::log(2, "%s: model has %i nodes, root node is %i\n", __FUNCTION__, mNodeCount, rootNodeNum);
-
-    nodeData.rootNode = GltfNode::createRoot(rootNodeNum);
+    if (material < 0 || material >= static_cast<int>(mModel->materials.size()))
+    {
+        return 0;
+    }
+    int textureNum = mModel->materials.at(material).pbrMetallicRoughness.baseColorTexture.index;
+    if (textureNum < 0 || textureNum >= static_cast<int>(mModel->textures.size()))
+    {
+        return 0;
+    }
+    int imageNum = mModel->textures.at(textureNum).source;
+    if (imageNum < 0 || imageNum >= static_cast<int>(mModel->images.size()))
+    {
+        return 0;
+    }
 
-    getNodeData(nodeData.rootNode);
-    getNodes(nodeData.rootNode);
+    /* images inside the model file are not decoded, the image loader skips them */
+    const std::string& uri = mModel->images.at(imageNum).uri;
+    if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+    {
+        Logger::log(1, "%s: image of material %i is embedded, using the model texture\n", __FUNCTION__, material);
+        return 0;
+    }
 
-    nodeData.nodeList.resize(mNodeCount);
-    nodeData.nodeList.at(rootNodeNum) = nodeData.rootNode;
-    getNodeList(nodeData.nodeList, rootNodeNum);
+    std::string textureFilename = (std::filesystem::path(mModelFilename).parent_path() / uri).string();
+    if (!std::filesystem::exists(textureFilename))
+    {
+        Logger::log(1, "%s: image '%s' of material %i not found, using the model texture\n", __FUNCTION__,
+            textureFilename.c_str(), material);
+        return 0;
+    }
 
-    return nodeData;
+    auto fileIter = std::find(mTextureFiles.begin() + 1, mTextureFiles.end(), textureFilename);
+    if (fileIter != mTextureFiles.end())
+    {
+        return static_cast<int>(fileIter - mTextureFiles.begin());
+    }
+    mTextureFiles.push_back(textureFilename);
+    return static_cast<int>(mTextureFiles.size() - 1);
 }
 
-void GltfModel::getJointData()
+void GltfModel::getAnimations(ThreadPool* threadPool)
 {
-    std::string jointsAccessorAttrib = "JOINTS_0";
-    int jointsAccessor = mModel->meshes.at(0).primitives.at(0).attributes.at(jointsAccessorAttrib);
-    Logger::log(1, "%s: using accessor %i to get %s\n", __FUNCTION__, jointsAccessor, jointsAccessorAttrib.c_str());
-
-    const tinygltf::Accessor& accessor = mModel->accessors.at(jointsAccessor);
-    const tinygltf::BufferView& bufferView = mModel->bufferViews.at(accessor.bufferView);
-    const tinygltf::Buffer& buffer = mModel->buffers.at(bufferView.buffer);
+    /* every channel of every clip is loaded on its own, the channels only read the model and the buffers */
+    struct ChannelJob
+    {
+        size_t clip;
+        const tinygltf::AnimationChannel* channel;
+        std::shared_ptr<GltfAnimationChannel> result;
+        float loadTime;
+    };
+    std::vector<ChannelJob> channelJobs{};
+
+    mAnimClips.clear();
+    for (size_t i = 0; i < mModel->animations.size(); ++i)
+    {
+        const tinygltf::Animation& anim = mModel->animations.at(i);
+        if (mLazyClips)
+        {
+            /* only the length is read now, from the last timing of the first channel */
+            float endTime = 0.0f;
+            if (!anim.channels.empty())
+            {
+                GltfAccessorView<float> timings(*mModel, *mBufferData, anim.samplers.at(anim.channels.at(0).sampler).input);
+                endTime = timings.size() > 0 ? timings[timings.size() - 1] : 0.0f;
+            }
+
+            std::shared_ptr<tinygltf::Model> model = mModel;
+            std::shared_ptr<GltfBufferData> bufferData = mBufferData;
+            mAnimClips.push_back(std::make_shared<GltfAnimationClip>(anim.name,
+                [model, bufferData, i](GltfAnimationClip& clip)
+                {
+                    const tinygltf::Animation& clipAnim = model->animations.at(i);
+                    for (const auto& channel : clipAnim.channels)
+                    {
+                        clip.addChannel(*model, bufferData, clipAnim, channel);
+                    }
+                    return true;
+                }, endTime));
+            continue;
+        }
 
-    int jointVecSize = accessor.count;
-    Logger::log(1, "%s: %i short vec4 in JOINTS_0\n", __FUNCTION__, jointVecSize);
-    mJointVec.resize(jointVecSize);
+        mAnimClips.push_back(std::make_shared<GltfAnimationClip>(anim.name));
+        for (const auto& channel : anim.channels)
+        {
+            channelJobs.push_back({ i, &channel, nullptr, 0.0f });
+        }
+    }
 
-    std::memcpy(mJointVec.data(), &buffer.data.at(0) + bufferView.byteOffset, bufferView.byteLength);
+    if (mLazyClips)
+    {
+        Logger::log(1, "%s: %i clips are loaded on first use\n", __FUNCTION__, mAnimClips.size());
+        return;
+    }
 
-    mNodeToJoint.resize(mModel->nodes.size());
+    auto loadChannel = [this, &channelJobs](size_t index)
+    {
+        /* keyframes used in place take less than the microsecond the Timer resolves */
+        ChannelJob& job = channelJobs.at(index);
+        auto startTime = std::chrono::steady_clock::now();
+        job.result = std::make_shared<GltfAnimationChannel>();
+        job.result->loadChannelData(*mModel, mBufferData, mModel->animations.at(job.clip), *job.channel);
+        job.loadTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    };
+    if (threadPool)
+    {
+        threadPool->parallelFor(channelJobs.size(), loadChannel);
+    }
+    else
+    {
+        for (size_t i = 0; i < channelJobs.size(); ++i)
+        {
+            loadChannel(i);
+        }
+    }
 
-    const tinygltf::Skin& skin = mModel->skins.at(0);
-    for (int i = 0; i < skin.joints.size(); ++i)
+    /* the channels keep the order of the file, the time of a clip is the sum of its channels */
+    std::vector<float> clipTimes(mAnimClips.size(), 0.0f);
+    for (const auto& job : channelJobs)
     {
-        int destinationNode = skin.joints.at(i);
-        mNodeToJoint.at(destinationNode) = i;
-        Logger::log(2, "%s: joint %i affects node %i\n", __FUNCTION__, i, destinationNode);
+        mAnimClips.at(job.clip)->addChannel(job.result);
+        clipTimes.at(job.clip) += job.loadTime;
+    }
+    for (size_t i = 0; i < mAnimClips.size(); ++i)
+    {
+        Logger::log(1, "%s: loaded animation '%s' with %i channels in %.3f ms\n", __FUNCTION__,
+            mAnimClips.at(i)->getClipName().c_str(), mModel->animations.at(i).channels.size(), clipTimes.at(i));
     }
 }
 
-void GltfModel::getWeightData() 
+void GltfModel::bakeAnimations(OGLRenderData& renderData)
 {
-    std::string weightsAccessorAttrib = "WEIGHTS_0";
-    int weightAccessor = mModel->meshes.at(0).primitives.at(0).attributes.at(weightsAccessorAttrib);
-    Logger::log(1, "%s: using accessor %i to get %s\n", __FUNCTION__, weightAccessor, weightsAccessorAttrib.c_str());
+    mBakedJointMatrices.clear();
+    mBakedClips.clear();
+    mBakedFrameRate = renderData.rdBakeFrameRate;
+    if (mAnimClips.empty() || mBakedFrameRate <= 0.0f)
+    {
+        return;
+    }
+
+    /* own node tree with the root at the origin, the crowd shader adds the instance position and rotation */
+    GltfNodeData nodeData = getGltfNodes();
+    std::vector<bool> fullMask(mNodeCount, true);
+    const std::vector<int32_t>& skinJoints = mSkinJoints;
+    size_t jointCount = mInverseBindMatrices.size();
+
+    for (const auto& clip : mAnimClips)
+    {
+        /* sampling loads a lazy clip, it is dropped again afterwards so only the used clips stay decoded */
+        bool wasLoaded = clip->isLoaded();
 
-    const tinygltf::Accessor& accessor = mModel->accessors.at(weightAccessor);
-    const tinygltf::BufferView& bufferView = mModel->bufferViews.at(accessor.bufferView);
-    const tinygltf::Buffer& buffer = mModel->buffers.at(bufferView.buffer);
+        GltfBakedClip bakedClip{};
+        bakedClip.firstFrame = mBakedJointMatrices.size() / jointCount;
+        bakedClip.duration = clip->getClipEndTime();
+        /* one extra frame, so the last interval ends exactly at the clip end */
+        bakedClip.frameCount = static_cast<int>(std::ceil(bakedClip.duration * mBakedFrameRate)) + 1;
 
-    int weightVecSize = accessor.count;
-    Logger::log(1, "%s: %i vec4 in WEIGHTS_0\n", __FUNCTION__, weightVecSize);
-    mWeightVec.resize(weightVecSize);
+        for (int frame = 0; frame < bakedClip.frameCount; ++frame)
+        {
+            float time = std::min(frame / mBakedFrameRate, bakedClip.duration);
+            clip->setAnimationFrame(nodeData.nodeList, fullMask, time);
+            nodeData.rootNode->updateNodeAndChildMatrices();
+
+            for (size_t joint = 0; joint < jointCount; ++joint)
+            {
+                mBakedJointMatrices.push_back(nodeData.nodeList.at(skinJoints.at(joint))->getNodeMatrix() *
+                    mInverseBindMatrices.at(joint));
+            }
+        }
+        mBakedClips.push_back(bakedClip);
+
+        if (clip->isLazy() && !wasLoaded)
+        {
+            clip->unload();
+            clip->checkUsed();
+        }
+    }
 
-    std::memcpy(mWeightVec.data(), &buffer.data.at(0) + bufferView.byteOffset, bufferView.byteLength);
+    renderData.rdBakedAnimationBytes = mBakedJointMatrices.size() * sizeof(glm::mat4);
+    Logger::log(1, "%s: baked %i clips at %.0f fps, %i frames, %i bytes\n", __FUNCTION__, mBakedClips.size(),
+        mBakedFrameRate, mBakedJointMatrices.size() / jointCount, renderData.rdBakedAnimationBytes);
 }
 
-void GltfModel::getInvBindMatrices()
+bool GltfModel::hasBakedAnimations()
 {
-    const tinygltf::Skin& skin = mModel->skins.at(0);
-    int invBindMatAccessor = skin.inverseBindMatrices;
+    return !mBakedClips.empty();
+}
 
-    const tinygltf::Accessor& accessor = mModel->accessors.at(invBindMatAccessor);
-    const tinygltf::BufferView& bufferView = mModel->bufferViews.at(accessor.bufferView);
-    const tinygltf::Buffer& buffer = mModel->buffers.at(bufferView.buffer);
+const std::vector<glm::mat4>& GltfModel::getBakedJointMatrices()
+{
+    return mBakedJointMatrices;
+}
 
-    mInverseBindMatrices.resize(skin.joints.size());
+std::vector<GltfBakedClip> GltfModel::getBakedClips()
+{
+    return mBakedClips;
+}
 
-    std::memcpy(mInverseBindMatrices.data(), &buffer.data.at(0) + bufferView.byteOffset, bufferView.byteLength);
+float GltfModel::getBakedFrameRate()
+{
+    return mBakedFrameRate;
 }
 
-void GltfModel::getAnimations() 
+void GltfModel::createSkeletonBuffers()
 {
-    for (const auto& anim : mModel->animations) 
+    std::vector<bool> isJoint(mNodeCount, false);
+    for (const int jointNode : mSkinJoints)
     {
-        Logger::log(1, "%s: loading animation '%s' with %i channels\n", __FUNCTION__, anim.name.c_str(), anim.channels.size());
-        std::shared_ptr<GltfAnimationClip> clip = std::make_shared<GltfAnimationClip>(anim.name);
-        for (const auto& channel : anim.channels)
+        isJoint.at(jointNode) = true;
+    }
+
+    /* one bone for every parent/child pair where both nodes are joints, between their first palette entries */
+    std::vector<glm::ivec2> bones{};
+    for (int joint = 0; joint < mSkinJoints.size(); ++joint)
+    {
+        int jointNode = mSkinJoints.at(joint);
+        if (mNodeToJoint.at(jointNode) != joint)
         {
-            clip->addChannel(mModel, anim, channel);
+            continue;
+        }
+        const GltfCookedNode& node = mNodes.at(jointNode);
+        for (uint32_t i = node.firstChild; i < node.firstChild + node.childCount; ++i)
+        {
+            int childNode = mNodeChildren.at(i);
+            if (isJoint.at(childNode))
+            {
+                bones.emplace_back(mNodeToJoint.at(jointNode), mNodeToJoint.at(childNode));
+            }
         }
-        mAnimClips.push_back(clip);
     }
+    mSkeletonBoneCount = bones.size();
+
+    /* palette * bind position gives the current world position of the joint */
+    std::vector<glm::vec4> bindPositions(mInverseBindMatrices.size());
+    for (size_t i = 0; i < mInverseBindMatrices.size(); ++i)
+    {
+        bindPositions.at(i) = glm::inverse(mInverseBindMatrices.at(i)) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    glGenBuffers(1, &mSkeletonBoneBuffer);
+    OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSkeletonBoneBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bones.size() * sizeof(glm::ivec2), bones.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &mSkeletonBindPosBuffer);
+    OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSkeletonBindPosBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bindPositions.size() * sizeof(glm::vec4), bindPositions.data(), GL_STATIC_DRAW);
+    OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    /* no vertex attributes, but the core profile needs a VAO to draw */
+    glGenVertexArrays(1, &mSkeletonVAO);
+
+    Logger::log(1, "%s: created GPU skeleton with %i bones\n", __FUNCTION__, mSkeletonBoneCount);
+}
+
+int GltfModel::getSkeletonBoneCount()
+{
+    return mSkeletonBoneCount;
 }
 
 std::vector<std::shared_ptr<GltfAnimationClip>> GltfModel::getAnimClips()
@@ -175,12 +1617,13 @@ std::vector<std::shared_ptr<GltfAnimationClip>> GltfModel::getAnimClips()
 void GltfModel::getNodes(std::shared_ptr<GltfNode> treeNode)
 {
     int nodeNum = treeNode->getNodeNum();
-    std::vector<int> childNodes = mModel->nodes.at(nodeNum).children;
+    const GltfCookedNode& node = mNodes.at(nodeNum);
+    std::vector<int> childNodes(mNodeChildren.begin() + node.firstChild, mNodeChildren.begin() + node.firstChild + node.childCount);
 
     /* remove the child node with skin/mesh metadata, confuses skeleton */
     auto removeIt = std::remove_if(childNodes.begin(), childNodes.end(), [&](int num) 
     { 
-        return mModel->nodes.at(num).skin != -1; 
+        return mNodes.at(num).skin != -1; 
     });
 
     childNodes.erase(removeIt, childNodes.end());
@@ -216,38 +1659,20 @@ std::vector<int> GltfModel::getNodeToJoint()
     return mNodeToJoint;
 }
 
+std::vector<int> GltfModel::getNextNodeJoints()
+{
+    return mNextNodeJoint;
+}
+
 void GltfModel::getNodeData(std::shared_ptr<GltfNode> treeNode) 
 {
     int nodeNum = treeNode->getNodeNum();
-    const tinygltf::Node& node = mModel->nodes.at(nodeNum);
-    treeNode->setNodeName(node.name);
-
-    if (node.translation.size()) 
-    {
-        treeNode->setTranslation(glm::make_vec3(node.translation.data()));
-    }
-    else 
-    {
-        treeNode->setTranslation(glm::vec3(0.0f));
-    }
-
-    if (node.rotation.size()) 
-    {
-       treeNode->setRotation(glm::make_quat(node.rotation.data()));
-    }
-    else 
-    {
-        treeNode->setRotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
-    }
+    const GltfCookedNode& node = mNodes.at(nodeNum);
+    treeNode->setNodeName(&mNames.at(node.nameOffset));
 
-    if (node.scale.size()) 
-    {
-        treeNode->setScale(glm::make_vec3(node.scale.data()));
-    }
-    else 
-    {
-        treeNode->setScale(glm::vec3(1.0f));
-    }
+    treeNode->setTranslation(glm::make_vec3(node.translation));
+    treeNode->setRotation(glm::make_quat(node.rotation));
+    treeNode->setScale(glm::make_vec3(node.scale));
 
     treeNode->calculateNodeMatrix();
 }
@@ -264,180 +1689,371 @@ void GltfModel::resetNodeData(std::shared_ptr<GltfNode> treeNode)
 
 void GltfModel::createVertexBuffers()
 {
-    const tinygltf::Primitive& primitives = mModel->meshes.at(0).primitives.at(0);
-    mVertexVBO.resize(primitives.attributes.size());
-    mAttribAccessors.resize(primitives.attributes.size());
+    /* one buffer per attribute, filled from the merged vertex arrays */
+    mVertexVBO.resize(attributes.size());
+    glGenBuffers(mVertexVBO.size(), mVertexVBO.data());
 
-    for (const auto& attrib : primitives.attributes) 
+    auto setAttribute = [&](const std::string& name, GLint size, GLenum type)
     {
-        const std::string attribType = attrib.first;
-        const int accessorNum = attrib.second;
+        OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO.at(attributes.at(name)));
+        glVertexAttribPointer(attributes.at(name), size, type, GL_FALSE, 0, (void*)0);
+        glEnableVertexAttribArray(attributes.at(name));
+    };
+    setAttribute("POSITION", 3, GL_FLOAT);
+    setAttribute("NORMAL", 3, GL_FLOAT);
+    setAttribute("TEXCOORD_0", 2, GL_FLOAT);
+    setAttribute("JOINTS_0", 4, GL_UNSIGNED_SHORT);
+    setAttribute("WEIGHTS_0", 4, GL_FLOAT);
+
+    OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+    Logger::log(1, "%s: created buffers for %i vertices\n", __FUNCTION__, mPositions.size());
+}
 
-        const tinygltf::Accessor& accessor = mModel->accessors.at(accessorNum);
-        const tinygltf::BufferView& bufferView = mModel->bufferViews.at(accessor.bufferView);
-        const tinygltf::Buffer& buffer = mModel->buffers.at(bufferView.buffer);
+void GltfModel::generateLods(OGLRenderData& renderData)
+{
+    /* box of all merged positions, good enough as bounding sphere for the LOD selection */
+    glm::vec3 minPos = mPositions.at(0);
+    glm::vec3 maxPos = mPositions.at(0);
+    for (const glm::vec3& position : mPositions)
+    {
+        minPos = glm::min(minPos, position);
+        maxPos = glm::max(maxPos, position);
+    }
+    mBoundingSphere = glm::vec4((minPos + maxPos) * 0.5f, glm::length(maxPos - minPos) * 0.5f);
 
-        if ((attribType.compare("POSITION") != 0) && (attribType.compare("NORMAL") != 0) && (attribType.compare("TEXCOORD_0") != 0) && (attribType.compare("JOINTS_0") != 0) && (attribType.compare("WEIGHTS_0") != 0)) {
-            Logger::log(1, "%s: skipping attribute type %s\n", __FUNCTION__, attribType.c_str());
-            continue;
+    /* all levels share one 32 bit index buffer, level 0 is the merged mesh from mergeMeshes */
+    mIndexType = GL_UNSIGNED_INT;
+    mLodLevels.resize(1);
+
+    if (!renderData.rdGenerateLods)
+    {
+        return;
+    }
+
+    /* every material range is simplified on its own, the borders between the materials stay where they are */
+    for (int level = 1; level < mMaxLodLevels; ++level)
+    {
+        std::vector<GltfMeshRange> previousRanges = mLodLevels.back().ranges;
+        GltfLodLevel lodLevel{ mLodIndexData.size(), 0, 0.0f, {} };
+        std::vector<uint32_t> levelIndices{};
+        bool simplifiedRange = false;
+
+        for (const GltfMeshRange& range : previousRanges)
+        {
+            std::vector<uint32_t> lodIndices(mLodIndexData.begin() + range.indexOffset,
+                mLodIndexData.begin() + range.indexOffset + range.indexCount);
+            size_t targetIndexCount = (lodIndices.size() / 2) / 3 * 3;
+            float error = 0.0f;
+            std::vector<uint32_t> simplified = MeshSimplifier::simplify(lodIndices, mPositions, mJointVec, mWeightVec,
+                targetIndexCount, mLodMaxWeightDistance, error);
+
+            /* locked seams and weight borders can stop the simplification early, the range keeps its last level */
+            if (!simplified.empty() && simplified.size() <= lodIndices.size() * 9 / 10)
+            {
+                std::vector<uint32_t> clusterStarts{};
+                lodIndices = MeshOptimizer::optimizeVertexCache(simplified, mPositions.size(), clusterStarts);
+                lodLevel.error = std::max(lodLevel.error, error);
+                simplifiedRange = true;
+            }
+
+            lodLevel.ranges.push_back({ lodLevel.indexOffset + levelIndices.size(), static_cast<int>(lodIndices.size()),
+                range.texture });
+            levelIndices.insert(levelIndices.end(), lodIndices.begin(), lodIndices.end());
         }
 
-        Logger::log(1, "%s: data for %s uses accessor %i\n", __FUNCTION__, attribType.c_str(), accessorNum);
-        if (attribType.compare("POSITION") == 0)
+        if (!simplifiedRange)
         {
-            int numPositionEntries = accessor.count;
-            Logger::log(1, "%s: loaded %i vertices from glTF file\n", __FUNCTION__, numPositionEntries);
+            Logger::log(1, "%s: LOD %i stalled at %i triangles, stopping\n", __FUNCTION__, level, levelIndices.size() / 3);
+            break;
         }
 
-        mAttribAccessors.at(attributes.at(attribType)) = accessorNum;
+        lodLevel.indexCount = static_cast<int>(levelIndices.size());
+        mLodIndexData.insert(mLodIndexData.end(), levelIndices.begin(), levelIndices.end());
+        mLodLevels.push_back(lodLevel);
+
+        Logger::log(1, "%s: LOD %i has %i triangles, error %f\n", __FUNCTION__, level, levelIndices.size() / 3,
+            lodLevel.error);
+    }
+
+    renderData.rdLodLevels = mLodLevels.size();
+}
+
+int GltfModel::getLodCount()
+{
+    return mLodLevels.size();
+}
+
+int GltfModel::getLodTriangleCount(int lod)
+{
+    return mLodLevels.at(lod).indexCount / 3;
+}
+
+glm::vec4 GltfModel::getBoundingSphere()
+{
+    return mBoundingSphere;
+}
+
+void GltfModel::optimizeMesh(OGLRenderData& renderData)
+{
+    std::vector<uint32_t>& indices = mLodIndexData;
+    size_t vertexCount = mPositions.size();
+
+    MeshCacheStats before = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
 
-        int dataSize = 1;
-        switch (accessor.type) 
+    /* triangle order per material range, no triangle moves to another material */
+    size_t clusterCount = 0;
+    for (const GltfMeshRange& range : mLodLevels.at(0).ranges)
+    {
+        std::vector<uint32_t> rangeIndices(indices.begin() + range.indexOffset,
+            indices.begin() + range.indexOffset + range.indexCount);
+        std::vector<uint32_t> clusterStarts{};
+        rangeIndices = MeshOptimizer::optimizeVertexCache(rangeIndices, vertexCount, clusterStarts);
+        rangeIndices = MeshOptimizer::optimizeOverdraw(rangeIndices, clusterStarts, mPositions);
+        std::copy(rangeIndices.begin(), rangeIndices.end(), indices.begin() + range.indexOffset);
+        clusterCount += clusterStarts.size();
+    }
+    /* the vertices of the ranges do not overlap, the fetch order of the whole buffer keeps the ranges apart */
+    std::vector<uint32_t> remap = MeshOptimizer::optimizeVertexFetch(indices, vertexCount);
+
+    /* move every vertex attribute to its new position */
+    auto reorder = [&](auto& attribute)
+    {
+        std::decay_t<decltype(attribute)> reordered(attribute.size());
+        for (size_t i = 0; i < attribute.size(); ++i)
         {
-        case TINYGLTF_TYPE_SCALAR:
-            dataSize = 1;
-            break;
-        case TINYGLTF_TYPE_VEC2:
-            dataSize = 2;
-            break;
-        case TINYGLTF_TYPE_VEC3:
-            dataSize = 3;
-            break;
-        case TINYGLTF_TYPE_VEC4:
-            dataSize = 4;
-            break;
-        default:
-            Logger::log(1, "%s error: accessor %i uses data size %i\n", __FUNCTION__, accessorNum, accessor.type);
-            break;
+            reordered.at(remap.at(i)) = attribute.at(i);
         }
+        attribute.swap(reordered);
+    };
+    reorder(mPositions);
+    reorder(mNormals);
+    reorder(mUVs);
+    reorder(mJointVec);
+    reorder(mWeightVec);
+
+    MeshCacheStats after = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+
+    renderData.rdMeshACMRBefore = before.acmr;
+    renderData.rdMeshACMRAfter = after.acmr;
+    renderData.rdMeshATVRBefore = before.atvr;
+    renderData.rdMeshATVRAfter = after.atvr;
+
+    Logger::log(1, "%s: %i clusters, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", __FUNCTION__, clusterCount,
+        before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+bool GltfModel::packVertices()
+{
+    if (mInverseBindMatrices.size() > 256)
+    {
+        Logger::log(1, "%s: %i joints do not fit into 8 bit, using unpacked vertices\n", __FUNCTION__, mInverseBindMatrices.size());
+        return false;
+    }
+
+    int vertexCount = mPositions.size();
 
-        GLuint dataType = GL_FLOAT;
-        switch (accessor.componentType)
+    /* unorm16 cannot hold wrapping texture coordinates */
+    for (const auto& uv : mUVs)
+    {
+        if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f)
         {
-        case TINYGLTF_COMPONENT_TYPE_FLOAT:
-            dataType = GL_FLOAT;
-            break;
-        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            dataType = GL_UNSIGNED_SHORT;
-            break;
-        default:
-            Logger::log(1, "%s error: accessor %i uses unknown data type %i\n", __FUNCTION__, accessorNum, accessor.componentType);
-            break;
+            Logger::log(1, "%s: texture coordinates outside [0, 1], using unpacked vertices\n", __FUNCTION__);
+            return false;
         }
+    }
 
-        /* buffers for position, normal and tex coordinates */
-        glGenBuffers(1, &mVertexVBO.at(attributes.at(attribType)));
-        glBindBuffer(GL_ARRAY_BUFFER, mVertexVBO.at(attributes.at(attribType)));
+    mPackedVertexData.resize(vertexCount);
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        GltfPackedVertex& vertex = mPackedVertexData.at(i);
+        vertex.position = mPositions.at(i);
+        vertex.normal = packOctNormal(mNormals.at(i));
+        vertex.uv = glm::tvec2<uint16_t>(
+            static_cast<uint16_t>(std::round(mUVs.at(i).x * 65535.0f)),
+            static_cast<uint16_t>(std::round(mUVs.at(i).y * 65535.0f)));
+        vertex.joints = glm::tvec4<uint8_t>(mJointVec.at(i).x, mJointVec.at(i).y, mJointVec.at(i).z, mJointVec.at(i).w);
+        vertex.weights = packWeights(mWeightVec.at(i));
+    }
+    mVertexDataSize = mPackedVertexData.size() * sizeof(GltfPackedVertex);
 
-        glVertexAttribPointer(attributes.at(attribType), dataSize, dataType, GL_FALSE, 0, (void*)0);
-        glEnableVertexAttribArray(attributes.at(attribType));
+    Logger::log(1, "%s: packed %i vertices into %i bytes each\n", __FUNCTION__, vertexCount, sizeof(GltfPackedVertex));
+    return true;
+}
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+void GltfModel::createPackedVertexBuffer()
+{
+    /* one interleaved buffer for all attributes */
+    mVertexVBO.resize(1);
+    glGenBuffers(1, &mVertexVBO.at(0));
+    OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO.at(0));
+
+    GLsizei stride = sizeof(GltfPackedVertex);
+    glVertexAttribPointer(attributes.at("POSITION"), 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GltfPackedVertex, position));
+    glVertexAttribPointer(attributes.at("NORMAL"), 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(GltfPackedVertex, normal));
+    glVertexAttribPointer(attributes.at("TEXCOORD_0"), 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(GltfPackedVertex, uv));
+    glVertexAttribPointer(attributes.at("JOINTS_0"), 4, GL_UNSIGNED_BYTE, GL_FALSE, stride, (void*)offsetof(GltfPackedVertex, joints));
+    glVertexAttribPointer(attributes.at("WEIGHTS_0"), 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(GltfPackedVertex, weights));
+    for (const auto& attrib : attributes)
+    {
+        glEnableVertexAttribArray(attrib.second);
     }
+
+    OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool GltfModel::hasPackedVertices()
+{
+    return mPackedVertices;
+}
+
+size_t GltfModel::getVertexDataSize()
+{
+    return mVertexDataSize;
+}
+
+size_t GltfModel::getUnpackedVertexDataSize()
+{
+    return mUnpackedVertexDataSize;
 }
 
 void GltfModel::createIndexBuffer()
 {
     glGenBuffers(1, &mIndexVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO);
+    OGLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO);
 }
 
-void GltfModel::uploadVertexBuffers() 
+void GltfModel::queueVertexUploads() 
 {
-    for (int i = 0; i < 5; ++i)
+    if (mCookedHeader)
     {
-        const tinygltf::Accessor& accessor = mModel->accessors.at(mAttribAccessors.at(i));
-        const tinygltf::BufferView& bufferView = mModel->bufferViews.at(accessor.bufferView);
-        const tinygltf::Buffer& buffer = mModel->buffers.at(bufferView.buffer);
+        const GltfCookedSection& vertices = mCookedHeader->sections[static_cast<size_t>(GltfCookedSectionType::VERTICES)];
+        queueUpload(GL_ARRAY_BUFFER, mVertexVBO.at(0), getCookedSection(GltfCookedSectionType::VERTICES), vertices.size);
+        return;
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, mVertexVBO.at(i));
-        glBufferData(GL_ARRAY_BUFFER, bufferView.byteLength, &buffer.data.at(0) + bufferView.byteOffset, GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (mPackedVertices)
+    {
+        queueUpload(GL_ARRAY_BUFFER, mVertexVBO.at(0), reinterpret_cast<const unsigned char*>(mPackedVertexData.data()),
+            mPackedVertexData.size() * sizeof(GltfPackedVertex));
+        return;
     }
+
+    auto queueAttribute = [&](const std::string& name, const auto& attribute)
+    {
+        queueUpload(GL_ARRAY_BUFFER, mVertexVBO.at(attributes.at(name)), reinterpret_cast<const unsigned char*>(attribute.data()),
+            attribute.size() * sizeof(attribute.at(0)));
+    };
+    queueAttribute("POSITION", mPositions);
+    queueAttribute("NORMAL", mNormals);
+    queueAttribute("TEXCOORD_0", mUVs);
+    queueAttribute("JOINTS_0", mJointVec);
+    queueAttribute("WEIGHTS_0", mWeightVec);
 }
 
-void GltfModel::uploadIndexBuffer()
+void GltfModel::queueIndexUpload()
 {
-    /* buffer for vertex indices */
-    const tinygltf::Primitive& primitives = mModel->meshes.at(0).primitives.at(0);
-    const tinygltf::Accessor& indexAccessor = mModel->accessors.at(primitives.indices);
-    const tinygltf::BufferView& indexBufferView = mModel->bufferViews.at(indexAccessor.bufferView);
-    const tinygltf::Buffer& indexBuffer = mModel->buffers.at(indexBufferView.buffer);
+    /* the element buffer binding is part of the VAO, bind ours instead of changing the current one */
+    OGLStateCache::bindVertexArray(mVAO);
+
+    if (mCookedHeader)
+    {
+        const GltfCookedSection& indices = mCookedHeader->sections[static_cast<size_t>(GltfCookedSectionType::INDICES)];
+        queueUpload(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO, getCookedSection(GltfCookedSectionType::INDICES), indices.size);
+        return;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferView.byteLength, &indexBuffer.data.at(0) + indexBufferView.byteOffset, GL_STATIC_DRAW);
+    /* merged indices of all primitives, followed by the LOD levels */
+    queueUpload(GL_ELEMENT_ARRAY_BUFFER, mIndexVBO, reinterpret_cast<const unsigned char*>(mLodIndexData.data()),
+        mLodIndexData.size() * sizeof(uint32_t));
 }
 
 int GltfModel::getTriangleCount() 
 {
-    const tinygltf::Primitive& primitives = mModel->meshes.at(0).primitives.at(0);
-    const tinygltf::Accessor& indexAccessor = mModel->accessors.at(primitives.indices);
+    return mLodLevels.at(0).indexCount / 3;
+}
+
+void GltfModel::draw()
+{
+    /* VAO and texture stay bound, the state cache skips them for the next draw of this model */
+    OGLStateCache::bindVertexArray(mVAO);
+    const GltfLodLevel& level = mLodLevels.at(0);
+    size_t indexSize = (mIndexType == GL_UNSIGNED_INT) ? 4 : (mIndexType == GL_UNSIGNED_SHORT ? 2 : 1);
 
-    unsigned int triangles = 0;
-    switch (primitives.mode)
+    /* neighbouring material ranges with the same texture are drawn together */
+    for (size_t i = 0; i < level.ranges.size(); )
     {
-    case TINYGLTF_MODE_TRIANGLES:
-        triangles = indexAccessor.count / 3;
-        break;
-    default:
-        Logger::log(1, "%s error: unknown draw mode %i\n", __FUNCTION__, primitives.mode);
-        break;
+        const GltfMeshRange& range = level.ranges.at(i);
+        int indexCount = 0;
+        for (; i < level.ranges.size() && level.ranges.at(i).texture == range.texture; ++i)
+        {
+            indexCount += level.ranges.at(i).indexCount;
+        }
+
+        mTex.at(range.texture).bind();
+        glDrawElements(mDrawMode, indexCount, mIndexType, (void*)(range.indexOffset * indexSize));
+        OGLStateCache::countDrawCall();
     }
-    return triangles;
 }
 
-void GltfModel::draw()
+void GltfModel::drawInstanced(int instanceCount, int lod, int baseInstance)
 {
-    const tinygltf::Primitive& primitives = mModel->meshes.at(0).primitives.at(0);
-    const tinygltf::Accessor& indexAccessor = mModel->accessors.at(primitives.indices);
-
-    GLuint drawMode = GL_TRIANGLES;
-    switch (primitives.mode)
+    if (instanceCount == 0)
     {
-    case TINYGLTF_MODE_TRIANGLES:
-        drawMode = GL_TRIANGLES;
-        break;
-    default:
-        Logger::log(1, "%s error: unknown draw mode %i\n", __FUNCTION__, primitives.mode);
-        break;
+        return;
     }
 
-    mTex.bind();
-    glBindVertexArray(mVAO);
-    glDrawElements(drawMode, indexAccessor.count, indexAccessor.componentType, nullptr);
-    glBindVertexArray(0);
-    mTex.unbind();
+    OGLStateCache::bindVertexArray(mVAO);
+    const GltfLodLevel& level = mLodLevels.at(lod);
+    size_t indexSize = (mIndexType == GL_UNSIGNED_INT) ? 4 : (mIndexType == GL_UNSIGNED_SHORT ? 2 : 1);
+
+    /* one draw per texture, the shaders add gl_BaseInstance to find the joint palette of the instance */
+    for (size_t i = 0; i < level.ranges.size(); )
+    {
+        const GltfMeshRange& range = level.ranges.at(i);
+        int indexCount = 0;
+        for (; i < level.ranges.size() && level.ranges.at(i).texture == range.texture; ++i)
+        {
+            indexCount += level.ranges.at(i).indexCount;
+        }
+
+        mTex.at(range.texture).bind();
+        glDrawElementsInstancedBaseInstance(mDrawMode, indexCount, mIndexType, (void*)(range.indexOffset * indexSize),
+            instanceCount, baseInstance);
+        OGLStateCache::countDrawCall();
+    }
 }
 
-void GltfModel::drawInstanced(int instanceCount) 
+void GltfModel::drawSkeletonInstanced(int instanceCount)
 {
-    const tinygltf::Primitive& primitives = mModel->meshes.at(0).primitives.at(0);
-    const tinygltf::Accessor& indexAccessor = mModel->accessors.at(primitives.indices);
-
-    GLuint drawMode = GL_TRIANGLES;
-    switch (primitives.mode)
+    if (instanceCount == 0 || mSkeletonBoneCount == 0)
     {
-    case TINYGLTF_MODE_TRIANGLES:
-        drawMode = GL_TRIANGLES;
-        break;
-    default:
-        Logger::log(1, "%s error: unknown draw mode %i\n", __FUNCTION__, primitives.mode);
-        break;
+        return;
     }
 
-    mTex.bind();
-    glBindVertexArray(mVAO);
-    glDrawElementsInstanced(drawMode, indexAccessor.count, indexAccessor.componentType, nullptr, instanceCount);
-    glBindVertexArray(0);
-    mTex.unbind();
-}
+    OGLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mSkeletonBoneBuffer);
+    OGLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mSkeletonBindPosBuffer);
 
+    OGLStateCache::bindVertexArray(mSkeletonVAO);
+    glDrawArraysInstanced(GL_LINES, 0, mSkeletonBoneCount * 2, instanceCount);
+    OGLStateCache::countDrawCall();
+}
 
 void GltfModel::cleanup() 
 {
     glDeleteBuffers(mVertexVBO.size(), mVertexVBO.data());
-    glDeleteBuffers(1, &mVAO);
+    glDeleteVertexArrays(1, &mVAO);
     glDeleteBuffers(1, &mIndexVBO);
-    mTex.cleanup();
+    glDeleteBuffers(1, &mSkeletonBoneBuffer);
+    glDeleteBuffers(1, &mSkeletonBindPosBuffer);
+    glDeleteVertexArrays(1, &mSkeletonVAO);
+    for (Texture& texture : mTex)
+    {
+        texture.cleanup();
+    }
+    /* the names of the buffers and VAOs may be reused by the next model */
+    OGLStateCache::invalidate();
+    mPendingUploads.clear();
+    mBufferData.reset();
     mModel.reset();
+    /* mCookedFile stays unless it was released, the clips of the instances still use its keyframes */
 }
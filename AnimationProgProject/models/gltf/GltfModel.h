@@ -6,14 +6,69 @@
 #include <map>
 #include <glad/glad.h>
 #include <tiny_gltf.h>
-#include <mainRenderer/OGLRenderData.h>
+#include <MainRenderer/OGLRenderData.h>
 #include <textures/Texture.h>
+#include <ThreadPool.h>
 
 #include "GltfNode.h"
+#include "GltfBufferData.h"
+#include "GltfCookedFormat.h"
 #include "../animations/GltfAnimationClip.h"
 
 
 
+/* interleaved and quantized skinned vertex, 28 instead of 56 bytes:
+   octahedral normal (snorm16), uv (unorm16), joints (u8), weights (unorm8) */
+struct GltfPackedVertex {
+    glm::vec3 position;
+    glm::tvec2<int16_t> normal;
+    glm::tvec2<uint16_t> uv;
+    glm::tvec4<uint8_t> joints;
+    glm::tvec4<uint8_t> weights;
+};
+
+/* triangles of one material inside a LOD level, drawn with the texture of the material */
+struct GltfMeshRange {
+    size_t indexOffset;
+    int indexCount;
+    int texture;
+};
+
+/* one simplified index range inside the shared LOD index buffer, the material ranges lie back to back in it */
+struct GltfLodLevel {
+    size_t indexOffset;
+    int indexCount;
+    float error;
+    std::vector<GltfMeshRange> ranges;
+};
+
+/* animation clip sampled into joint matrices at a fixed frame rate, frames are stored back to back */
+struct GltfBakedClip {
+    int firstFrame;
+    int frameCount;
+    float duration;
+};
+
+/* buffer range or texture rows waiting for the upload on the render thread */
+struct GltfPendingUpload {
+    GLenum target;  /* GL_TEXTURE_2D for a texture, uploaded in whole rows, the buffer is the texture number */
+    GLuint buffer;
+    const unsigned char* data;
+    size_t size;
+    size_t uploaded;
+};
+
+/* lazy clips resident in memory, and how often clips were loaded and dropped */
+struct GltfClipStats {
+    unsigned int clipCount = 0;
+    unsigned int residentCount = 0;
+    size_t residentBytes = 0;
+    unsigned int loads = 0;
+    unsigned int evictions = 0;
+    unsigned int streamedCount = 0;
+    unsigned int streamMisses = 0;
+};
+
 struct GltfNodeData {
     std::shared_ptr<GltfNode> rootNode;
     std::vector<std::shared_ptr<GltfNode>> nodeList;
@@ -21,10 +76,38 @@ struct GltfNodeData {
 
 class GltfModel {
 public:
+    /* .glb and .gltf files are imported, .apmodel files are mapped and the texture file is not used */
     bool loadModel(OGLRenderData& renderData, std::string modelFilename, std::string textureFilename);
+
+    /* loadModel in steps for the async loader: prepareModel runs on a worker thread without GL calls,
+       createModelBuffers and uploadModelData on the render thread */
+    bool prepareModel(OGLRenderData& renderData, std::string modelFilename, std::string textureFilename,
+        ThreadPool* threadPool = nullptr);
+    void createModelBuffers();
+    /* uploads pending vertex, index and texture data up to the budget (0 uploads all), returns the uploaded bytes */
+    size_t uploadModelData(size_t byteBudget);
+    bool isUploaded();
+    size_t getUploadBytes();
+    size_t getUploadedBytes();
+    std::vector<OGLTextureInfo> getTextureInfos();
+    /* vertex, index and texture memory on the GPU, for the asset registry budget */
+    size_t getGpuBytes();
+    /* resident memory freed by dropping the source data after the upload, 0 if it is kept */
+    size_t getReleasedBytes();
+
+    /* CPU part of the loaders, no GL calls, used by the asset cooker, the pool loads the clip channels in parallel */
+    bool importModel(OGLRenderData& renderData, std::string modelFilename, ThreadPool* threadPool = nullptr);
+    bool mapCookedModel(OGLRenderData& renderData, std::string cookedFilename);
+    /* writes an imported model and its decoded texture in the cooked layout */
+    bool saveCookedModel(OGLRenderData& renderData, std::string cookedFilename, std::string textureFilename);
+    static bool isCookedModel(std::string modelFilename);
     
     void draw();
-    void drawInstanced(int instanceCount);
+    void drawInstanced(int instanceCount, int lod = 0, int baseInstance = 0);
+
+    /* skeleton lines are pulled from the joint palette in the vertex shader */
+    void drawSkeletonInstanced(int instanceCount);
+    int getSkeletonBoneCount();
     
     void cleanup();
 
@@ -34,24 +117,66 @@ public:
     GltfNodeData getGltfNodes();
     int getTriangleCount();
 
-    void uploadVertexBuffers();
-    void uploadIndexBuffer();
+    int getLodCount();
+    int getLodTriangleCount(int lod);
+    /* xyz is the center, w the radius, in model space */
+    glm::vec4 getBoundingSphere();
+
+    bool hasPackedVertices();
+    size_t getVertexDataSize();
+    size_t getUnpackedVertexDataSize();
 
     std::vector<glm::mat4> getInverseBindMatrices();
     std::vector<int> getNodeToJoint();
+    /* next palette entry of the same node, -1 at the end, nodes with one bind pose per skin have several */
+    std::vector<int> getNextNodeJoints();
 
     std::vector<std::shared_ptr<GltfAnimationClip>> getAnimClips();
 
+    /* lazy clips (rdLazyClips) are created on first use, unused ones are dropped above the budget */
+    void setClipMemoryBudget(size_t bytes);
+    /* call once per frame, after the instances were animated */
+    void collectClips();
+    GltfClipStats getClipStats();
+
+    /* baked joint matrices of all clips, model space, for crowds animated by the vertex shader */
+    bool hasBakedAnimations();
+    const std::vector<glm::mat4>& getBakedJointMatrices();
+    std::vector<GltfBakedClip> getBakedClips();
+    float getBakedFrameRate();
+
     void resetNodeData(std::shared_ptr<GltfNode> treeNode);
 
 private:
+    /* .glb files are mapped, the BIN chunk is used in place instead of being copied by tinygltf */
+    bool loadBinaryModel(tinygltf::TinyGLTF& gltfLoader, std::string modelFilename, std::string& loaderErrors,
+        std::string& loaderWarnings);
+
+    const unsigned char* getCookedSection(GltfCookedSectionType type);
+    void queueUpload(GLenum target, GLuint buffer, const unsigned char* data, size_t size);
+    void queueVertexUploads();
+    void queueIndexUpload();
+    /* drops tinygltf, the glTF buffers and the cooked file, the clips copy their keyframes first */
+    void releaseSourceData();
+
+    void optimizeMesh(OGLRenderData& renderData);
+    void generateLods(OGLRenderData& renderData);
     void createVertexBuffers();
+    bool packVertices();
+    void createPackedVertexBuffer();
     void createIndexBuffer();
 
-    void getJointData();
-    void getWeightData();
-    void getInvBindMatrices();
-    void getAnimations();
+    void getSkeleton();
+    void createNodeToJoint(const std::vector<int32_t>& skinJoints);
+    /* all triangle primitives of all mesh nodes into one vertex and index range, sorted by material and skin,
+       one index range per material, all skins into one palette */
+    bool mergeMeshes();
+    /* base color image of the material if it is a file next to the model, 0 (the loadModel texture) otherwise */
+    int getMaterialTexture(int material);
+    std::vector<bool> getReachableNodes();
+    void getAnimations(ThreadPool* threadPool);
+    void bakeAnimations(OGLRenderData& renderData);
+    void createSkeletonBuffers();
     void getNodes(std::shared_ptr<GltfNode> treeNode);
     void getNodeData(std::shared_ptr<GltfNode> treeNode);
     std::vector<std::shared_ptr<GltfNode>> getNodeList(std::vector<std::shared_ptr<GltfNode>>
@@ -61,20 +186,85 @@ private:
     int mNodeCount = 0;
 
     std::shared_ptr<tinygltf::Model> mModel = nullptr;
+    std::shared_ptr<GltfBufferData> mBufferData = nullptr;
+
+    /* cooked models are used in place, the vertex, index, keyframe and texture data is never copied */
+    std::shared_ptr<MappedFile> mCookedFile = nullptr;
+    const GltfCookedHeader* mCookedHeader = nullptr;
+
+    /* node tree and skin in the cooked layout, filled by both loaders */
+    int mRootNode = 0;
+    std::vector<GltfCookedNode> mNodes{};
+    std::vector<int32_t> mNodeChildren{};
+    std::vector<char> mNames{};
+    std::vector<int32_t> mSkinJoints{};
+    GLenum mDrawMode = GL_TRIANGLES;
 
+    /* merged vertices of every primitive, sorted by material and skin, the joints index the combined palette */
+    std::vector<glm::vec3> mPositions{};
+    std::vector<glm::vec3> mNormals{};
+    std::vector<glm::vec2> mUVs{};
     std::vector<glm::tvec4<uint16_t>> mJointVec{};
     std::vector<glm::vec4> mWeightVec{};
     std::vector<glm::mat4> mInverseBindMatrices{};
 
-    std::vector<int> mAttribAccessors{};
+    /* first palette entry of every node, -1 for nodes that are not joints */
     std::vector<int> mNodeToJoint{};
+    std::vector<int> mNextNodeJoint{};
 
     std::vector<std::shared_ptr<GltfAnimationClip>> mAnimClips{};
 
+    bool mLazyClips = false;
+    size_t mClipMemoryBudget = 4 * 1024 * 1024;
+    uint64_t mClipFrame = 0;
+    std::vector<uint64_t> mClipLastUse{};
+    unsigned int mClipEvictions = 0;
+
+    std::vector<glm::mat4> mBakedJointMatrices{};
+    std::vector<GltfBakedClip> mBakedClips{};
+    float mBakedFrameRate = 0.0f;
+
     GLuint mVAO = 0;
     std::vector<GLuint> mVertexVBO{};
     GLuint mIndexVBO = 0;
+
+    /* single interleaved VBO, replaces the per-attribute buffers if set */
+    bool mPackedVertices = false;
+    std::vector<GltfPackedVertex> mPackedVertexData{};
+    size_t mVertexDataSize = 0;
+    size_t mUnpackedVertexDataSize = 0;
+
+    /* every level has half the triangles of the one before */
+    static const int mMaxLodLevels = 4;
+    /* allowed joint weight difference for merged vertices, keeps the deformation of the LODs */
+    static constexpr float mLodMaxWeightDistance = 0.5f;
+    std::vector<GltfLodLevel> mLodLevels{};
+    /* level 0 holds the merged indices of all primitives */
+    std::vector<uint32_t> mLodIndexData{};
+    GLenum mIndexType = GL_UNSIGNED_INT;
+    glm::vec4 mBoundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    /* static data for the GPU skeleton: joint pairs and bind pose joint origins */
+    GLuint mSkeletonVAO = 0;
+    GLuint mSkeletonBoneBuffer = 0;
+    GLuint mSkeletonBindPosBuffer = 0;
+    int mSkeletonBoneCount = 0;
     std::map<std::string, GLint> attributes ={ {"POSITION", 0}, {"NORMAL", 1}, {"TEXCOORD_0", 2}, {"JOINTS_0", 3}, {"WEIGHTS_0", 4} };
 
-    Texture mTex{};
+    /* texture 0 is the file given to loadModel, the others are the images of the materials */
+    std::vector<std::string> mTextureFiles{};
+    std::vector<Texture> mTex{};
+    /* decoded with their mip levels on the loader threads, or mapped from the cooked file */
+    std::vector<TextureData> mTextureData{};
+
+    std::vector<GltfPendingUpload> mPendingUploads{};
+    size_t mNextUpload = 0;
+    size_t mUploadBytes = 0;
+    size_t mUploadedBytes = 0;
+    size_t mBufferBytes = 0;
+    bool mUploadFinished = false;
+
+    /* everything needed for drawing and animation is in the compact members above after the upload */
+    bool mResidentMinimal = false;
+    size_t mReleasedBytes = 0;
 };
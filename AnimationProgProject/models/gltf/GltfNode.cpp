@@ -1,7 +1,7 @@
 #include "GltfNode.h"
 #include <algorithm>
 #include <glm/gtx/matrix_decompose.hpp>
-#include "../logger/Logger.h"
+#include "../Logger/Logger.h"
 
 std::shared_ptr<GltfNode> GltfNode::createRoot(int rootNodeNum)
 {
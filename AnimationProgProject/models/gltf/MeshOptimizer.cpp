@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+#include "MeshOptimizer.h"
+
+MeshCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+{
+    MeshCacheStats stats{};
+    if (indices.empty() || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    /* a vertex is still cached if less than cacheSize misses happened since it was loaded */
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int timeStamp = cacheSize + 1;
+    unsigned int misses = 0;
+
+    for (const uint32_t index : indices)
+    {
+        if (timeStamp - cacheTime.at(index) > static_cast<unsigned int>(cacheSize))
+        {
+            cacheTime.at(index) = timeStamp;
+            ++timeStamp;
+            ++misses;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+    return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount,
+    std::vector<uint32_t>& clusterStarts, int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    clusterStarts.clear();
+
+    std::vector<uint32_t> result{};
+    result.reserve(indices.size());
+    if (triangleCount == 0)
+    {
+        return result;
+    }
+
+    /* vertex to triangle adjacency, stored as one flat list */
+    std::vector<unsigned int> liveCount(vertexCount, 0);
+    for (const uint32_t index : indices)
+    {
+        ++liveCount.at(index);
+    }
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    std::partial_sum(liveCount.begin(), liveCount.end(), adjacencyOffsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<unsigned int> fillPos(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        adjacency.at(fillPos.at(indices.at(i))++) = i / 3;
+    }
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd{};
+    std::vector<uint32_t> candidates{};
+    deadEnd.reserve(indices.size());
+
+    unsigned int timeStamp = cacheSize + 1;
+    size_t scanPos = 0;
+    int fanVertex = 0;
+
+    while (fanVertex >= 0)
+    {
+        candidates.clear();
+
+        /* emit all remaining triangles around the fanning vertex */
+        for (unsigned int i = adjacencyOffsets.at(fanVertex); i < adjacencyOffsets.at(fanVertex + 1); ++i)
+        {
+            uint32_t triangle = adjacency.at(i);
+            if (emitted.at(triangle))
+            {
+                continue;
+            }
+
+            int misses = 0;
+            for (int j = 0; j < 3; ++j)
+            {
+                uint32_t vertex = indices.at(triangle * 3 + j);
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveCount.at(vertex);
+
+                if (timeStamp - cacheTime.at(vertex) > static_cast<unsigned int>(cacheSize))
+                {
+                    cacheTime.at(vertex) = timeStamp;
+                    ++timeStamp;
+                    ++misses;
+                }
+            }
+
+            /* three misses in a row means the cache got flushed, the overdraw pass may move this cluster */
+            if (misses == 3)
+            {
+                clusterStarts.push_back(result.size() / 3 - 1);
+            }
+            emitted.at(triangle) = true;
+        }
+
+        /* prefer the candidate that stays in the cache the longest while all its triangles are emitted */
+        int nextVertex = -1;
+        int bestPriority = -1;
+        for (const uint32_t vertex : candidates)
+        {
+            if (liveCount.at(vertex) == 0)
+            {
+                continue;
+            }
+
+            int priority = 0;
+            if (timeStamp - cacheTime.at(vertex) + 2 * liveCount.at(vertex) <= static_cast<unsigned int>(cacheSize))
+            {
+                priority = timeStamp - cacheTime.at(vertex);
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                nextVertex = vertex;
+            }
+        }
+
+        /* dead end: go back to recently used vertices first, then scan for any vertex left */
+        while (nextVertex == -1 && !deadEnd.empty())
+        {
+            uint32_t vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveCount.at(vertex) > 0)
+            {
+                nextVertex = vertex;
+            }
+        }
+
+        while (nextVertex == -1 && scanPos < vertexCount)
+        {
+            if (liveCount.at(scanPos) > 0)
+            {
+                nextVertex = scanPos;
+            }
+            else
+            {
+                ++scanPos;
+            }
+        }
+
+        fanVertex = nextVertex;
+    }
+
+    if (clusterStarts.empty() || clusterStarts.front() != 0)
+    {
+        clusterStarts.insert(clusterStarts.begin(), 0);
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusterStarts,
+    const std::vector<glm::vec3>& positions, float threshold, int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (clusterStarts.size() < 2 || positions.empty())
+    {
+        return indices;
+    }
+
+    /* area weighted centroid of the whole mesh */
+    glm::vec3 meshCentroid = glm::vec3(0.0f);
+    float meshArea = 0.0f;
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        const glm::vec3& p0 = positions.at(indices.at(i * 3));
+        const glm::vec3& p1 = positions.at(indices.at(i * 3 + 1));
+        const glm::vec3& p2 = positions.at(indices.at(i * 3 + 2));
+        float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+        meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    /* clusters facing away from the mesh center are likely to occlude the others, draw them first */
+    struct ClusterSort {
+        uint32_t start;
+        uint32_t end;
+        float sortKey;
+    };
+    std::vector<ClusterSort> clusters{};
+
+    for (size_t c = 0; c < clusterStarts.size(); ++c)
+    {
+        uint32_t start = clusterStarts.at(c);
+        uint32_t end = (c + 1 < clusterStarts.size()) ? clusterStarts.at(c + 1) : triangleCount;
+
+        glm::vec3 centroid = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);
+        float area = 0.0f;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            const glm::vec3& p0 = positions.at(indices.at(i * 3));
+            const glm::vec3& p1 = positions.at(indices.at(i * 3 + 1));
+            const glm::vec3& p2 = positions.at(indices.at(i * 3 + 2));
+            glm::vec3 triNormal = glm::cross(p1 - p0, p2 - p0);
+            float triArea = glm::length(triNormal);
+
+            centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+            normal += triNormal;
+            area += triArea;
+        }
+
+        float sortKey = 0.0f;
+        if (area > 0.0f && glm::length(normal) > 0.0f)
+        {
+            centroid /= area;
+            sortKey = glm::dot(centroid - meshCentroid, glm::normalize(normal));
+        }
+        clusters.push_back({ start, end, sortKey });
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const ClusterSort& a, const ClusterSort& b)
+    {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> result{};
+    result.reserve(indices.size());
+    for (const auto& cluster : clusters)
+    {
+        result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+
+    /* vertex work is paid by every instance, do not trade too much of it for less overdraw */
+    size_t vertexCount = 0;
+    for (const uint32_t index : indices)
+    {
+        vertexCount = std::max(vertexCount, static_cast<size_t>(index) + 1);
+    }
+    float inputACMR = analyzeVertexCache(indices, vertexCount, cacheSize).acmr;
+    float resultACMR = analyzeVertexCache(result, vertexCount, cacheSize).acmr;
+    if (resultACMR > inputACMR * threshold)
+    {
+        return indices;
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    const uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t nextVertex = 0;
+
+    for (uint32_t& index : indices)
+    {
+        if (remap.at(index) == unused)
+        {
+            remap.at(index) = nextVertex++;
+        }
+        index = remap.at(index);
+    }
+
+    /* keep unreferenced vertices at the end, the other vertex data stays the same size */
+    for (uint32_t& newIndex : remap)
+    {
+        if (newIndex == unused)
+        {
+            newIndex = nextVertex++;
+        }
+    }
+
+    return remap;
+}
@@ -0,0 +1,29 @@
+/* load time index and vertex reordering for triangle lists */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct MeshCacheStats {
+    /* average cache miss ratio, transformed vertices per triangle (0.5 ... 3.0) */
+    float acmr = 0.0f;
+    /* average transform to vertex ratio, transformed vertices per mesh vertex (1.0 is perfect) */
+    float atvr = 0.0f;
+};
+
+class MeshOptimizer {
+public:
+    /* simulated FIFO post-transform cache, roughly what current GPUs behave like */
+    static MeshCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = 16);
+
+    /* Tipsify (Sander et al. 2007), clusterStarts receives the triangle index of every hard cache break */
+    static std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount,
+        std::vector<uint32_t>& clusterStarts, int cacheSize = 16);
+
+    /* orders the Tipsify clusters outside-in, keeps the input if the ACMR gets worse than threshold */
+    static std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusterStarts,
+        const std::vector<glm::vec3>& positions, float threshold = 1.05f, int cacheSize = 16);
+
+    /* renumbers the vertices in order of first use, returns the old to new index mapping */
+    static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+};
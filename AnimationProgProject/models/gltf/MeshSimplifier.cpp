@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+#include "MeshSimplifier.h"
+
+namespace {
+    /* symmetric 4x4 matrix of the summed squared plane distances */
+    struct Quadric {
+        double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+        double b2 = 0.0, bc = 0.0, bd = 0.0;
+        double c2 = 0.0, cd = 0.0;
+        double d2 = 0.0;
+
+        void addPlane(double a, double b, double c, double d, double weight)
+        {
+            a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+            b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+            c2 += weight * c * c; cd += weight * c * d;
+            d2 += weight * d * d;
+        }
+
+        void add(const Quadric& other)
+        {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+            b2 += other.b2; bc += other.bc; bd += other.bd;
+            c2 += other.c2; cd += other.cd;
+            d2 += other.d2;
+        }
+
+        double evaluate(const glm::vec3& p) const
+        {
+            double x = p.x;
+            double y = p.y;
+            double z = p.z;
+            return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+                b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+                c2 * z * z + 2.0 * cd * z + d2;
+        }
+    };
+
+    struct Collapse {
+        float cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        bool operator>(const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+}
+
+float MeshSimplifier::jointWeightDistance(const glm::tvec4<uint16_t>& jointsA, const glm::vec4& weightsA,
+    const glm::tvec4<uint16_t>& jointsB, const glm::vec4& weightsB)
+{
+    float distance = 0.0f;
+
+    /* joints only used by A, and the difference for the shared joints */
+    for (int i = 0; i < 4; ++i)
+    {
+        if (weightsA[i] == 0.0f)
+        {
+            continue;
+        }
+        float otherWeight = 0.0f;
+        for (int j = 0; j < 4; ++j)
+        {
+            if (jointsB[j] == jointsA[i])
+            {
+                otherWeight += weightsB[j];
+            }
+        }
+        distance += std::fabs(weightsA[i] - otherWeight);
+    }
+
+    /* joints only used by B */
+    for (int j = 0; j < 4; ++j)
+    {
+        bool shared = false;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (weightsA[i] != 0.0f && jointsA[i] == jointsB[j])
+            {
+                shared = true;
+            }
+        }
+        if (!shared)
+        {
+            distance += weightsB[j];
+        }
+    }
+
+    return distance;
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+    const std::vector<glm::tvec4<uint16_t>>& joints, const std::vector<glm::vec4>& weights,
+    size_t targetIndexCount, float maxWeightDistance, float& resultError)
+{
+    resultError = 0.0f;
+    size_t vertexCount = positions.size();
+    size_t triangleCount = indices.size() / 3;
+
+    std::vector<uint32_t> triangles = indices;
+    std::vector<bool> triangleAlive(triangleCount, true);
+    size_t aliveCount = triangleCount;
+
+    /* per-vertex error quadrics from the area weighted triangle planes */
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const glm::vec3& p0 = positions.at(triangles.at(t * 3));
+        const glm::vec3& p1 = positions.at(triangles.at(t * 3 + 1));
+        const glm::vec3& p2 = positions.at(triangles.at(t * 3 + 2));
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area > 0.0f)
+        {
+            normal /= area;
+        }
+        double d = -glm::dot(normal, p0);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            quadrics.at(triangles.at(t * 3 + i)).addPlane(normal.x, normal.y, normal.z, d, area);
+            vertexTriangles.at(triangles.at(t * 3 + i)).push_back(t);
+        }
+    }
+
+    /* open edges are borders or uv/normal seams, moving their vertices would open holes */
+    std::unordered_map<uint64_t, int> edgeUse{};
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            uint64_t a = triangles.at(t * 3 + i);
+            uint64_t b = triangles.at(t * 3 + (i + 1) % 3);
+            ++edgeUse[std::min(a, b) << 32 | std::max(a, b)];
+        }
+    }
+    std::vector<bool> locked(vertexCount, false);
+    for (const auto& edge : edgeUse)
+    {
+        if (edge.second == 1)
+        {
+            locked.at(edge.first >> 32) = true;
+            locked.at(edge.first & 0xffffffff) = true;
+        }
+    }
+
+    std::vector<uint32_t> version(vertexCount, 0);
+    std::vector<bool> removed(vertexCount, false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses{};
+
+    auto addCollapse = [&](uint32_t from, uint32_t to)
+    {
+        if (locked.at(from) || from == to)
+        {
+            return;
+        }
+        if (jointWeightDistance(joints.at(from), weights.at(from), joints.at(to), weights.at(to)) > maxWeightDistance)
+        {
+            return;
+        }
+        float cost = static_cast<float>(quadrics.at(from).evaluate(positions.at(to)) + quadrics.at(to).evaluate(positions.at(to)));
+        collapses.push({ cost, from, to, version.at(from), version.at(to) });
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            uint32_t a = triangles.at(t * 3 + i);
+            uint32_t b = triangles.at(t * 3 + (i + 1) % 3);
+            addCollapse(a, b);
+            addCollapse(b, a);
+        }
+    }
+
+    while (aliveCount * 3 > targetIndexCount && !collapses.empty())
+    {
+        Collapse collapse = collapses.top();
+        collapses.pop();
+
+        uint32_t from = collapse.from;
+        uint32_t to = collapse.to;
+        if (removed.at(from) || removed.at(to) ||
+            collapse.fromVersion != version.at(from) || collapse.toVersion != version.at(to))
+        {
+            continue;
+        }
+
+        /* reject collapses that flip or squash a remaining triangle */
+        bool flips = false;
+        for (const uint32_t t : vertexTriangles.at(from))
+        {
+            if (!triangleAlive.at(t))
+            {
+                continue;
+            }
+            uint32_t* tri = &triangles.at(t * 3);
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+                continue;
+            }
+
+            glm::vec3 oldPos[3];
+            glm::vec3 newPos[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                oldPos[i] = positions.at(tri[i]);
+                newPos[i] = (tri[i] == from) ? positions.at(to) : oldPos[i];
+            }
+            glm::vec3 oldNormal = glm::cross(oldPos[1] - oldPos[0], oldPos[2] - oldPos[0]);
+            glm::vec3 newNormal = glm::cross(newPos[1] - newPos[0], newPos[2] - newPos[0]);
+            if (glm::dot(oldNormal, newNormal) <= 0.25f * glm::length(oldNormal) * glm::length(newNormal))
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+        {
+            continue;
+        }
+
+        /* move the triangles of "from" over to "to", the ones sharing the edge disappear */
+        for (const uint32_t t : vertexTriangles.at(from))
+        {
+            if (!triangleAlive.at(t))
+            {
+                continue;
+            }
+            uint32_t* tri = &triangles.at(t * 3);
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+                triangleAlive.at(t) = false;
+                --aliveCount;
+                continue;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                if (tri[i] == from)
+                {
+                    tri[i] = to;
+                }
+            }
+            vertexTriangles.at(to).push_back(t);
+        }
+        vertexTriangles.at(from).clear();
+        removed.at(from) = true;
+
+        quadrics.at(to).add(quadrics.at(from));
+        ++version.at(to);
+        resultError = std::max(resultError, collapse.cost);
+
+        /* the version change of "to" invalidated its old collapses, queue them again with the new cost */
+        for (const uint32_t t : vertexTriangles.at(to))
+        {
+            if (!triangleAlive.at(t))
+            {
+                continue;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                uint32_t other = triangles.at(t * 3 + i);
+                if (other != to)
+                {
+                    addCollapse(to, other);
+                    addCollapse(other, to);
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> result{};
+    result.reserve(aliveCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (triangleAlive.at(t))
+        {
+            result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+        }
+    }
+
+    resultError = std::sqrt(resultError);
+    return result;
+}
@@ -0,0 +1,19 @@
+/* quadric error edge collapse for skinned triangle lists, creates LOD index buffers */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class MeshSimplifier {
+public:
+    /* collapses vertices into neighbours until targetIndexCount is reached, no new vertices are created.
+       vertices are only merged if their joint weights differ by less than maxWeightDistance (sum of
+       absolute per-joint differences, 0 ... 2), so the simplified mesh still deforms like the original */
+    static std::vector<uint32_t> simplify(const std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions,
+        const std::vector<glm::tvec4<uint16_t>>& joints, const std::vector<glm::vec4>& weights,
+        size_t targetIndexCount, float maxWeightDistance, float& resultError);
+
+private:
+    static float jointWeightDistance(const glm::tvec4<uint16_t>& jointsA, const glm::vec4& weightsA,
+        const glm::tvec4<uint16_t>& jointsB, const glm::vec4& weightsB);
+};
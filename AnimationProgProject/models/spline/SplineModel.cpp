@@ -1,7 +1,7 @@
 #include <glm/gtx/spline.hpp>
 
 #include "SplineModel.h"
-#include "../../logger/Logger.h"
+#include "../../Logger/Logger.h"
 
 OGLMesh SplineModel::createVertexData(int numSplinePoints,
     glm::vec3 startVertex, glm::vec3 startTangent,
@@ -1,5 +1,6 @@
 #include "FrameBuffer.h"
 #include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
 
 bool FrameBuffer::init(unsigned int width, unsigned int height) {
 	
@@ -7,14 +8,16 @@ bool FrameBuffer::init(unsigned int width, unsigned int height) {
 	// Store dimension of buffer
 	mBufferWidth = width;
 	mBufferHeight = height;
+	mAllocWidth = width;
+	mAllocHeight = height;
 
 	// Create an OpenGl Frame Buffer object
 	glGenFramebuffers(1, &mBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, mBuffer);
+	OGLStateCache::bindFramebuffer(GL_FRAMEBUFFER, mBuffer);
 
 	// Create a texture with the same size of the buffer and bind the texture as a 2D texture type
 	glGenTextures(1, &mColorTex);
-	glBindTexture(GL_TEXTURE_2D, mColorTex);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, mColorTex);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
 	// Set properties of the texture (since some drivers refuse to display textures if not set) //
@@ -29,7 +32,7 @@ bool FrameBuffer::init(unsigned int width, unsigned int height) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	// Unbind texture by binding it to invalid texture id (0) to avoid further modifications 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
 
 	// Bind texture as so called texture attachment 0 (We can bind multiple texture attachments to the buffer)
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mColorTex, 0);
@@ -49,7 +52,7 @@ bool FrameBuffer::init(unsigned int width, unsigned int height) {
 
 	// Unbind the render and frame buffer
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	OGLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	if (!checkComplete()) {
 	Logger::log(0, "%s: Error - Frame buffer init failed.\n", __FUNCTION__);
@@ -65,16 +68,25 @@ bool FrameBuffer::init(unsigned int width, unsigned int height) {
 
 bool FrameBuffer::resize(unsigned int newWidth, unsigned int newHeight) {
 
+	// Keep the attachments, only the used area changes
+	if (fits(newWidth, newHeight)) {
+		mBufferWidth = newWidth;
+		mBufferHeight = newHeight;
+		Logger::log(2, "%s: Frame buffer reused for %ix%i.\n", __FUNCTION__, newWidth, newHeight);
+		return true;
+	}
+
 	Logger::log(1, "%s: Resizing frame buffer...\n", __FUNCTION__);
 
 	mBufferWidth = newWidth;
 	mBufferHeight = newHeight;
 
 	// Remove created openGL objects from frame buffer
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	OGLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 	glDeleteTextures(1, &mColorTex);
 	glDeleteRenderbuffers(1, &mDepthBuffer);
 	glDeleteFramebuffers(1, &mBuffer);
+	OGLStateCache::invalidate();
 
 	// Create new frame buffer
 	if (!init(newWidth, newHeight)) {
@@ -86,12 +98,32 @@ bool FrameBuffer::resize(unsigned int newWidth, unsigned int newHeight) {
 	return true;
 }
 
+bool FrameBuffer::fits(unsigned int width, unsigned int height) const {
+	return width <= mAllocWidth && height <= mAllocHeight;
+}
+
+unsigned int FrameBuffer::getWidth() const {
+	return mBufferWidth;
+}
+
+unsigned int FrameBuffer::getHeight() const {
+	return mBufferHeight;
+}
+
+unsigned int FrameBuffer::getAllocWidth() const {
+	return mAllocWidth;
+}
+
+unsigned int FrameBuffer::getAllocHeight() const {
+	return mAllocHeight;
+}
+
 bool FrameBuffer::checkComplete() {
 
 
 	Logger::log(1, "%s: Checking Frame buffer....\n", __FUNCTION__);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mBuffer);
+	OGLStateCache::bindFramebuffer(GL_FRAMEBUFFER, mBuffer);
 
 	GLenum result = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
@@ -100,7 +132,7 @@ bool FrameBuffer::checkComplete() {
 		return false;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	OGLStateCache::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	Logger::log(1, "%s: Frame buffer check passed.\n", __FUNCTION__);
 	return true;
@@ -110,14 +142,14 @@ void FrameBuffer::bindDrawing() {
 
 	Logger::log(2, "%s: Binding frame buffer to draw.\n", __FUNCTION__);
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mBuffer);
+	OGLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, mBuffer);
 }
 
 void FrameBuffer::unbindDrawing() {
 
 	Logger::log(2, "%s: Unbinding frame buffer from draw.\n", __FUNCTION__);
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	OGLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 }
 
 void FrameBuffer::cleanup() {
@@ -135,19 +167,32 @@ void FrameBuffer::cleanup() {
 
 }
 
-void FrameBuffer::drawToScreen() {
+void FrameBuffer::drawToScreen(unsigned int screenWidth, unsigned int screenHeight) {
 
 	Logger::log(2, "%s: Drawing frame buffer to screen...\n", __FUNCTION__);
 
 	// Bind the frame buffer to for read
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, mBuffer);
+	OGLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, mBuffer);
 	// Unbind for draw
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	OGLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 	
 	// Memory Copy (Blit) the contents to the frame buffer to the window
-	glBlitFramebuffer(0, 0, mBufferWidth, mBufferHeight, 0, 0, mBufferWidth, mBufferHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	// Only filtered if the window size changed and the buffer was not resized yet
+	GLenum filter = (screenWidth == mBufferWidth && screenHeight == mBufferHeight) ? GL_NEAREST : GL_LINEAR;
+	glBlitFramebuffer(0, 0, mBufferWidth, mBufferHeight, 0, 0, screenWidth, screenHeight, GL_COLOR_BUFFER_BIT, filter);
+	OGLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 
 	Logger::log(2, "%s: Completed drawing frame buffer to screen...\n", __FUNCTION__);
 }
 
+std::vector<unsigned char> FrameBuffer::readColorPixels() {
+
+	std::vector<unsigned char> pixels(mBufferWidth * mBufferHeight * 4);
+
+	OGLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, mBuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, mBufferWidth, mBufferHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	OGLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	return pixels;
+}
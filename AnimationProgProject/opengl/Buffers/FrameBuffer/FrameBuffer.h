@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -11,19 +12,35 @@ class FrameBuffer {
 		// @param height - Height of buffer
 		bool init(unsigned int width, unsigned int height);
 		
-		// Resizes the frame buffer
+		// Resizes the frame buffer, sizes that fit into the allocated attachments only change the used area
 		// @param newWidth - New width of buffer
 		// @param newHeight - New height of buffer
 		bool resize(unsigned int newWidth, unsigned int newHeight);
 
+		// Checks if the attachments are large enough for the size
+		bool fits(unsigned int width, unsigned int height) const;
+
+		// Used area of the buffer
+		unsigned int getWidth() const;
+		unsigned int getHeight() const;
+
+		// Size of the allocated attachments
+		unsigned int getAllocWidth() const;
+		unsigned int getAllocHeight() const;
+
 		// Enables drawing to frame buffer (For when we want to use multiple buffers and avoid any unexpected results)
 		void bindDrawing();
 
 		// Disables drawing to frame buffer (For when we want to use multiple buffers and avoid any unexpected results)
 		void unbindDrawing();
 
-		// Copies data to GLFW window
-		void drawToScreen();
+		// Copies the used area to the window, scaled if the window has a different size
+		// @param screenWidth - Width of the window
+		// @param screenHeight - Height of the window
+		void drawToScreen(unsigned int screenWidth, unsigned int screenHeight);
+
+		// Reads back the color attachment as RGBA8, rows start at the bottom
+		std::vector<unsigned char> readColorPixels();
 
 		// Cleans up the Frame buffer
 		void cleanup();
@@ -35,6 +52,10 @@ class FrameBuffer {
 		// Store current height of buffer
 		unsigned int mBufferHeight = 480;
 
+		// Size of the texture and render buffer, at least the size of the buffer
+		unsigned int mAllocWidth = 640;
+		unsigned int mAllocHeight = 480;
+
 		// (Internal Buffer) Overall frame buffer we need to draw
 		GLuint mBuffer = 0;
 
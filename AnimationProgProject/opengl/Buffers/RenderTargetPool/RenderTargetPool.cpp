@@ -0,0 +1,96 @@
+#include "RenderTargetPool.h"
+#include "../Logger/Logger.h"
+
+FrameBuffer* RenderTargetPool::acquire(unsigned int width, unsigned int height) {
+
+	float neededArea = static_cast<float>(width) * static_cast<float>(height);
+
+	// Smallest free target that fits
+	RenderTarget* bestTarget = nullptr;
+	float bestArea = 0.0f;
+	for (auto& target : mTargets) {
+		if (target.inUse || !target.buffer->fits(width, height)) {
+			continue;
+		}
+		float area = static_cast<float>(target.buffer->getAllocWidth()) * static_cast<float>(target.buffer->getAllocHeight());
+		if (area > neededArea * mMaxAreaWaste) {
+			continue;
+		}
+		if (!bestTarget || area < bestArea) {
+			bestTarget = &target;
+			bestArea = area;
+		}
+	}
+
+	if (bestTarget) {
+		bestTarget->buffer->resize(width, height);
+		bestTarget->inUse = true;
+		bestTarget->unusedFrames = 0;
+		Logger::log(2, "%s: Reusing render target for %ix%i.\n", __FUNCTION__, width, height);
+		return bestTarget->buffer.get();
+	}
+
+	unsigned int allocWidth = (width + mSizeGranularity - 1) / mSizeGranularity * mSizeGranularity;
+	unsigned int allocHeight = (height + mSizeGranularity - 1) / mSizeGranularity * mSizeGranularity;
+
+	std::unique_ptr<FrameBuffer> buffer = std::make_unique<FrameBuffer>();
+	if (!buffer->init(allocWidth, allocHeight)) {
+		Logger::log(0, "%s: Error - Could not create render target with %ix%i.\n", __FUNCTION__, allocWidth, allocHeight);
+		buffer->cleanup();
+		return nullptr;
+	}
+	buffer->resize(width, height);
+	++mAllocationCount;
+
+	RenderTarget newTarget{};
+	newTarget.buffer = std::move(buffer);
+	newTarget.inUse = true;
+	mTargets.push_back(std::move(newTarget));
+
+	Logger::log(1, "%s: Created render target %ix%i for %ix%i.\n", __FUNCTION__, allocWidth, allocHeight, width, height);
+	return mTargets.back().buffer.get();
+}
+
+void RenderTargetPool::release(FrameBuffer* target) {
+
+	for (auto& poolTarget : mTargets) {
+		if (poolTarget.buffer.get() == target) {
+			poolTarget.inUse = false;
+			poolTarget.unusedFrames = 0;
+			return;
+		}
+	}
+
+	Logger::log(0, "%s: Error - Render target is not part of the pool.\n", __FUNCTION__);
+}
+
+void RenderTargetPool::endFrame() {
+
+	for (auto iter = mTargets.begin(); iter != mTargets.end();) {
+		if (!iter->inUse && ++iter->unusedFrames > mMaxUnusedFrames) {
+			Logger::log(1, "%s: Deleting unused render target %ix%i.\n", __FUNCTION__,
+				iter->buffer->getAllocWidth(), iter->buffer->getAllocHeight());
+			iter->buffer->cleanup();
+			iter = mTargets.erase(iter);
+		}
+		else {
+			++iter;
+		}
+	}
+}
+
+unsigned int RenderTargetPool::getTargetCount() const {
+	return static_cast<unsigned int>(mTargets.size());
+}
+
+unsigned int RenderTargetPool::getAllocationCount() const {
+	return mAllocationCount;
+}
+
+void RenderTargetPool::cleanup() {
+
+	for (auto& target : mTargets) {
+		target.buffer->cleanup();
+	}
+	mTargets.clear();
+}
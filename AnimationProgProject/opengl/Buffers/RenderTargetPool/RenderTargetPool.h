@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "../FrameBuffer/FrameBuffer.h"
+
+// Keeps offscreen frame buffers alive after they are released, so resizing the window or switching
+// render paths reuses the existing textures and render buffers instead of creating new ones.
+// Released targets are deleted after they were not used for a number of frames.
+class RenderTargetPool {
+	public:
+		// Returns a frame buffer with at least the given size, reused if a free one fits
+		// @param width - Width of the area to draw
+		// @param height - Height of the area to draw
+		FrameBuffer* acquire(unsigned int width, unsigned int height);
+
+		// Gives the frame buffer back to the pool, it stays allocated for later acquire calls
+		// @param target - Frame buffer returned by acquire
+		void release(FrameBuffer* target);
+
+		// Ages the free targets and deletes the ones unused for too long, call once per frame
+		void endFrame();
+
+		// Number of allocated targets, free or in use
+		unsigned int getTargetCount() const;
+
+		// Number of frame buffers created since start
+		unsigned int getAllocationCount() const;
+
+		// Deletes all targets
+		void cleanup();
+
+	private:
+		struct RenderTarget {
+			std::unique_ptr<FrameBuffer> buffer;
+			bool inUse = false;
+			unsigned int unusedFrames = 0;
+		};
+
+		std::vector<RenderTarget> mTargets{};
+		unsigned int mAllocationCount = 0;
+
+		// Allocations are rounded up, small size changes while dragging the window edge fit into the same target
+		static const unsigned int mSizeGranularity = 64;
+
+		// A free target is only reused if it wastes less than this factor of the needed area
+		static constexpr float mMaxAreaWaste = 2.0f;
+
+		// Free targets are deleted after this number of frames
+		static const unsigned int mMaxUnusedFrames = 120;
+};
@@ -1,5 +1,6 @@
 #include "VertexBuffer.h"
 #include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
 
 void VertexBuffer::init() {
 
@@ -12,8 +13,8 @@ void VertexBuffer::init() {
 	glGenBuffers(1, &mVertexVBO);
 
 	// Bind array and buffer
-	glBindVertexArray(mVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
+	OGLStateCache::bindVertexArray(mVAO);
+	OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
 
 	// Configures the buffer object - Pointers to the positions and uv properties in the OGLVertex struct
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(OGLVertex), (void*)offsetof(OGLVertex, position));
@@ -26,8 +27,8 @@ void VertexBuffer::init() {
 	glEnableVertexAttribArray(2);
 
 	// Unbind array and buffer
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+	OGLStateCache::bindVertexArray(0);
 
 
 	Logger::log(1, "%s: Completed initing buffer.\n", __FUNCTION__);
@@ -43,33 +44,30 @@ void VertexBuffer::cleanup() {
 	Logger::log(1, "%s: Completed cleaning Vertex Buffer...\n", __FUNCTION__);
 }
 
-void VertexBuffer::uploadData(OGLMesh vertexData) {
+void VertexBuffer::uploadData(const OGLMesh& vertexData) {
 
 	Logger::log(2, "%s: Uploading vertex data to Vertex Buffer...\n", __FUNCTION__);
 
 	// Bind vertex buffer and array
-	glBindVertexArray(mVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
+	OGLStateCache::bindVertexArray(mVAO);
+	OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
 
 	// Uploads the vertex data to openGL buffer 
 	glBufferData(GL_ARRAY_BUFFER, vertexData.vertices.size() * sizeof(OGLVertex), &vertexData.vertices.at(0), GL_DYNAMIC_DRAW);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	glBindVertexArray(0);
+	OGLStateCache::countUpload(vertexData.vertices.size() * sizeof(OGLVertex));
 
 }
 
 void VertexBuffer::bind() {
 
 	Logger::log(2, "%s: Binding vertex array.\n", __FUNCTION__);
-	glBindVertexArray(mVAO);
+	OGLStateCache::bindVertexArray(mVAO);
 }
 
 void VertexBuffer::unbind() {
 
 	Logger::log(2, "%s: Unbinding vertex array.\n", __FUNCTION__);
-	glBindVertexArray(0);
+	OGLStateCache::bindVertexArray(0);
 }
 
 void VertexBuffer::draw(GLuint mode, unsigned int start,unsigned int num) {
@@ -77,6 +75,7 @@ void VertexBuffer::draw(GLuint mode, unsigned int start,unsigned int num) {
 	Logger::log(2, "%s: Drawing...\n", __FUNCTION__);
 
 	glDrawArrays(mode, start, num);
+	OGLStateCache::countDrawCall();
 
 	Logger::log(2, "%s: Completed drawing.\n", __FUNCTION__);
 
@@ -86,5 +85,4 @@ void VertexBuffer::bindAndDraw(GLuint mode, unsigned int start, unsigned int num
 {
 	bind();
 	draw(mode, start, num);
-	unbind();
 }
@@ -16,7 +16,7 @@ class VertexBuffer {
 
 		// Copies data into buffer
 		// @param vertexData - Data to copy to buffer
-		void uploadData(OGLMesh vertexData);
+		void uploadData(const OGLMesh& vertexData);
 
 		// Enables modifications to the vertex buffer (For when we want to use multiple buffers and avoid any unexpected results)
 		void bind();
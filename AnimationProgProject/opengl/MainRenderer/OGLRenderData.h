@@ -1,7 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
-#include <glfw/glfw3.h>
+#include <GLFW/glfw3.h>
 #include <string>
 
 struct OGLVertex {
@@ -21,6 +21,18 @@ struct OGLMesh {
 	std::vector<OGLVertex> vertices;
 };
 
+// Loaded texture, for the memory and load time stats
+struct OGLTextureInfo {
+	std::string name;
+	int width = 0;
+	int height = 0;
+	int levels = 0;
+	size_t gpuBytes = 0;
+	float loadTime = 0.0f;
+	bool fromCache = false;
+	bool compressed = false;
+};
+
 enum class skinningMode {
 	linear = 0,
 	dualQuat
@@ -48,6 +60,9 @@ struct OGLRenderData {
 	// GFLW Window instance
 	GLFWwindow* rdWindow = nullptr;
 
+	// Rendering without window (EGL pbuffer), no UI and no input
+	bool rdHeadless = false;
+
 	// Dimensions of window
 	 int rdWidth = 0;
 	 int rdHeight = 0;
@@ -58,6 +73,12 @@ struct OGLRenderData {
 	// Tirangle count for GLTF model
 	unsigned int rdGltfTriangleCount = 0;
 
+	// Renderer init and shader loading, shaders may come from the program binary cache
+	float rdStartupTime = 0.0f;
+	float rdShaderLoadTime = 0.0f;
+	int rdShaderCacheHits = 0;
+	int rdShaderCacheMisses = 0;
+
 	// Time for a single frame to be created and rendered
 	float rdFrameTime = 0.0f;
 	float rdMatrixGenerateTime = 0.0f;
@@ -67,6 +88,113 @@ struct OGLRenderData {
 	float rdUIDrawTime = 0.0f;
 	float rdIKTime = 0.0f;
 
+	// FABRIK chains of all instances solved together in SIMD batches
+	bool rdBatchIK = true;
+	unsigned int rdIKChainCount = 0;
+	unsigned int rdIKBatchCount = 0;
+
+	// GPU execution time of the render passes, read back from timer queries
+	float rdGpuMatrixDrawTime = 0.0f;
+	float rdGpuDualQuatDrawTime = 0.0f;
+	float rdGpuLineDrawTime = 0.0f;
+	float rdGpuBlitTime = 0.0f;
+	float rdGpuUIDrawTime = 0.0f;
+	float rdGpuCrowdDrawTime = 0.0f;
+
+	// Debug lines, arrows and axes streamed this frame
+	unsigned int rdDebugDrawVertexCount = 0;
+	unsigned int rdDebugDrawCalls = 0;
+	size_t rdDebugDrawUploadBytes = 0;
+
+	// Draw the scene into the window, without the offscreen target and the full screen copy
+	bool rdDirectToBackbuffer = true;
+	unsigned int rdRenderTargets = 0;
+	unsigned int rdRenderTargetAllocations = 0;
+
+	// Shared models, textures and shaders of the asset registry
+	unsigned int rdAssetCount = 0;
+	size_t rdAssetBytes = 0;
+	unsigned int rdAssetHits = 0;
+	unsigned int rdAssetLoads = 0;
+	unsigned int rdAssetEvictions = 0;
+	int rdAssetBudgetMB = 512;
+
+	// Frame and draw constants written to the ring buffer
+	size_t rdConstantBytes = 0;
+
+	// GL calls of the last frame, counted by the state cache
+	unsigned int rdDrawCalls = 0;
+	unsigned int rdStateBinds = 0;
+	unsigned int rdSkippedBinds = 0;
+	unsigned int rdBufferUploads = 0;
+	size_t rdBufferUploadBytes = 0;
+
+	// Instances with skeleton lines generated on the GPU
+	unsigned int rdSkeletonInstanceCount = 0;
+
+	// Model parsing, .glb files are mapped instead of copied
+	float rdModelLoadTime = 0.0f;
+	size_t rdModelLoadPeakRss = 0;
+	bool rdModelMapped = false;
+	bool rdModelCooked = false;
+	float rdClipImportTime = 0.0f;
+
+	// Frees the glTF data or the mapped cooked file after the upload, the resident memory saved by it
+	bool rdResidentMinimal = true;
+	size_t rdModelReleasedBytes = 0;
+
+	// Clips created on first use and dropped again above the budget, lazy loading is set before loading
+	bool rdLazyClips = false;
+	int rdClipBudgetKB = 4096;
+	unsigned int rdClipCount = 0;
+	unsigned int rdClipsResident = 0;
+	size_t rdClipBytes = 0;
+	unsigned int rdClipLoads = 0;
+	unsigned int rdClipEvictions = 0;
+
+	// Clips with more keyframe data stream in windows from the glTF buffers or the cooked file, set before loading
+	int rdStreamClipKB = 1024;
+	float rdStreamWindowTime = 2.0f;
+	int rdStreamWindows = 4;
+	unsigned int rdClipsStreamed = 0;
+	unsigned int rdStreamMisses = 0;
+
+	// Model parsed on a worker thread, the GL uploads are spread over the frames
+	bool rdModelLoading = false;
+	float rdModelLoadProgress = 0.0f;
+	float rdModelReadyTime = 0.0f;
+	int rdUploadBudgetKB = 1024;
+
+	// Textures of the loaded models, decoded with CPU built mip levels or read from the compressed cache
+	std::vector<OGLTextureInfo> rdTextures{};
+
+	// Interleaved and quantized vertex data for the glTF model, set before loading
+	bool rdPackVertices = true;
+	size_t rdGltfVertexBytes = 0;
+	size_t rdGltfUnpackedVertexBytes = 0;
+
+	// Vertex cache, overdraw and fetch optimization at load, stats before and after
+	bool rdOptimizeMesh = true;
+	float rdMeshACMRBefore = 0.0f;
+	float rdMeshACMRAfter = 0.0f;
+	float rdMeshATVRBefore = 0.0f;
+	float rdMeshATVRAfter = 0.0f;
+
+	// Simplified LODs, picked per instance by the screen height covered
+	bool rdGenerateLods = true;
+	bool rdEnableLod = true;
+	float rdLodScreenSize = 0.5f;
+	float rdLodBias = 1.0f;
+	int rdLodLevels = 1;
+	std::vector<int> rdLodInstances{};
+
+	// Background crowd, clips baked at load and played back in the vertex shader
+	bool rdBakeAnimations = true;
+	float rdBakeFrameRate = 30.0f;
+	size_t rdBakedAnimationBytes = 0;
+	int rdCrowdInstances = 0;
+	int rdCrowdLod = 1;
+
 
 	// Is the program currently using the second shader
 	bool rdUseChangedShader = false;
@@ -1,25 +1,69 @@
 #include "OGLRenderer.h"
 #include <algorithm>
+#include <chrono>
 #include <glm/gtx/spline.hpp>
 #include "../Logger/Logger.h"
+#include "../stateCache/OGLStateCache.h"
 #include <imgui_impl_glfw.h>
+#include <stb_image_write.h>
 
+// Set by CMake, shaders and assets are loaded relative to the project folder
+#ifndef ASSET_ROOT_DIR
+#define ASSET_ROOT_DIR ""
+#endif
+
+std::string OGLRenderer::mModelFilename = ASSET_ROOT_DIR "assets/Woman.glb";
+int OGLRenderer::mUploadBudgetKB = 1024;
+bool OGLRenderer::mResidentMinimal = true;
+bool OGLRenderer::mLazyClips = false;
+int OGLRenderer::mStreamClipKB = 1024;
 
 OGLRenderer::OGLRenderer(GLFWwindow* window)
 {
 	mRenderData.rdWindow = window;
+	mRenderData.rdHeadless = (window == nullptr);
+
+}
+
+void OGLRenderer::setModelFileName(std::string fileName) {
+	mModelFilename = fileName;
+}
+
+void OGLRenderer::setUploadBudget(int kiloBytes) {
+	mUploadBudgetKB = std::max(kiloBytes, 1);
+}
+
+void OGLRenderer::setResidentMinimal(bool enabled) {
+	mResidentMinimal = enabled;
+}
 
+void OGLRenderer::setLazyClips(bool enabled) {
+	mLazyClips = enabled;
 }
 
-bool OGLRenderer::init(unsigned int width, unsigned int height) {
+void OGLRenderer::setStreamClipThreshold(int kiloBytes) {
+	mStreamClipKB = std::max(kiloBytes, 0);
+}
+
+bool OGLRenderer::init(unsigned int width, unsigned int height, GLADloadproc procLoader) {
+
+	Timer startupTimer{};
+	startupTimer.start();
 
 	mRenderData.rdWidth = width;
 	mRenderData.rdHeight = height;
+	mRenderData.rdUploadBudgetKB = mUploadBudgetKB;
+	mRenderData.rdResidentMinimal = mResidentMinimal;
+	mRenderData.rdLazyClips = mLazyClips;
+	mRenderData.rdStreamClipKB = mStreamClipKB;
 
 	std::srand(static_cast<int>(time(NULL)));
 
 	// Init OpenGL via Glad 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+	if (!procLoader) {
+		procLoader = (GLADloadproc)glfwGetProcAddress;
+	}
+	if (!gladLoadGLLoader(procLoader)) {
 		Logger::log(0, "%s: Error - Could not init openGL via Glad.\n", __FUNCTION__);
 		return false;
 	}
@@ -30,8 +74,9 @@ bool OGLRenderer::init(unsigned int width, unsigned int height) {
 		return false;
 	}
 
-	// Init frame buffer
-	if (!mFrameBuffer.init(width, height)) {
+	// Offscreen scene target, skipped if we draw straight to the window
+	updateSceneTarget();
+	if (!mRenderData.rdDirectToBackbuffer && !mSceneTarget) {
 		Logger::log(0, "%s: Error - Could not init Frame buffer.\n", __FUNCTION__);
 		return false;
 	}
@@ -39,56 +84,231 @@ bool OGLRenderer::init(unsigned int width, unsigned int height) {
 	// Init vertex buffer
 	mVertexBuffer.init();
 
-	size_t uniformMatrixBufferSize = 2 * sizeof(glm::mat4);
-	mUniformBuffer.init(uniformMatrixBufferSize);
-	Logger::log(1, "%s: uniform buffer successfully created\n", __FUNCTION__);
+	// A few dozen blocks per frame, the buffer grows if a frame needs more
+	if (!mConstantBuffer.init(64 * 1024)) {
+		Logger::log(0, "%s: Error - Could not init constant buffer.\n", __FUNCTION__);
+		return false;
+	}
+	Logger::log(1, "%s: constant buffer successfully created\n", __FUNCTION__);
 
 
-	if (!mLineShader.loadShaders("D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\line.vert", "D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\line.frag")) {
+	mLineShader = mAssetRegistry.acquireShader(ASSET_ROOT_DIR "Shaders/line.vert", ASSET_ROOT_DIR "Shaders/line.frag");
+	if (!mLineShader) {
 		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, "shader/line.vert", "shader/line.frag");
 		return false;
 	}
 
-	if (!mGltfGPUShader.loadShaders("D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\gltf_gpu.vert", "D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\gltf_gpu.frag")) {
-		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, "shader/gltf_gpu.vert", "shader/gltf_gpu.frag");
+	mSkeletonGPUShader = mAssetRegistry.acquireShader(ASSET_ROOT_DIR "Shaders/skeleton_gpu.vert", ASSET_ROOT_DIR "Shaders/line.frag");
+	if (!mSkeletonGPUShader) {
+		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, "shader/skeleton_gpu.vert", "shader/line.frag");
 		return false;
 	}
 
-	if (!mGltfGPUShader.getUniformLocation("aModelStride"))
+	if (!mSkeletonGPUShader->hasUniformBlock("DrawConstants"))
 	{
+		Logger::log(0, "%s: Error - Shader has no DrawConstants block.\n", __FUNCTION__);
 		return false;
 	}
 
-	if (!mGltfGPUDualQuatShader.loadShaders("D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\gltf_gpu_dquat.vert", "D:\\Github_Repos\\AnimationProg\\AnimationProgProject\\Shaders\\gltf_gpu_dquat.frag")) {
-		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, "shader/gltf_gpu_dquat.vert", "shader/gltf_gpu_dquat.frag");
+	mSkeletonGPUDualQuatShader = mAssetRegistry.acquireShader(ASSET_ROOT_DIR "Shaders/skeleton_gpu_dquat.vert", ASSET_ROOT_DIR "Shaders/line.frag");
+	if (!mSkeletonGPUDualQuatShader) {
+		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, "shader/skeleton_gpu_dquat.vert", "shader/line.frag");
 		return false;
 	}
 
-	if (!mGltfGPUDualQuatShader.getUniformLocation("aModelStride"))
+	if (!mSkeletonGPUDualQuatShader->hasUniformBlock("DrawConstants"))
 	{
+		Logger::log(0, "%s: Error - Shader has no DrawConstants block.\n", __FUNCTION__);
 		return false;
 	}
 
 
-	mUserInterface.init(mRenderData);
+	if (!mRenderData.rdHeadless) {
+		mUserInterface.init(mRenderData);
+	}
 
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
+	OGLStateCache::setCapability(GL_CULL_FACE, true);
+	OGLStateCache::setCapability(GL_DEPTH_TEST, true);
 	glLineWidth(3.0);
-	mGltfModel = std::make_shared<GltfModel>();
-	std::string modelFilename = "D:/Github_Repos/AnimationProg/AnimationProgProject/assets/Woman.gltf";
-	std::string modelTexFilename = "D:/Github_Repos/AnimationProg/AnimationProgProject/Textures/Woman.png";
-	if (!mGltfModel->loadModel(mRenderData, modelFilename, modelTexFilename)) {
-		Logger::log(1, "%s: loading glTF model '%s' failed\n", __FUNCTION__, modelFilename.c_str());
+	/* parsing and decoding on a worker thread, draw() uploads the data and creates the instances once it is ready */
+	mModelLoadTimer.start();
+	mLoaderPool.init();
+	mLoadRenderData = mRenderData;
+	std::string modelFilename = mModelFilename;
+	std::string modelTexFilename = ASSET_ROOT_DIR "Textures/Woman.png";
+	GltfModelHandle modelHandle = mAssetRegistry.acquireModel(modelFilename, modelTexFilename,
+		[this, modelFilename, modelTexFilename](std::shared_ptr<GltfModel> model) {
+			/* raw pointer, the finished job stays in the shared state and must not keep the model referenced */
+			GltfModel* loadModel = model.get();
+			return mLoaderPool.submit([this, loadModel, modelFilename, modelTexFilename]() {
+				return loadModel->prepareModel(mLoadRenderData, modelFilename, modelTexFilename, &mLoaderPool);
+			}).share();
+		});
+	mGltfModel = modelHandle.model;
+	mModelLoad = modelHandle.loaded;
+	mRenderData.rdModelLoading = true;
+
+	if (!mDebugDraw.init(4096)) {
+		Logger::log(0, "%s: Error - Could not init debug draw.\n", __FUNCTION__);
 		return false;
 	}
-	mGltfModel->uploadVertexBuffers();
-	mGltfModel->uploadIndexBuffer();
 
-	Logger::log(1, "%s: glTF model '%s' succesfully loaded\n", __FUNCTION__, modelFilename.c_str());
+	if (!mGpuMatrixDrawTimer.init() || !mGpuDualQuatDrawTimer.init() || !mGpuLineDrawTimer.init() ||
+		!mGpuBlitTimer.init() || !mGpuUIDrawTimer.init() || !mGpuCrowdDrawTimer.init()) {
+		Logger::log(0, "%s: Error - Could not init GPU timers.\n", __FUNCTION__);
+		return false;
+	}
+
+	/* compare with "--no-shader-cache" to see what the program binary cache saves */
+	mRenderData.rdStartupTime = startupTimer.stop();
+	mRenderData.rdShaderLoadTime = Shader::getLoadTime();
+	mRenderData.rdShaderCacheHits = Shader::getCacheHits();
+	mRenderData.rdShaderCacheMisses = Shader::getCacheMisses();
+	Logger::log(0, "%s: startup took %.1f ms, shaders %.1f ms (%i from cache, %i compiled)\n", __FUNCTION__,
+		mRenderData.rdStartupTime, mRenderData.rdShaderLoadTime, mRenderData.rdShaderCacheHits,
+		mRenderData.rdShaderCacheMisses);
+
+	mFrameTimer.start();
+
+	// Init successful
+	Logger::log(1, "%s: Renderer Init Successful.\n", __FUNCTION__);
+	return true;
+}
+
+void OGLRenderer::updateModelLoad() {
+
+	if (mModelLoadFailed) {
+		return;
+	}
+
+	/* worker thread still busy, try again next frame */
+	if (!mModelUploading) {
+		if (!mModelLoad.valid() || mModelLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return;
+		}
 
+		if (!mModelLoad.get()) {
+			Logger::log(0, "%s: Error - loading glTF model '%s' failed\n", __FUNCTION__, mModelFilename.c_str());
+			mModelLoadFailed = true;
+			mRenderData.rdModelLoading = false;
+			return;
+		}
 
-	Logger::log(1, "%s: glTF model '%s' succesfully loaded\n", __FUNCTION__, modelFilename.c_str());
+		/* results of the loader thread, it does not touch mLoadRenderData anymore */
+		mRenderData.rdModelLoadTime = mLoadRenderData.rdModelLoadTime;
+		mRenderData.rdModelLoadPeakRss = mLoadRenderData.rdModelLoadPeakRss;
+		mRenderData.rdModelMapped = mLoadRenderData.rdModelMapped;
+		mRenderData.rdModelCooked = mLoadRenderData.rdModelCooked;
+		mRenderData.rdClipImportTime = mLoadRenderData.rdClipImportTime;
+		mRenderData.rdMeshACMRBefore = mLoadRenderData.rdMeshACMRBefore;
+		mRenderData.rdMeshACMRAfter = mLoadRenderData.rdMeshACMRAfter;
+		mRenderData.rdMeshATVRBefore = mLoadRenderData.rdMeshATVRBefore;
+		mRenderData.rdMeshATVRAfter = mLoadRenderData.rdMeshATVRAfter;
+		mRenderData.rdLodLevels = mLoadRenderData.rdLodLevels;
+		mRenderData.rdBakedAnimationBytes = mLoadRenderData.rdBakedAnimationBytes;
+
+		mGltfModel->createModelBuffers();
+		mRenderData.rdGltfVertexBytes = mGltfModel->getVertexDataSize();
+		mRenderData.rdGltfUnpackedVertexBytes = mGltfModel->getUnpackedVertexDataSize();
+		mModelUploading = true;
+	}
+
+	/* a slice of the vertex, index and texture data per frame */
+	size_t uploadBudget = static_cast<size_t>(std::max(mRenderData.rdUploadBudgetKB, 1)) * 1024;
+	mGltfModel->uploadModelData(uploadBudget);
+	if (mGltfModel->getUploadBytes() > 0) {
+		mRenderData.rdModelLoadProgress = static_cast<float>(mGltfModel->getUploadedBytes()) / mGltfModel->getUploadBytes();
+	}
+
+	if (!mGltfModel->isUploaded()) {
+		return;
+	}
+
+	mModelUploading = false;
+	mRenderData.rdModelLoading = false;
+	if (!finishModelLoad()) {
+		mModelLoadFailed = true;
+		return;
+	}
+
+	mModelReady = true;
+	mRenderData.rdModelReleasedBytes = mGltfModel->getReleasedBytes();
+	std::vector<OGLTextureInfo> modelTextures = mGltfModel->getTextureInfos();
+	mRenderData.rdTextures.insert(mRenderData.rdTextures.end(), modelTextures.begin(), modelTextures.end());
+	mRenderData.rdModelReadyTime = mModelLoadTimer.stop();
+	mRenderData.rdShaderLoadTime = Shader::getLoadTime();
+	mRenderData.rdShaderCacheHits = Shader::getCacheHits();
+	mRenderData.rdShaderCacheMisses = Shader::getCacheMisses();
+	Logger::log(0, "%s: model visible %.1f ms after init, %i bytes uploaded in slices of %i KB\n", __FUNCTION__,
+		mRenderData.rdModelReadyTime, mGltfModel->getUploadBytes(), mRenderData.rdUploadBudgetKB);
+}
+
+bool OGLRenderer::finishModelLoad() {
+
+	/* the packed vertex layout needs the shaders decoding the normals */
+	std::string gltfVertexShader = ASSET_ROOT_DIR "Shaders/gltf_gpu.vert";
+	std::string gltfDualQuatVertexShader = ASSET_ROOT_DIR "Shaders/gltf_gpu_dquat.vert";
+	if (mGltfModel->hasPackedVertices()) {
+		gltfVertexShader = ASSET_ROOT_DIR "Shaders/gltf_gpu_packed.vert";
+		gltfDualQuatVertexShader = ASSET_ROOT_DIR "Shaders/gltf_gpu_dquat_packed.vert";
+	}
+
+	mGltfGPUShader = mAssetRegistry.acquireShader(gltfVertexShader, ASSET_ROOT_DIR "Shaders/gltf_gpu.frag");
+	if (!mGltfGPUShader) {
+		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, gltfVertexShader.c_str(), "shader/gltf_gpu.frag");
+		return false;
+	}
+
+	if (!mGltfGPUShader->hasUniformBlock("DrawConstants"))
+	{
+		Logger::log(0, "%s: Error - Shader has no DrawConstants block.\n", __FUNCTION__);
+		return false;
+	}
+
+	mGltfGPUDualQuatShader = mAssetRegistry.acquireShader(gltfDualQuatVertexShader, ASSET_ROOT_DIR "Shaders/gltf_gpu_dquat.frag");
+	if (!mGltfGPUDualQuatShader) {
+		Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, gltfDualQuatVertexShader.c_str(), "shader/gltf_gpu_dquat.frag");
+		return false;
+	}
+
+	if (!mGltfGPUDualQuatShader->hasUniformBlock("DrawConstants"))
+	{
+		Logger::log(0, "%s: Error - Shader has no DrawConstants block.\n", __FUNCTION__);
+		return false;
+	}
+
+	/* baked clips for the crowd: joint matrices on texture unit 2, clip table in SSBO 7, instances in SSBO 6 */
+	if (mGltfModel->hasBakedAnimations()) {
+		std::string crowdVertexShader = mGltfModel->hasPackedVertices() ?
+			ASSET_ROOT_DIR "Shaders/gltf_crowd_packed.vert" : ASSET_ROOT_DIR "Shaders/gltf_crowd.vert";
+		mGltfCrowdShader = mAssetRegistry.acquireShader(crowdVertexShader, ASSET_ROOT_DIR "Shaders/gltf_gpu.frag");
+		if (!mGltfCrowdShader) {
+			Logger::log(0, "%s: Error - Could not load shaders. \"%s\" and  \"%s\".\n", __FUNCTION__, crowdVertexShader.c_str(), "shader/gltf_gpu.frag");
+			return false;
+		}
+
+		if (!mGltfCrowdShader->hasUniformBlock("DrawConstants"))
+		{
+			Logger::log(0, "%s: Error - Shader has no DrawConstants block.\n", __FUNCTION__);
+			return false;
+		}
+
+		const std::vector<glm::mat4>& bakedMatrices = mGltfModel->getBakedJointMatrices();
+		mCrowdBakedBuffer.init(bakedMatrices.size() * sizeof(glm::mat4));
+		mCrowdBakedBuffer.uploadTboData(bakedMatrices, 2);
+
+		/* time and frame rate are draw constants, the clip table never changes */
+		mCrowdClipData.clear();
+		for (const auto& clip : mGltfModel->getBakedClips()) {
+			mCrowdClipData.emplace_back(static_cast<float>(clip.firstFrame), static_cast<float>(clip.frameCount),
+				clip.duration, 0.0f);
+		}
+		mCrowdClipBuffer.init(mCrowdClipData.size() * sizeof(glm::vec4));
+		mCrowdClipBuffer.uploadSsboData(mCrowdClipData, 7);
+		mCrowdInstanceBuffer.init(mMaxCrowdInstances * 2 * sizeof(glm::vec4));
+	}
+
+	Logger::log(1, "%s: glTF model '%s' succesfully loaded\n", __FUNCTION__, mGltfModel->getModelFilename().c_str());
 
 
 	int numTriangles = 0;	
@@ -125,16 +345,37 @@ bool OGLRenderer::init(unsigned int width, unsigned int height) {
 	mGltfDualQuatSSBuffer.init(modelJointDualQuatBufferSize);
 	Logger::log(1, "%s: glTF joint dual quaternions shader storage buffer (size %i bytes) successfully created\n", __FUNCTION__, modelJointDualQuatBufferSize);
 
-	mLineMesh = std::make_shared<OGLMesh>();
-	Logger::log(1, "%s: line mesh storage initialized\n", __FUNCTION__);
-
-	mFrameTimer.start();
+	/* one palette slot per instance, for the GPU generated skeleton lines */
+	mSkeletonInstanceBuffer.init(mGltfInstances.size() * sizeof(int));
 
-	// Init successful
-	Logger::log(1, "%s: Renderer Init Successful.\n", __FUNCTION__);
 	return true;
 }
 
+bool OGLRenderer::isModelLoading() {
+	return mRenderData.rdModelLoading;
+}
+
+void OGLRenderer::drawLoadingFrame(double tickTime) {
+
+	mGpuBlitTimer.start();
+	if (mSceneTarget) {
+		mSceneTarget->unbindDrawing();
+		mSceneTarget->drawToScreen(mRenderData.rdWidth, mRenderData.rdHeight);
+	}
+	mGpuBlitTimer.stop();
+	mRenderTargetPool.endFrame();
+
+	mLastTickTime = tickTime;
+	if (mRenderData.rdHeadless) {
+		return;
+	}
+
+	mUserInterface.createLoadingFrame(mRenderData);
+	mUserInterface.render();
+	/* ImGui changes program, buffers, textures and capabilities behind the cache */
+	OGLStateCache::invalidate();
+}
+
 void OGLRenderer::setSize(unsigned int width, unsigned int height) {
 
 	if (width == 0 || height == 0) {
@@ -144,15 +385,14 @@ void OGLRenderer::setSize(unsigned int width, unsigned int height) {
 	mRenderData.rdWidth = width;
 	mRenderData.rdHeight = height;
 
-	// Resize buffer
-	mFrameBuffer.resize(width, height);
-	// Resize viewport
-	glViewport(0, 0, width, height);
+	// The scene target is resized in the next frames once the size is stable, the viewport is set in draw()
+	mResizePending = true;
+	mLastResizeTime = std::chrono::steady_clock::now();
 
 	Logger::log(1, "%s: Set Render size to width : %i and height: %i.\n", __FUNCTION__, width, height);
 }
 
-void OGLRenderer::uploadData(OGLMesh vertexData) {
+void OGLRenderer::uploadData(const OGLMesh& vertexData) {
 
 	//mRenderData.rdTriangleCount = vertexData.vertices.size();
 	mVertexBuffer.uploadData(vertexData);
@@ -166,17 +406,45 @@ void OGLRenderer::draw() {
 
 
 	// Get Tick time
-	double tickTime = glfwGetTime();
+	double tickTime = 0.0;
+	if (mRenderData.rdHeadless) {
+		tickTime = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	else {
+		tickTime = glfwGetTime();
+	}
 	mRenderData.rdTickDiff = tickTime - mLastTickTime;
 
+	/* GL calls of the last frame, including the UI */
+	OGLFrameCounters counters = OGLStateCache::getCounters();
+	mRenderData.rdDrawCalls = counters.drawCalls;
+	mRenderData.rdStateBinds = counters.binds;
+	mRenderData.rdSkippedBinds = counters.skippedBinds;
+	mRenderData.rdBufferUploads = counters.bufferUploads;
+	mRenderData.rdBufferUploadBytes = counters.uploadBytes;
+	OGLStateCache::resetCounters();
+
 	mRenderData.rdFrameTime = mFrameTimer.stop();
 	mFrameTimer.start();
 
 	handleMovementKeys();
 
+	/* model data arrives from the loader thread, the uploads are spread over the frames */
+	if (!mModelReady) {
+		updateModelLoad();
+	}
+
 
-	// Bind frame buffer object which will let it receive the vertex data
-	mFrameBuffer.bindDrawing();
+	// Bind frame buffer object which will let it receive the vertex data, or draw to the window directly
+	updateSceneTarget();
+	if (mSceneTarget) {
+		mSceneTarget->bindDrawing();
+		glViewport(0, 0, mSceneTarget->getWidth(), mSceneTarget->getHeight());
+	}
+	else {
+		OGLStateCache::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glViewport(0, 0, mRenderData.rdWidth, mRenderData.rdHeight);
+	}
 
 	// Setup //
 	// Clear screen with a low grey color
@@ -189,6 +457,12 @@ void OGLRenderer::draw() {
 	// Hence the back side of the objects will never be seen and the triangles facing "away" don't need to be drawn
 	//glEnable(GL_CULL_FACE);
 
+	/* empty scene and the progress until the model and its instances exist */
+	if (!mModelReady) {
+		drawLoadingFrame(tickTime);
+		return;
+	}
+
 	mMatrixGenerateTimer.start();
 	// Projection Matrix for view of world
 	// PARAMS - FOV, Aspect Ratio, Near Z distance, Far Z Distance
@@ -197,97 +471,150 @@ void OGLRenderer::draw() {
 
 
 	mRenderData.rdIKTime = 0.0f;
+	mRenderData.rdIKChainCount = 0;
+	mIKBatchSolver.clear();
+	mIKBatchInstances.clear();
 	for (auto& instance : mGltfInstances)
 	{
 		instance->updateAnimation();
 
+		/* independent FABRIK chains wait for the batch, all other chains are solved right away */
 		mIKTimer.start();
-		instance->solveIK();
+		if (mRenderData.rdBatchIK && instance->addIKChains(mIKBatchSolver)) {
+			mIKBatchInstances.push_back(instance);
+		}
+		else {
+			mRenderData.rdIKChainCount += instance->solveIK();
+		}
 		mRenderData.rdIKTime += mIKTimer.stop();
 	}
 
+	mIKTimer.start();
+	mIKBatchSolver.solve();
+	for (auto& instance : mIKBatchInstances) {
+		instance->finishBatchedIK();
+	}
+	mRenderData.rdIKTime += mIKTimer.stop();
+	mRenderData.rdIKChainCount += mIKBatchSolver.getChainCount();
+	mRenderData.rdIKBatchCount = mIKBatchSolver.getBatchCount();
+
+	/* lazy clips nobody used lately are dropped once they exceed the budget */
+	mGltfModel->setClipMemoryBudget(static_cast<size_t>(std::max(mRenderData.rdClipBudgetKB, 0)) * 1024);
+	mGltfModel->collectClips();
+	GltfClipStats clipStats = mGltfModel->getClipStats();
+	mRenderData.rdClipCount = clipStats.clipCount;
+	mRenderData.rdClipsResident = clipStats.residentCount;
+	mRenderData.rdClipBytes = clipStats.residentBytes;
+	mRenderData.rdClipLoads = clipStats.loads;
+	mRenderData.rdClipEvictions = clipStats.evictions;
+	mRenderData.rdClipsStreamed = clipStats.streamedCount;
+	mRenderData.rdStreamMisses = clipStats.streamMisses;
+
 	int selectedInstance = mRenderData.rdCurrentSelectedInstance;
 	glm::vec2 modelWorldPos = mGltfInstances.at(selectedInstance)->getWorldPosition();
 	glm::quat modelWorldRot = mGltfInstances.at(selectedInstance)->getWorldRotation();
 
 
-	mLineMesh->vertices.clear();
+	mDebugDraw.beginFrame();
 
-	/* get gltTF skeleton */
-	mSkeletonLineIndexCount = 0;
-	for (const auto& instance : mGltfInstances)
+	ModelSettings ikSettings = mGltfInstances.at(selectedInstance)->getInstanceSettings();
+	for (const auto& chain : ikSettings.msIkChains)
 	{
-		ModelSettings settings = instance->getInstanceSettings();
-		if (settings.msDrawSkeleton)
+		if (chain.mode == ikMode::ccd || chain.mode == ikMode::fabrik)
 		{
-			std::shared_ptr<OGLMesh> mesh = instance->getSkeleton();
-			mSkeletonLineIndexCount += mesh->vertices.size();
-			mLineMesh->vertices.insert(mLineMesh->vertices.begin(), mesh->vertices.begin(), mesh->vertices.end());
+			mDebugDraw.addAxes(chain.targetWorldPos, modelWorldRot, 0.5f);
 		}
 	}
 
-	mCoordArrowsLineIndexCount = 0;
-	ModelSettings ikSettings = mGltfInstances.at(selectedInstance)->getInstanceSettings();
-	if (ikSettings.msIkMode == ikMode::ccd || ikSettings.msIkMode == ikMode::fabrik)
-	{
-		mCoordArrowsMesh = mCoordArrowsModel.getVertexData();
-		mCoordArrowsLineIndexCount += mCoordArrowsMesh.vertices.size();
-		std::for_each(mCoordArrowsMesh.vertices.begin(), mCoordArrowsMesh.vertices.end(), [=](auto& n)
-			{
-				n.color /= 2.0f;
-				n.position = modelWorldRot * n.position;
-				n.position += ikSettings.msIkTargetWorldPos;
-			});
-
-		mLineMesh->vertices.insert(mLineMesh->vertices.end(), mCoordArrowsMesh.vertices.begin(), mCoordArrowsMesh.vertices.end());
-	}
-
-	mCoordArrowsMesh = mCoordArrowsModel.getVertexData();
-	mCoordArrowsLineIndexCount += mCoordArrowsMesh.vertices.size();
-	std::for_each(mCoordArrowsMesh.vertices.begin(), mCoordArrowsMesh.vertices.end(), [=](auto& n)
-		{
-			n.color /= 2.0f;
-			n.position = modelWorldRot * n.position;
-			n.position += glm::vec3(modelWorldPos.x, 0.0f, modelWorldPos.y);
-		});
-
-	mLineMesh->vertices.insert(mLineMesh->vertices.end(), mCoordArrowsMesh.vertices.begin(), mCoordArrowsMesh.vertices.end());
+	mDebugDraw.addAxes(glm::vec3(modelWorldPos.x, 0.0f, modelWorldPos.y), modelWorldRot, 0.5f);
 
 	mRenderData.rdMatrixGenerateTime = mMatrixGenerateTimer.stop();
 
 
 	mUploadToUBOTimer.start();
-	std::vector<glm::mat4> matrixData;
-	matrixData.push_back(mViewMatrix);
-	matrixData.push_back(mProjectionMatrix);
-	mUniformBuffer.uploadUboData(matrixData, 0);
+	mConstantBuffer.beginFrame();
+	FrameConstants frameConstants{};
+	frameConstants.view = mViewMatrix;
+	frameConstants.projection = mProjectionMatrix;
+	frameConstants.frameTime = glm::vec4(static_cast<float>(tickTime), static_cast<float>(mRenderData.rdTickDiff), 0.0f, 0.0f);
+	mConstantBuffer.pushAndBind(frameConstants, ConstantBlocks::frameBinding);
 
 	mModelJointMatrices.clear();
 	mModelJointDualQuats.clear();
+	mSkeletonMatrixInstances.clear();
+	mSkeletonDualQuatInstances.clear();
 
 	unsigned int matrixInstances = 0;
 	unsigned int dualQuatInstances = 0;
 	unsigned int numTriangles = 0;
 
+	/* palettes are sorted by LOD, every LOD is one instanced draw starting at its base instance */
+	selectInstanceLods();
+	int lodCount = mGltfModel->getLodCount();
+	mMatrixLodInstances.assign(lodCount, 0);
+	mDualQuatLodInstances.assign(lodCount, 0);
+
+	for (int lod = 0; lod < lodCount; ++lod) {
+		for (size_t i = 0; i < mGltfInstances.size(); ++i) {
+			if (mInstanceLods.at(i) != lod) {
+				continue;
+			}
+
+			ModelSettings settings = mGltfInstances.at(i)->getInstanceSettings();
+			if (!settings.msDrawModel) {
+				continue;
+			}
+
+			if (settings.msVertexSkinningMode == skinningMode::dualQuat) {
+				if (settings.msDrawSkeleton) {
+					mSkeletonDualQuatInstances.push_back(dualQuatInstances);
+				}
+				std::vector<glm::mat2x4> quats = mGltfInstances.at(i)->getJointDualQuats();
+				mModelJointDualQuats.insert(mModelJointDualQuats.end(),
+					quats.begin(), quats.end());
+				++dualQuatInstances;
+				++mDualQuatLodInstances.at(lod);
+			}
+			else {
+				if (settings.msDrawSkeleton) {
+					mSkeletonMatrixInstances.push_back(matrixInstances);
+				}
+				std::vector<glm::mat4> mats = mGltfInstances.at(i)->getJointMatrices();
+				mModelJointMatrices.insert(mModelJointMatrices.end(),
+					mats.begin(), mats.end());
+				++matrixInstances;
+				++mMatrixLodInstances.at(lod);
+			}
+			numTriangles += mGltfModel->getLodTriangleCount(lod);
+		}
+	}
+
+	mRenderData.rdLodInstances.assign(lodCount, 0);
+	for (int lod = 0; lod < lodCount; ++lod) {
+		mRenderData.rdLodInstances.at(lod) = mMatrixLodInstances.at(lod) + mDualQuatLodInstances.at(lod);
+	}
+
+	/* hidden models with visible skeleton: palettes go behind the drawn instances */
+	unsigned int skeletonOnlyMatrixPos = matrixInstances;
+	unsigned int skeletonOnlyDualQuatPos = dualQuatInstances;
 	for (const auto& instance : mGltfInstances) {
 		ModelSettings settings = instance->getInstanceSettings();
-		if (!settings.msDrawModel) {
+		if (settings.msDrawModel || !settings.msDrawSkeleton) {
 			continue;
 		}
 
 		if (settings.msVertexSkinningMode == skinningMode::dualQuat) {
+			mSkeletonDualQuatInstances.push_back(skeletonOnlyDualQuatPos++);
 			std::vector<glm::mat2x4> quats = instance->getJointDualQuats();
 			mModelJointDualQuats.insert(mModelJointDualQuats.end(),
 				quats.begin(), quats.end());
-			++dualQuatInstances;
 		}
 		else {
+			mSkeletonMatrixInstances.push_back(skeletonOnlyMatrixPos++);
 			std::vector<glm::mat4> mats = instance->getJointMatrices();
 			mModelJointMatrices.insert(mModelJointMatrices.end(),
 				mats.begin(), mats.end());
-			++matrixInstances;
 		}
-		numTriangles += mGltfModel->getTriangleCount();
 	}
 
 	mRenderData.rdTriangleCount = numTriangles;
@@ -295,12 +622,15 @@ void OGLRenderer::draw() {
 	mGltfTextureBuffer.uploadTboData(mModelJointMatrices, 1);
 	mGltfDualQuatSSBuffer.uploadSsboData(mModelJointDualQuats, 2);
 	mRenderData.rdUploadToUBOTime = mUploadToUBOTimer.stop();
+	mRenderData.rdSkeletonInstanceCount = mSkeletonMatrixInstances.size() + mSkeletonDualQuatInstances.size();
 
 
-	/* upload vertex data */
+	/* upload debug lines, arrows and axes */
 	mUploadToVBOTimer.start();
 
-	uploadData(*mLineMesh);
+	mDebugDraw.upload();
+	mRenderData.rdDebugDrawVertexCount = mDebugDraw.getVertexCount();
+	mRenderData.rdDebugDrawUploadBytes = mDebugDraw.getUploadedBytes();
 
 	mRenderData.rdUploadToVBOTime = mUploadToVBOTimer.stop();
 
@@ -310,33 +640,112 @@ void OGLRenderer::draw() {
 	unsigned int matrixPos = 0;
 
 	/* draw the glTF models */
-	mGltfGPUShader.use();
+	mGltfGPUShader->use();
 	mGltfTextureBuffer.bind();
 
-	/* set SSBO stride, identical for ALL models */
-	mGltfGPUShader.setUniformValue(mGltfInstances.at(0)->getJointMatrixSize());
-	mGltfModel->drawInstanced(matrixInstances);
+	mGpuMatrixDrawTimer.start();
+	/* palette stride, identical for ALL models */
+	pushDrawConstants(mGltfInstances.at(0)->getJointMatrixSize());
+	int baseInstance = 0;
+	for (int lod = 0; lod < lodCount; ++lod) {
+		mGltfModel->drawInstanced(mMatrixLodInstances.at(lod), lod, baseInstance);
+		baseInstance += mMatrixLodInstances.at(lod);
+	}
+	mGpuMatrixDrawTimer.stop();
+
+	mGpuDualQuatDrawTimer.start();
+	mGltfGPUDualQuatShader->use();
+	pushDrawConstants(mGltfInstances.at(0)->getJointDualQuatsSize());
+	baseInstance = 0;
+	for (int lod = 0; lod < lodCount; ++lod) {
+		mGltfModel->drawInstanced(mDualQuatLodInstances.at(lod), lod, baseInstance);
+		baseInstance += mDualQuatLodInstances.at(lod);
+	}
+	mGpuDualQuatDrawTimer.stop();
+
+	/* crowd: only the time changes per frame, the instances are uploaded when their number changes */
+	mRenderData.rdCrowdInstances = std::clamp(mRenderData.rdCrowdInstances, 0, mMaxCrowdInstances);
+	if (mGltfModel->hasBakedAnimations() && mRenderData.rdCrowdInstances > 0) {
+		mGpuCrowdDrawTimer.start();
+		if (mCrowdInstanceCount != mRenderData.rdCrowdInstances) {
+			createCrowdInstances(mRenderData.rdCrowdInstances);
+		}
 
-	mGltfGPUDualQuatShader.use();
-	mGltfGPUDualQuatShader.setUniformValue(mGltfInstances.at(0)->getJointDualQuatsSize());
-	mGltfModel->drawInstanced(dualQuatInstances);
+		if (mCrowdStartTime < 0.0) {
+			mCrowdStartTime = tickTime;
+		}
 
-	if (mCoordArrowsLineIndexCount > 0) {
-		mLineShader.use();
-		mVertexBuffer.bindAndDraw(GL_LINES, mSkeletonLineIndexCount, mCoordArrowsLineIndexCount);
+		int crowdLod = std::clamp(mRenderData.rdCrowdLod, 0, lodCount - 1);
+		mGltfCrowdShader->use();
+		mCrowdBakedBuffer.bind();
+		pushDrawConstants(mGltfInstances.at(0)->getJointMatrixSize(),
+			glm::vec4(static_cast<float>(tickTime - mCrowdStartTime), mGltfModel->getBakedFrameRate(), 0.0f, 0.0f));
+		mGltfModel->drawInstanced(mCrowdInstanceCount, crowdLod);
+		mRenderData.rdTriangleCount += mCrowdInstanceCount * mGltfModel->getLodTriangleCount(crowdLod);
+		mGpuCrowdDrawTimer.stop();
 	}
 
+	/* skeleton lines, generated on the GPU from the joint palettes */
+	mGpuLineDrawTimer.start();
+	if (!mSkeletonMatrixInstances.empty() || !mSkeletonDualQuatInstances.empty()) {
+		OGLStateCache::setCapability(GL_DEPTH_TEST, false);
+
+		mSkeletonGPUShader->use();
+		mGltfTextureBuffer.bind();
+		pushDrawConstants(mGltfInstances.at(0)->getJointMatrixSize());
+		mSkeletonInstanceBuffer.uploadSsboData(mSkeletonMatrixInstances, 5);
+		mGltfModel->drawSkeletonInstanced(mSkeletonMatrixInstances.size());
+
+		mSkeletonGPUDualQuatShader->use();
+		pushDrawConstants(mGltfInstances.at(0)->getJointDualQuatsSize());
+		mSkeletonInstanceBuffer.uploadSsboData(mSkeletonDualQuatInstances, 5);
+		mGltfModel->drawSkeletonInstanced(mSkeletonDualQuatInstances.size());
 
-	if (mSkeletonLineIndexCount > 0) {
-		glDisable(GL_DEPTH_TEST);
-		mLineShader.use();
-		mVertexBuffer.bindAndDraw(GL_LINES, 0, mSkeletonLineIndexCount);
-		glEnable(GL_DEPTH_TEST);
+		OGLStateCache::setCapability(GL_DEPTH_TEST, true);
 	}
 
-	mFrameBuffer.unbindDrawing();
+	mLineShader->use();
+	mDebugDraw.draw();
+	mRenderData.rdDebugDrawCalls = mDebugDraw.getDrawCallCount();
+	mGpuLineDrawTimer.stop();
 
-	mFrameBuffer.drawToScreen();
+	/* full screen copy, only needed with the offscreen target */
+	mGpuBlitTimer.start();
+	if (mSceneTarget) {
+		mSceneTarget->unbindDrawing();
+		mSceneTarget->drawToScreen(mRenderData.rdWidth, mRenderData.rdHeight);
+	}
+	mGpuBlitTimer.stop();
+
+	mRenderData.rdConstantBytes = mConstantBuffer.getUploadedBytes();
+	mConstantBuffer.endFrame();
+	mRenderTargetPool.endFrame();
+	mRenderData.rdRenderTargets = mRenderTargetPool.getTargetCount();
+	mRenderData.rdRenderTargetAllocations = mRenderTargetPool.getAllocationCount();
+
+	/* unreferenced assets stay cached until the registry exceeds its budget */
+	mAssetRegistry.setMemoryBudget(static_cast<size_t>(std::max(mRenderData.rdAssetBudgetMB, 0)) * 1024 * 1024);
+	mAssetRegistry.collectGarbage();
+	AssetRegistryStats assetStats = mAssetRegistry.getStats();
+	mRenderData.rdAssetCount = assetStats.assetCount;
+	mRenderData.rdAssetBytes = assetStats.assetBytes;
+	mRenderData.rdAssetHits = assetStats.hits;
+	mRenderData.rdAssetLoads = assetStats.loads;
+	mRenderData.rdAssetEvictions = assetStats.evictions;
+
+	/* results are a few frames old, reading them never waits for the GPU */
+	mRenderData.rdGpuMatrixDrawTime = mGpuMatrixDrawTimer.getResult();
+	mRenderData.rdGpuDualQuatDrawTime = mGpuDualQuatDrawTimer.getResult();
+	mRenderData.rdGpuLineDrawTime = mGpuLineDrawTimer.getResult();
+	mRenderData.rdGpuBlitTime = mGpuBlitTimer.getResult();
+	mRenderData.rdGpuUIDrawTime = mGpuUIDrawTimer.getResult();
+	mRenderData.rdGpuCrowdDrawTime = mGpuCrowdDrawTimer.getResult();
+
+	// No UI without a window
+	if (mRenderData.rdHeadless) {
+		mLastTickTime = tickTime;
+		return;
+	}
 
 	mUIGenerateTimer.start();
 
@@ -348,7 +757,11 @@ void OGLRenderer::draw() {
 	mRenderData.rdUIGenerateTime = mUIGenerateTimer.stop();
 
 	mUIDrawTimer.start();
+	mGpuUIDrawTimer.start();
 	mUserInterface.render();
+	/* ImGui changes program, buffers, textures and capabilities behind the cache */
+	OGLStateCache::invalidate();
+	mGpuUIDrawTimer.stop();
 	mRenderData.rdUIDrawTime = mUIDrawTimer.stop();
 
 	mLastTickTime = tickTime;
@@ -357,6 +770,32 @@ void OGLRenderer::draw() {
 
 }
 
+void OGLRenderer::createCrowdInstances(int instanceCount)
+{
+	std::vector<GltfBakedClip> clips = mGltfModel->getBakedClips();
+
+	/* two vec4 per instance: x/z position, y rotation, clip | start time, speed */
+	std::vector<glm::vec4> instanceData{};
+	instanceData.reserve(instanceCount * 2);
+
+	/* rows of 100 behind the animated instances */
+	for (int i = 0; i < instanceCount; ++i) {
+		int clip = std::rand() % clips.size();
+		float xPos = (i % 100) * 1.5f - 75.0f;
+		float zPos = -25.0f - (i / 100) * 1.5f;
+		float rotation = glm::radians(static_cast<float>(std::rand() % 360));
+		float startTime = (std::rand() % 1000) / 1000.0f * clips.at(clip).duration;
+		float speed = (std::rand() % 50) / 100.0f + 0.75f;
+
+		instanceData.emplace_back(xPos, zPos, rotation, static_cast<float>(clip));
+		instanceData.emplace_back(startTime, speed, 0.0f, 0.0f);
+	}
+
+	mCrowdInstanceBuffer.uploadSsboData(instanceData, 6);
+	mCrowdInstanceCount = instanceCount;
+	Logger::log(1, "%s: %i crowd instances created\n", __FUNCTION__, instanceCount);
+}
+
 void OGLRenderer::handleKeyEvents(int key, int scancode, int action, int mods)
 {
 	if (glfwGetKey(mRenderData.rdWindow, GLFW_KEY_SPACE) == GLFW_PRESS) {
@@ -368,6 +807,10 @@ void OGLRenderer::handleKeyEvents(int key, int scancode, int action, int mods)
 
 void OGLRenderer::handleMovementKeys()
 {
+	if (mRenderData.rdHeadless) {
+		return;
+	}
+
 	// Forward Movement
 	mRenderData.rdMoveForward = 0;
 	if (glfwGetKey(mRenderData.rdWindow, GLFW_KEY_W) == GLFW_PRESS)
@@ -505,23 +948,145 @@ void OGLRenderer::handleMousePositionEvents(double xPos, double yPos)
 	}
 }
 
+void OGLRenderer::selectInstanceLods()
+{
+	int lodCount = mGltfModel->getLodCount();
+	mInstanceLods.assign(mGltfInstances.size(), 0);
+	if (!mRenderData.rdEnableLod || lodCount < 2) {
+		return;
+	}
+
+	glm::vec4 boundingSphere = mGltfModel->getBoundingSphere();
+	float halfFovTan = std::tan(glm::radians(static_cast<float>(mRenderData.rdFieldOfView)) * 0.5f);
+
+	for (size_t i = 0; i < mGltfInstances.size(); ++i) {
+		glm::vec2 worldPos = mGltfInstances.at(i)->getWorldPosition();
+		glm::vec3 center = glm::vec3(worldPos.x, 0.0f, worldPos.y) + glm::vec3(boundingSphere);
+		float distance = std::max(glm::length(center - mRenderData.rdCameraWorldPosition), 0.01f);
+
+		/* part of the screen height covered by the bounding sphere, every LOD halves the threshold */
+		float screenSize = boundingSphere.w / (distance * halfFovTan) * mRenderData.rdLodBias;
+		float threshold = mRenderData.rdLodScreenSize;
+		int lod = 0;
+		while (lod < lodCount - 1 && screenSize < threshold) {
+			++lod;
+			threshold *= 0.5f;
+		}
+		mInstanceLods.at(i) = lod;
+	}
+}
+
+void OGLRenderer::pushDrawConstants(int paletteStride, const glm::vec4& clipInfo) {
+
+	DrawConstants drawConstants{};
+	drawConstants.palette = glm::ivec4(paletteStride, 0, 0, 0);
+	drawConstants.clipInfo = clipInfo;
+	mConstantBuffer.pushAndBind(drawConstants, ConstantBlocks::drawBinding);
+}
+
+void OGLRenderer::updateSceneTarget() {
+
+	if (mRenderData.rdDirectToBackbuffer) {
+		if (mSceneTarget) {
+			mRenderTargetPool.release(mSceneTarget);
+			mSceneTarget = nullptr;
+		}
+		return;
+	}
+
+	unsigned int width = mRenderData.rdWidth;
+	unsigned int height = mRenderData.rdHeight;
+
+	if (!mSceneTarget) {
+		mSceneTarget = mRenderTargetPool.acquire(width, height);
+		mResizePending = false;
+		return;
+	}
+
+	if (!mResizePending) {
+		return;
+	}
+
+	// No new allocation needed, the new size fits into the current attachments
+	if (mSceneTarget->fits(width, height)) {
+		mSceneTarget->resize(width, height);
+	}
+
+	// While the window is still being resized, the old target is drawn scaled to the window
+	double sinceResize = std::chrono::duration<double>(std::chrono::steady_clock::now() - mLastResizeTime).count();
+	if (sinceResize < mResizeDebounceTime) {
+		return;
+	}
+	mResizePending = false;
+
+	// Trade the target for a better fitting one if it is too small or wastes memory, the old one stays in the pool
+	float allocArea = static_cast<float>(mSceneTarget->getAllocWidth()) * static_cast<float>(mSceneTarget->getAllocHeight());
+	if (!mSceneTarget->fits(width, height) || allocArea > 2.0f * width * height) {
+		mRenderTargetPool.release(mSceneTarget);
+		mSceneTarget = mRenderTargetPool.acquire(width, height);
+	}
+}
+
+bool OGLRenderer::saveFrame(const std::string& fileName) {
+
+	std::vector<unsigned char> pixels{};
+	if (mSceneTarget) {
+		pixels = mSceneTarget->readColorPixels();
+	}
+	else {
+		// Drawn straight to the window, read back the default frame buffer
+		pixels.resize(mRenderData.rdWidth * mRenderData.rdHeight * 4);
+		OGLStateCache::bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, mRenderData.rdWidth, mRenderData.rdHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+	if (pixels.empty()) {
+		return false;
+	}
+
+	// OpenGL has the origin at the bottom left, PNG at the top left
+	stbi_flip_vertically_on_write(1);
+	if (!stbi_write_png(fileName.c_str(), mRenderData.rdWidth, mRenderData.rdHeight, 4, pixels.data(), mRenderData.rdWidth * 4)) {
+		return false;
+	}
+
+	Logger::log(1, "%s: Frame saved to '%s'\n", __FUNCTION__, fileName.c_str());
+	return true;
+}
+
 void OGLRenderer::cleanup() {
 
 	Logger::log(1, "%s: Cleaning up renderer...\n", __FUNCTION__);
 
-	mGltfModel->cleanup();
+	/* the loader thread may still work on the model */
+	mLoaderPool.cleanup();
+	mGltfInstances.clear();
+	mGltfMatrixInstances.clear();
+	mGltfDQInstances.clear();
 	mGltfModel.reset();
-	
+	/* models and shaders are owned by the registry */
+	mAssetRegistry.cleanup();
 
-	mGltfGPUDualQuatShader.cleanup();
-	mGltfGPUShader.cleanup();
-	mUserInterface.cleanup();
-	mLineShader.cleanup();
+	if (!mRenderData.rdHeadless) {
+		mUserInterface.cleanup();
+	}
 	mVertexBuffer.cleanup();
+	mDebugDraw.cleanup();
+	mGpuMatrixDrawTimer.cleanup();
+	mGpuDualQuatDrawTimer.cleanup();
+	mGpuLineDrawTimer.cleanup();
+	mGpuBlitTimer.cleanup();
+	mGpuUIDrawTimer.cleanup();
+	mGpuCrowdDrawTimer.cleanup();
+	mCrowdBakedBuffer.cleanup();
+	mCrowdInstanceBuffer.cleanup();
+	mCrowdClipBuffer.cleanup();
 	mGltfTextureBuffer.cleanup();
 	mGltfDualQuatSSBuffer.cleanup();
-	mUniformBuffer.cleanup();
-	mFrameBuffer.cleanup();
+	mSkeletonInstanceBuffer.cleanup();
+	mConstantBuffer.cleanup();
+	mSceneTarget = nullptr;
+	mRenderTargetPool.cleanup();
 
 	Logger::log(1, "%s: Renderer cleaned successfully.\n", __FUNCTION__);
 }
\ No newline at end of file
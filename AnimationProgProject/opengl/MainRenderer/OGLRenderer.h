@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <chrono>
+#include <future>
 // OpenGL Mathematics Lib
 #include <glm/glm.hpp>
 // Matrix roation
@@ -19,14 +21,18 @@
 // Lib for window operations (make sure after glad lib since it detects and changes based on glad)
 #include <GLFW/glfw3.h>
 
-#include "buffers/frameBuffer/FrameBuffer.h"
-#include "buffers/vertexBuffer/VertexBuffer.h"
-#include "buffers/uniformBuffer/UniformBuffer.h"
+#include "Buffers/FrameBuffer/FrameBuffer.h"
+#include "Buffers/RenderTargetPool/RenderTargetPool.h"
+#include "Buffers/VertexBuffer/VertexBuffer.h"
+#include "buffers/constantBuffer/ConstantBuffer.h"
 #include "buffers/shaderStorageBuffer/ShaderStorageBuffer.h"
 #include "textures/Texture.h"
 #include "shaders/Shader.h"
+#include "assetRegistry/AssetRegistry.h"
 #include "../userInterface/UserInterface.h"
 #include "../timer/Timer.h"
+#include "../timer/GpuTimer.h"
+#include <ThreadPool.h>
 #include "../camera/Camera.h"
 #include "../models/Model.h"
 #include "../models/arrow/ArrowModel.h"
@@ -37,6 +43,7 @@
 #include "OGLRenderData.h"
 #include "../../models/gltf/GltfInstance.h"
 #include <buffers/textureBuffer/TextureBuffer.h>
+#include "../debugDraw/DebugDraw.h"
 
 
 class OGLRenderer {
@@ -48,7 +55,8 @@ public:
 	// Initialize and create the OpenGL objects we need for drawing
 	// @param width - Width of Renderer
 	// @param height - Height of Renderer
-	bool init(unsigned int width, unsigned int height);
+	// @param procLoader - GL function loader, GLFW if not set (EGL for the headless mode)
+	bool init(unsigned int width, unsigned int height, GLADloadproc procLoader = nullptr);
 
 	// Changes dimentsions fo Renderer
 	// @param width - Width of Renderer
@@ -60,11 +68,18 @@ public:
 
 	// Store the triangle and texture data from the model
 	// @param vertexData - The model extract the data from
-	void uploadData(OGLMesh vertexData);
+	void uploadData(const OGLMesh& vertexData);
 
-	// Draws triangles to frame buffer
+	// Draws triangles to frame buffer, only the loading progress until the model is uploaded
 	void draw();
 
+	// True while the model is parsed or uploaded, false once it is drawn or loading failed
+	bool isModelLoading();
+
+	// Writes the last rendered frame as PNG file
+	// @param fileName - Name of the PNG file
+	bool saveFrame(const std::string& fileName);
+
 	// Handles keyboard events
 	void handleKeyEvents(int key, int scancode, int action, int mods);
 	void handleMovementKeys();
@@ -74,25 +89,68 @@ public:
 	void handleMouseButtonEvents(int button, int action, int mods);
 	void handleMousePositionEvents(double xPos, double yPos);
 
+	// Model loaded by init, .glb and .apmodel files are memory mapped, .gltf files parsed as text
+	// @param fileName - Name of the glTF file
+	static void setModelFileName(std::string fileName);
+
+	// Model data uploaded per frame while the model is loading
+	// @param kiloBytes - Budget in KB, at least 1
+	static void setUploadBudget(int kiloBytes);
+
+	// Frees the glTF data or the mapped cooked file once the model is on the GPU
+	// @param enabled - false keeps the CPU copies for the whole run
+	static void setResidentMinimal(bool enabled);
+
+	// Creates the animation clips on first use instead of at load
+	// @param enabled - true loads clips lazily and drops unused ones above the clip budget
+	static void setLazyClips(bool enabled);
+
+	// Clips with more keyframe data only keep a few time windows resident and read the next ones in the background
+	// @param kiloBytes - Threshold in KB, 0 streams every clip
+	static void setStreamClipThreshold(int kiloBytes);
+
 
 
 private:
 
 	OGLRenderData mRenderData{};
 
+	static std::string mModelFilename;
+	static int mUploadBudgetKB;
+	static bool mResidentMinimal;
+	static bool mLazyClips;
+	static int mStreamClipKB;
+
 	Shader mBasicShader{};
 	Shader mChangedShader{};
-	Shader mLineShader{};
 	Shader mGltfShader{};
-	Shader mGltfGPUShader{};
-	Shader mGltfGPUDualQuatShader{};
 
-	FrameBuffer mFrameBuffer{};
+	/* shared models, textures and shaders, loaded once per file content */
+	AssetRegistry mAssetRegistry{};
+	std::shared_ptr<Shader> mLineShader = nullptr;
+	std::shared_ptr<Shader> mGltfGPUShader = nullptr;
+	std::shared_ptr<Shader> mGltfGPUDualQuatShader = nullptr;
+	std::shared_ptr<Shader> mSkeletonGPUShader = nullptr;
+	std::shared_ptr<Shader> mSkeletonGPUDualQuatShader = nullptr;
+
+	/* offscreen scene target, only used if a pass needs the intermediate image */
+	RenderTargetPool mRenderTargetPool{};
+	FrameBuffer* mSceneTarget = nullptr;
+	void updateSceneTarget();
+
+	/* window resizes are collected until the size is stable, then the scene target is reallocated once */
+	bool mResizePending = false;
+	std::chrono::steady_clock::time_point mLastResizeTime{};
+	static constexpr double mResizeDebounceTime = 0.15;
 	VertexBuffer mVertexBuffer{};
-	UniformBuffer mUniformBuffer{};
+	/* frame and draw constants for all shaders, streamed through one mapped ring buffer */
+	ConstantBuffer mConstantBuffer{};
+	void pushDrawConstants(int paletteStride, const glm::vec4& clipInfo = glm::vec4(0.0f));
 	TextureBuffer mGltfTextureBuffer{};
 	//ShaderStorageBuffer mGltfShaderStorageBuffer{};
 	ShaderStorageBuffer mGltfDualQuatSSBuffer{};
+	ShaderStorageBuffer mSkeletonInstanceBuffer{};
+	DebugDraw mDebugDraw{};
 
 	Texture mTex{};
 
@@ -103,14 +161,19 @@ private:
 	Timer mUIGenerateTimer{};
 	Timer mUIDrawTimer{};
 	Timer mIKTimer{};
+	IKBatchSolver mIKBatchSolver{};
+	std::vector<std::shared_ptr<GltfInstance>> mIKBatchInstances{};
+
+	/* GPU side execution time of the render passes */
+	GpuTimer mGpuMatrixDrawTimer{};
+	GpuTimer mGpuDualQuatDrawTimer{};
+	GpuTimer mGpuLineDrawTimer{};
+	GpuTimer mGpuBlitTimer{};
+	GpuTimer mGpuUIDrawTimer{};
 	Camera mCamera{};
 
 	UserInterface mUserInterface{};
 
-	CoordArrowsModel mCoordArrowsModel{};
-	OGLMesh mCoordArrowsMesh{};
-	OGLMesh mIKCoordArrowsMesh{};
-
 	ArrowModel mArrowModel{};
 	OGLMesh mStartPosArrowMesh{};
 	OGLMesh mEndPosArrowMesh{};
@@ -124,18 +187,50 @@ private:
 	std::vector<std::shared_ptr<GltfInstance>>  mGltfDQInstances{};
 	std::shared_ptr<GltfModel> mGltfModel = nullptr;
 
+	/* the model is parsed and decoded by the loader thread, uploaded by draw() within rdUploadBudgetKB per frame */
+	ThreadPool mLoaderPool{};
+	std::shared_future<bool> mModelLoad{};
+	/* settings copy for the loader thread, its stats are taken over when the job is done */
+	OGLRenderData mLoadRenderData{};
+	bool mModelUploading = false;
+	bool mModelReady = false;
+	bool mModelLoadFailed = false;
+	Timer mModelLoadTimer{};
+	void updateModelLoad();
+	bool finishModelLoad();
+	void drawLoadingFrame(double tickTime);
+
 	std::vector<glm::mat4> mModelJointMatrices{};
 	std::vector<glm::mat2x4> mModelJointDualQuats{};
 
+	/* palette slots of the instances with a visible skeleton */
+	std::vector<int> mSkeletonMatrixInstances{};
+	std::vector<int> mSkeletonDualQuatInstances{};
+
+	/* LOD per instance, and the number of instances drawn per LOD */
+	std::vector<int> mInstanceLods{};
+	std::vector<int> mMatrixLodInstances{};
+	std::vector<int> mDualQuatLodInstances{};
+	void selectInstanceLods();
+
+	/* background crowd, animated from the baked clips without CPU work per instance */
+	std::shared_ptr<Shader> mGltfCrowdShader = nullptr;
+	TextureBuffer mCrowdBakedBuffer{};
+	ShaderStorageBuffer mCrowdInstanceBuffer{};
+	ShaderStorageBuffer mCrowdClipBuffer{};
+	std::vector<glm::vec4> mCrowdClipData{};
+	int mCrowdInstanceCount = 0;
+	double mCrowdStartTime = -1.0;
+	static const int mMaxCrowdInstances = 50000;
+	GpuTimer mGpuCrowdDrawTimer{};
+	void createCrowdInstances(int instanceCount);
+
 	std::unique_ptr<Model> mModel = nullptr;
 	std::unique_ptr<OGLMesh> mModelMesh = nullptr;
 	std::unique_ptr<OGLMesh> mAllMeshes = nullptr;
-	std::shared_ptr<OGLMesh> mLineMesh = nullptr;
 
 
 	unsigned int mLineIndexCount = 0;
-	unsigned int mSkeletonLineIndexCount = 0;
-	unsigned int mCoordArrowsLineIndexCount = 0;
 
 	glm::quat mQuatModelOrientation[2] = { glm::quat() , glm::quat() };
 	glm::quat mQuatModelOrientationConjugate[2] = { glm::quat() , glm::quat() };
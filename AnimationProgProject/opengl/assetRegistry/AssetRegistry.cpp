@@ -0,0 +1,175 @@
+#include <filesystem>
+#include <limits>
+#include "AssetRegistry.h"
+#include "../Logger/Logger.h"
+
+namespace {
+	const uint64_t fnvOffset = 14695981039346656037ull;
+	const uint64_t fnvPrime = 1099511628211ull;
+
+	// FNV-1a, continues the given hash
+	uint64_t hashBytes(uint64_t hash, const unsigned char* data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= data[i];
+			hash *= fnvPrime;
+		}
+		return hash;
+	}
+
+	uint64_t hashKeys(uint64_t firstKey, uint64_t secondKey) {
+		uint64_t hash = hashBytes(fnvOffset, reinterpret_cast<const unsigned char*>(&firstKey), sizeof(firstKey));
+		return hashBytes(hash, reinterpret_cast<const unsigned char*>(&secondKey), sizeof(secondKey));
+	}
+}
+
+uint64_t AssetRegistry::getFileKey(const std::string& fileName) {
+
+	std::error_code error;
+	std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(fileName, error);
+	std::string pathName = error ? fileName : canonicalPath.string();
+
+	// missing files get a key of their own, the load fails later with the usual error
+	uint64_t pathHash = hashBytes(fnvOffset, reinterpret_cast<const unsigned char*>(pathName.data()), pathName.size());
+	uint64_t fileSize = std::filesystem::file_size(pathName, error);
+	if (error) {
+		return pathHash;
+	}
+	int64_t fileTime = std::filesystem::last_write_time(pathName, error).time_since_epoch().count();
+	if (error) {
+		return pathHash;
+	}
+
+	// only the directory entry is read, the content is read once by the loader
+	return hashKeys(hashKeys(pathHash, fileSize), static_cast<uint64_t>(fileTime));
+}
+
+GltfModelHandle AssetRegistry::acquireModel(const std::string& modelFileName, const std::string& textureFileName,
+	const GltfModelLoader& loader) {
+
+	// cooked models carry their texture, the texture file does not change them
+	uint64_t textureKey = GltfModel::isCookedModel(modelFileName) ? 0 : getFileKey(textureFileName);
+	uint64_t key = hashKeys(getFileKey(modelFileName), textureKey);
+
+	GltfModelHandle handle{};
+	auto modelIter = mModels.find(key);
+	if (modelIter != mModels.end()) {
+		modelIter->second.lastUse = ++mUseCounter;
+		++mStats.hits;
+		Logger::log(1, "%s: Reusing model '%s' for '%s'.\n", __FUNCTION__, modelIter->second.name.c_str(),
+			modelFileName.c_str());
+		handle.model = modelIter->second.asset;
+		handle.loaded = modelIter->second.loaded;
+		return handle;
+	}
+
+	ModelEntry entry{};
+	entry.asset = std::make_shared<GltfModel>();
+	entry.name = modelFileName;
+	entry.lastUse = ++mUseCounter;
+	entry.loaded = loader(entry.asset);
+	++mStats.loads;
+
+	handle.model = entry.asset;
+	handle.loaded = entry.loaded;
+	handle.created = true;
+	mModels.emplace(key, std::move(entry));
+	return handle;
+}
+
+std::shared_ptr<Shader> AssetRegistry::acquireShader(const std::string& vertexShaderFileName,
+	const std::string& fragmentShaderFileName) {
+
+	uint64_t key = hashKeys(getFileKey(vertexShaderFileName), getFileKey(fragmentShaderFileName));
+
+	auto shaderIter = mShaders.find(key);
+	if (shaderIter != mShaders.end()) {
+		shaderIter->second.lastUse = ++mUseCounter;
+		++mStats.hits;
+		return shaderIter->second.asset;
+	}
+
+	std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+	if (!shader->loadShaders(vertexShaderFileName, fragmentShaderFileName)) {
+		Logger::log(0, "%s: Error - Could not load shaders \"%s\" and \"%s\".\n", __FUNCTION__,
+			vertexShaderFileName.c_str(), fragmentShaderFileName.c_str());
+		return nullptr;
+	}
+	++mStats.loads;
+
+	AssetEntry<Shader> entry{};
+	entry.asset = shader;
+	entry.name = vertexShaderFileName;
+	entry.lastUse = ++mUseCounter;
+	mShaders.emplace(key, std::move(entry));
+	return shader;
+}
+
+void AssetRegistry::setMemoryBudget(size_t bytes) {
+	mMemoryBudget = bytes;
+}
+
+size_t AssetRegistry::getModelBytes(const ModelEntry& entry) {
+
+	// the upload of a loading model has not started yet, the size is still unknown
+	if (!entry.loaded.valid() || entry.loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return 0;
+	}
+	return entry.asset->getGpuBytes();
+}
+
+void AssetRegistry::collectGarbage() {
+
+	size_t totalBytes = 0;
+	for (const auto& model : mModels) {
+		totalBytes += getModelBytes(model.second);
+	}
+
+	while (totalBytes > mMemoryBudget) {
+		// least recently acquired model only the registry holds, shaders have no size and are kept
+		uint64_t oldestUse = std::numeric_limits<uint64_t>::max();
+		auto oldestModel = mModels.end();
+		for (auto iter = mModels.begin(); iter != mModels.end(); ++iter) {
+			if (iter->second.asset.use_count() == 1 && iter->second.lastUse < oldestUse &&
+				getModelBytes(iter->second) > 0) {
+				oldestUse = iter->second.lastUse;
+				oldestModel = iter;
+			}
+		}
+
+		if (oldestModel != mModels.end()) {
+			size_t bytes = getModelBytes(oldestModel->second);
+			Logger::log(1, "%s: Evicting model '%s' (%zu bytes).\n", __FUNCTION__,
+				oldestModel->second.name.c_str(), bytes);
+			oldestModel->second.asset->cleanup();
+			mModels.erase(oldestModel);
+			totalBytes -= bytes;
+		}
+		else {
+			// everything left is in use
+			break;
+		}
+		++mStats.evictions;
+	}
+}
+
+AssetRegistryStats AssetRegistry::getStats() {
+
+	mStats.assetCount = static_cast<unsigned int>(mModels.size() + mShaders.size());
+	mStats.assetBytes = 0;
+	for (const auto& model : mModels) {
+		mStats.assetBytes += getModelBytes(model.second);
+	}
+	return mStats;
+}
+
+void AssetRegistry::cleanup() {
+
+	for (auto& model : mModels) {
+		model.second.asset->cleanup();
+	}
+	for (auto& shader : mShaders) {
+		shader.second.asset->cleanup();
+	}
+	mModels.clear();
+	mShaders.clear();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "../shaders/Shader.h"
+#include "../../models/gltf/GltfModel.h"
+
+// Model handed out by the registry, models requested before share the running or finished load
+struct GltfModelHandle {
+	std::shared_ptr<GltfModel> model = nullptr;
+	std::shared_future<bool> loaded{};
+	bool created = false;
+};
+
+// Starts the load of a new model, e.g. prepareModel on a worker thread
+using GltfModelLoader = std::function<std::shared_future<bool>(std::shared_ptr<GltfModel>)>;
+
+struct AssetRegistryStats {
+	unsigned int assetCount = 0;
+	size_t assetBytes = 0;
+	unsigned int hits = 0;
+	unsigned int loads = 0;
+	unsigned int evictions = 0;
+};
+
+// Loads every model and shader only once. Assets are found by their canonical file path, size and modification
+// time, so a second path to the same file reuses the loaded asset, and a changed file is loaded again. The files
+// are not read for the key, the first read happens in the loader. Textures are part of the model that uses them.
+// Models nobody else holds a handle to stay cached and are deleted, least recently used first, as soon as the
+// registry exceeds its memory budget.
+class AssetRegistry {
+	public:
+		// Returns the model of the files, the loader is only called if the model is not loaded yet
+		// @param modelFileName - glTF, .glb or cooked model
+		// @param textureFileName - Texture of the model, ignored by cooked models
+		// @param loader - Starts the load of the new model
+		GltfModelHandle acquireModel(const std::string& modelFileName, const std::string& textureFileName,
+			const GltfModelLoader& loader);
+
+		// Compiles (or reads from the binary cache) the program on the first request, nullptr on errors
+		// @param vertexShaderFileName - Vertex shader source
+		// @param fragmentShaderFileName - Fragment shader source
+		std::shared_ptr<Shader> acquireShader(const std::string& vertexShaderFileName, const std::string& fragmentShaderFileName);
+
+		// GPU memory for unreferenced assets, 0 deletes them as soon as they are released
+		// @param bytes - Budget for all assets together
+		void setMemoryBudget(size_t bytes);
+
+		// Deletes unreferenced models until the registry is within the budget, call once per frame
+		void collectGarbage();
+
+		AssetRegistryStats getStats();
+
+		// Deletes all assets, the handles still held must not be used anymore
+		void cleanup();
+
+	private:
+		template <typename T>
+		struct AssetEntry {
+			std::shared_ptr<T> asset;
+			std::string name;
+			uint64_t lastUse = 0;
+		};
+
+		struct ModelEntry : AssetEntry<GltfModel> {
+			std::shared_future<bool> loaded;
+		};
+
+		std::unordered_map<uint64_t, ModelEntry> mModels{};
+		std::unordered_map<uint64_t, AssetEntry<Shader>> mShaders{};
+
+		size_t mMemoryBudget = 512 * 1024 * 1024;
+		uint64_t mUseCounter = 0;
+		AssetRegistryStats mStats{};
+
+		// Hash of canonical path, size and modification time, only the path if the file does not exist
+		uint64_t getFileKey(const std::string& fileName);
+		size_t getModelBytes(const ModelEntry& entry);
+};
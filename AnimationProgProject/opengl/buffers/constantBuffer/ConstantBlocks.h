@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// std140 layouts of the constant blocks, they must match the blocks in the shaders
+namespace ConstantBlocks {
+	// Uniform buffer binding points
+	const unsigned int frameBinding = 0;
+	const unsigned int drawBinding = 8;
+}
+
+// Written once per frame, "FrameConstants" in all shaders
+struct FrameConstants {
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	// x: time in seconds, y: frame delta
+	glm::vec4 frameTime = glm::vec4(0.0f);
+};
+
+// Written for every draw or batch of instances, "DrawConstants" in the skinning and skeleton shaders
+struct DrawConstants {
+	glm::mat4 world = glm::mat4(1.0f);
+	// x: joints per palette, y: first palette slot added to the instance index
+	glm::ivec4 palette = glm::ivec4(0);
+	// x: playback time of the baked clips, y: baked frame rate
+	glm::vec4 clipInfo = glm::vec4(0.0f);
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstring>
+#include "ConstantBuffer.h"
+#include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
+
+bool ConstantBuffer::init(size_t bytesPerFrame) {
+
+	Logger::log(1, "%s: Initing constant buffer...\n", __FUNCTION__);
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0) {
+		mAlignment = alignment;
+	}
+
+	if (!createBuffer(bytesPerFrame)) {
+		Logger::log(0, "%s: Error - Could not create constant buffer.\n", __FUNCTION__);
+		return false;
+	}
+
+	Logger::log(1, "%s: Constant buffer with %i segments of %i bytes created (alignment %i).\n", __FUNCTION__,
+		mNumSegments, static_cast<int>(mSegmentSize), static_cast<int>(mAlignment));
+	return true;
+}
+
+bool ConstantBuffer::createBuffer(size_t segmentSize) {
+
+	// Segments have to start at an aligned offset too
+	mSegmentSize = (segmentSize + mAlignment - 1) / mAlignment * mAlignment;
+	mFrameBlocks.resize(mSegmentSize);
+
+	glGenBuffers(1, &mBuffer);
+	OGLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+
+	// Immutable storage, mapped once and kept mapped for the lifetime of the buffer
+	GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	size_t bufferSize = mNumSegments * mSegmentSize;
+	glBufferStorage(GL_UNIFORM_BUFFER, bufferSize, nullptr, storageFlags);
+	mMappedData = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, bufferSize, storageFlags));
+
+	return mMappedData != nullptr;
+}
+
+void ConstantBuffer::deleteBuffer() {
+
+	for (unsigned int i = 0; i < mNumSegments; ++i) {
+		waitForSegment(i);
+	}
+
+	if (mMappedData) {
+		OGLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		mMappedData = nullptr;
+	}
+
+	glDeleteBuffers(1, &mBuffer);
+
+	// the new buffer may get the same name
+	OGLStateCache::invalidate();
+}
+
+void ConstantBuffer::waitForSegment(unsigned int segment) {
+
+	GLsync& fence = mSegmentFences[segment];
+	if (!fence) {
+		return;
+	}
+
+	// Only blocks if the gpu is more than two frames behind
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void ConstantBuffer::beginFrame() {
+
+	mCurrentSegment = (mCurrentSegment + 1) % mNumSegments;
+	mWriteOffset = 0;
+	mBoundRanges.fill(BoundRange{});
+	waitForSegment(mCurrentSegment);
+}
+
+GLintptr ConstantBuffer::push(const void* data, size_t size) {
+
+	if (mWriteOffset + size > mSegmentSize) {
+
+		// Keep what was already written this frame at the same offsets, the bound ranges are moved to the new buffer
+		size_t newSize = std::max(mSegmentSize * 2, mWriteOffset + size);
+		Logger::log(1, "%s: growing constant buffer from %i to %i bytes per segment\n", __FUNCTION__,
+			static_cast<int>(mSegmentSize), static_cast<int>(newSize));
+
+		deleteBuffer();
+		createBuffer(newSize);
+
+		mCurrentSegment = 0;
+		std::memcpy(mMappedData, mFrameBlocks.data(), mWriteOffset);
+		for (unsigned int i = 0; i < mMaxBindings; ++i) {
+			if (mBoundRanges.at(i).size > 0) {
+				bindRange(i, mBoundRanges.at(i).offset, mBoundRanges.at(i).size);
+			}
+		}
+	}
+
+	GLintptr offset = mCurrentSegment * mSegmentSize + mWriteOffset;
+	std::memcpy(mMappedData + offset, data, size);
+	std::memcpy(mFrameBlocks.data() + mWriteOffset, data, size);
+	OGLStateCache::countUpload(size);
+
+	mWriteOffset = (mWriteOffset + size + mAlignment - 1) / mAlignment * mAlignment;
+	return offset - mCurrentSegment * mSegmentSize;
+}
+
+void ConstantBuffer::bindRange(GLuint bindingPoint, GLintptr offset, size_t size) {
+
+	if (bindingPoint < mMaxBindings) {
+		mBoundRanges.at(bindingPoint) = { offset, size };
+	}
+	OGLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, mBuffer, mCurrentSegment * mSegmentSize + offset, size);
+}
+
+void ConstantBuffer::endFrame() {
+
+	if (mSegmentFences[mCurrentSegment]) {
+		glDeleteSync(mSegmentFences[mCurrentSegment]);
+	}
+	mSegmentFences[mCurrentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+size_t ConstantBuffer::getUploadedBytes() {
+	return mWriteOffset;
+}
+
+void ConstantBuffer::cleanup() {
+
+	Logger::log(1, "%s: Cleaning constant buffer...\n", __FUNCTION__);
+	deleteBuffer();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glad/glad.h>
+
+#include "ConstantBlocks.h"
+
+// Persistently mapped uniform buffer used as a ring for all constant blocks of a frame.
+// Every block is copied to the next aligned offset of the current segment and bound with glBindBufferRange,
+// so there is no glBufferSubData and no temporary vector per upload.
+class ConstantBuffer {
+	public:
+
+		// Allocates the buffer, split into ring segments
+		// @param bytesPerFrame - Size of a single segment
+		bool init(size_t bytesPerFrame);
+
+		// Waits until the next segment is no longer used by the gpu and makes it the current one
+		void beginFrame();
+
+		// Copies a block into the current segment
+		// @param data - Block data
+		// @param size - Size of the block in bytes
+		// @return - Offset of the block, relative to the current segment
+		GLintptr push(const void* data, size_t size);
+
+		// Copies a block into the current segment and binds it to the uniform binding point
+		// @param block - Block data, std140 layout
+		// @param bindingPoint - Binding point of the block in the shaders
+		template <typename T>
+		void pushAndBind(const T& block, GLuint bindingPoint) {
+			GLintptr offset = push(&block, sizeof(T));
+			bindRange(bindingPoint, offset, sizeof(T));
+		}
+
+		// Fences the current segment so it will not be overwritten while the gpu still reads from it
+		void endFrame();
+
+		// Bytes written into the current segment
+		size_t getUploadedBytes();
+
+		// Cleans up buffer, mapping and fences
+		void cleanup();
+
+	private:
+
+		// Number of segments, the gpu can read two frames while the cpu writes the third one
+		static const unsigned int mNumSegments = 3;
+
+		GLuint mBuffer = 0;
+		unsigned char* mMappedData = nullptr;
+
+		// CPU copy of the blocks pushed this frame, the mapping is write only and cannot be copied when growing
+		std::vector<unsigned char> mFrameBlocks{};
+
+		size_t mSegmentSize = 0;
+		size_t mWriteOffset = 0;
+		unsigned int mCurrentSegment = 0;
+
+		// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, every block starts at a multiple of it
+		size_t mAlignment = 256;
+
+		GLsync mSegmentFences[mNumSegments] = { nullptr, nullptr, nullptr };
+
+		// Ranges bound this frame, bound again if the buffer has to grow
+		static const unsigned int mMaxBindings = 16;
+		struct BoundRange {
+			GLintptr offset = 0;
+			size_t size = 0;
+		};
+		std::array<BoundRange, mMaxBindings> mBoundRanges{};
+
+		bool createBuffer(size_t segmentSize);
+		void deleteBuffer();
+		void waitForSegment(unsigned int segment);
+		void bindRange(GLuint bindingPoint, GLintptr offset, size_t size);
+};
@@ -1,6 +1,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "ShaderStorageBuffer.h"
-#include "../logger/Logger.h"
+#include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
 void ShaderStorageBuffer::init(size_t bufferSize)
 {
 	mBufferSize = bufferSize;
@@ -8,13 +9,13 @@ void ShaderStorageBuffer::init(size_t bufferSize)
 	glGenBuffers(1, &mSsboBuffer);
 
 	// Bind uniform buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
 
 	// Allocate mem for 2 4x4 matrices 
 	glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
 
 
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
 }
 
@@ -27,16 +28,14 @@ void ShaderStorageBuffer::uploadSsboData(std::vector<glm::mat4> bufferData, int
 
 	size_t buffersize = bufferData.size() * sizeof(glm::mat4);
 	// Bind buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
 
 	// Upload data
 	// PARAMS: BufferType, upload offset in buffer, size of upload, values)
 	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, buffersize, bufferData.data());
+	OGLStateCache::countUpload(buffersize);
 
-	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
-
-	// Unbind buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	OGLStateCache::bindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
 
 }
 
@@ -49,16 +48,42 @@ void ShaderStorageBuffer::uploadSsboData(std::vector<glm::mat2x4> bufferData, in
 
 	size_t buffersize = bufferData.size() * sizeof(glm::mat2x4);
 	// Bind buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
 
 	// Upload data
 	// PARAMS: BufferType, upload offset in buffer, size of upload, values)
 	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, buffersize, bufferData.data());
+	OGLStateCache::countUpload(buffersize);
+
+	OGLStateCache::bindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
+}
+
+void ShaderStorageBuffer::uploadSsboData(const std::vector<int>& bufferData, int bindingPoint)
+{
+	if (bufferData.size() == 0)
+	{
+		return;
+	}
+
+	size_t buffersize = bufferData.size() * sizeof(int);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, buffersize, bufferData.data());
+	OGLStateCache::countUpload(buffersize);
+	OGLStateCache::bindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
+}
 
-	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
+void ShaderStorageBuffer::uploadSsboData(const std::vector<glm::vec4>& bufferData, int bindingPoint)
+{
+	if (bufferData.size() == 0)
+	{
+		return;
+	}
 
-	// Unbind buffer
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	size_t buffersize = bufferData.size() * sizeof(glm::vec4);
+	OGLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSsboBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, buffersize, bufferData.data());
+	OGLStateCache::countUpload(buffersize);
+	OGLStateCache::bindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingPoint, mSsboBuffer, 0, buffersize);
 }
 
 void ShaderStorageBuffer::cleanup()
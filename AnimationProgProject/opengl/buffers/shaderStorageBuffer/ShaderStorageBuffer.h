@@ -9,6 +9,8 @@ public:
 	void init(size_t bufferSize);
 	void uploadSsboData(std::vector<glm::mat4> bufferData, int bindingPoint);
 	void uploadSsboData(std::vector<glm::mat2x4> bufferData, int bindingPoint);
+	void uploadSsboData(const std::vector<int>& bufferData, int bindingPoint);
+	void uploadSsboData(const std::vector<glm::vec4>& bufferData, int bindingPoint);
 	void cleanup();
 
 private:
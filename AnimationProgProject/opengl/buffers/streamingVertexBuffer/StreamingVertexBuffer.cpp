@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstring>
+#include "StreamingVertexBuffer.h"
+#include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
+
+bool StreamingVertexBuffer::init(size_t maxVerticesPerFrame) {
+
+	Logger::log(1, "%s: Initing streaming vertex buffer...\n", __FUNCTION__);
+
+	if (!createBuffer(maxVerticesPerFrame)) {
+		Logger::log(0, "%s: Error - Could not create streaming vertex buffer.\n", __FUNCTION__);
+		return false;
+	}
+
+	Logger::log(1, "%s: Streaming vertex buffer with %i segments of %i vertices created.\n", __FUNCTION__, mNumSegments, mSegmentVertices);
+	return true;
+}
+
+bool StreamingVertexBuffer::createBuffer(size_t verticesPerSegment) {
+
+	mSegmentVertices = verticesPerSegment;
+
+	glGenVertexArrays(1, &mVAO);
+	glGenBuffers(1, &mVertexVBO);
+
+	OGLStateCache::bindVertexArray(mVAO);
+	OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
+
+	// Immutable storage, mapped once and kept mapped for the lifetime of the buffer
+	GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	size_t bufferSize = mNumSegments * mSegmentVertices * sizeof(OGLVertex);
+	glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, storageFlags);
+	mMappedData = static_cast<OGLVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, storageFlags));
+
+	// Same layout as the VertexBuffer class, so the line shader can be used unchanged
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(OGLVertex), (void*)offsetof(OGLVertex, position));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(OGLVertex), (void*)offsetof(OGLVertex, color));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(OGLVertex), (void*)offsetof(OGLVertex, uv));
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+	OGLStateCache::bindVertexArray(0);
+
+	return mMappedData != nullptr;
+}
+
+void StreamingVertexBuffer::deleteBuffer() {
+
+	for (unsigned int i = 0; i < mNumSegments; ++i) {
+		waitForSegment(i);
+	}
+
+	if (mMappedData) {
+		OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexVBO);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		OGLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+		mMappedData = nullptr;
+	}
+
+	glDeleteBuffers(1, &mVertexVBO);
+	glDeleteVertexArrays(1, &mVAO);
+
+	// the new buffer may get the same names
+	OGLStateCache::invalidate();
+}
+
+void StreamingVertexBuffer::waitForSegment(unsigned int segment) {
+
+	GLsync& fence = mSegmentFences[segment];
+	if (!fence) {
+		return;
+	}
+
+	// Only blocks if the gpu is more than two frames behind
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void StreamingVertexBuffer::beginFrame() {
+
+	mCurrentSegment = (mCurrentSegment + 1) % mNumSegments;
+	mWriteOffset = 0;
+	waitForSegment(mCurrentSegment);
+}
+
+void StreamingVertexBuffer::reserve(size_t vertexCount) {
+
+	if (vertexCount <= mSegmentVertices) {
+		return;
+	}
+	if (mWriteOffset > 0) {
+		Logger::log(0, "%s: Error - %i vertices were already appended in this frame, cannot grow the buffer\n", __FUNCTION__, mWriteOffset);
+		return;
+	}
+
+	// Nothing was written to the current segment yet, the old buffer only has to be drained before the switch
+	size_t newSize = std::max(mSegmentVertices * 2, vertexCount);
+	Logger::log(1, "%s: growing streaming vertex buffer from %i to %i vertices per segment\n", __FUNCTION__, mSegmentVertices, newSize);
+
+	deleteBuffer();
+	createBuffer(newSize);
+	mCurrentSegment = 0;
+}
+
+unsigned int StreamingVertexBuffer::append(const std::vector<OGLVertex>& vertices) {
+
+	unsigned int start = mWriteOffset;
+	if (vertices.empty()) {
+		return start;
+	}
+
+	if (mWriteOffset + vertices.size() > mSegmentVertices) {
+		Logger::log(0, "%s: Error - %i vertices do not fit into the segment, call reserve() first\n", __FUNCTION__, vertices.size());
+		return start;
+	}
+
+	std::memcpy(mMappedData + mCurrentSegment * mSegmentVertices + mWriteOffset, vertices.data(), vertices.size() * sizeof(OGLVertex));
+	OGLStateCache::countUpload(vertices.size() * sizeof(OGLVertex));
+	mWriteOffset += vertices.size();
+
+	return start;
+}
+
+void StreamingVertexBuffer::endFrame() {
+
+	if (mSegmentFences[mCurrentSegment]) {
+		glDeleteSync(mSegmentFences[mCurrentSegment]);
+	}
+	mSegmentFences[mCurrentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamingVertexBuffer::bind() {
+	OGLStateCache::bindVertexArray(mVAO);
+}
+
+void StreamingVertexBuffer::unbind() {
+	OGLStateCache::bindVertexArray(0);
+}
+
+void StreamingVertexBuffer::draw(GLuint mode, unsigned int start, unsigned int num) {
+
+	// dropped vertices were never written
+	num = std::min(num, mWriteOffset - std::min(start, mWriteOffset));
+	if (num == 0) {
+		return;
+	}
+	glDrawArrays(mode, mCurrentSegment * mSegmentVertices + start, num);
+	OGLStateCache::countDrawCall();
+}
+
+unsigned int StreamingVertexBuffer::getVertexCount() {
+	return mWriteOffset;
+}
+
+size_t StreamingVertexBuffer::getUploadedBytes() {
+	return mWriteOffset * sizeof(OGLVertex);
+}
+
+void StreamingVertexBuffer::cleanup() {
+
+	Logger::log(1, "%s: Cleaning streaming vertex buffer...\n", __FUNCTION__);
+	deleteBuffer();
+}
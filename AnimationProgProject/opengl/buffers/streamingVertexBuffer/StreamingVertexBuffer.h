@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "../../MainRenderer/OGLRenderData.h"
+
+class StreamingVertexBuffer {
+	public:
+
+		// Allocates a persistently mapped buffer split into ring segments
+		// @param maxVerticesPerFrame - Number of vertices that fit into a single segment
+		bool init(size_t maxVerticesPerFrame);
+
+		// Waits until the next segment is no longer used by the gpu and makes it the current one
+		void beginFrame();
+
+		// Grows the buffer if the current segment cannot hold the vertices of this frame, must be called
+		// before the first append of the frame, the mapping is write only and cannot be copied over
+		// @param vertexCount - Number of vertices that will be appended in this frame
+		void reserve(size_t vertexCount);
+
+		// Appends vertices to the current segment, vertices that do not fit into the segment are dropped
+		// @param vertices - Vertices to copy into the mapped memory
+		// @return - Index of the first appended vertex, relative to the current segment
+		unsigned int append(const std::vector<OGLVertex>& vertices);
+
+		// Fences the current segment so it will not be overwritten while the gpu still reads from it
+		void endFrame();
+
+		// Draws vertices from the current segment
+		// @param mode - Rendering mode (GL_LINES etc.)
+		// @param start - The first vertex, relative to the current segment
+		// @param num - Number of vertices to render
+		void draw(GLuint mode, unsigned int start, unsigned int num);
+
+		void bind();
+		void unbind();
+
+		// Number of vertices and bytes written into the current segment
+		unsigned int getVertexCount();
+		size_t getUploadedBytes();
+
+		// Cleans up buffer, mapping and fences
+		void cleanup();
+
+	private:
+
+		// Number of segments, the gpu can read two frames while the cpu writes the third one
+		static const unsigned int mNumSegments = 3;
+
+		GLuint mVAO = 0;
+		GLuint mVertexVBO = 0;
+
+		// Persistent mapping of the whole buffer
+		OGLVertex* mMappedData = nullptr;
+
+		size_t mSegmentVertices = 0;
+		unsigned int mCurrentSegment = 0;
+		unsigned int mWriteOffset = 0;
+
+		GLsync mSegmentFences[mNumSegments] = { nullptr, nullptr, nullptr };
+
+		bool createBuffer(size_t verticesPerSegment);
+		void deleteBuffer();
+		void waitForSegment(unsigned int segment);
+};
@@ -1,6 +1,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "UniformBuffer.h"
-#include "../logger/Logger.h"
+#include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
 void UniformBuffer::init(size_t bufferSize)
 {
 	mBufferSize = bufferSize;
@@ -8,13 +9,13 @@ void UniformBuffer::init(size_t bufferSize)
 	glGenBuffers(1, &mUboBuffer);
 
 	// Bind uniform buffer
-	glBindBuffer(GL_UNIFORM_BUFFER, mUboBuffer);
+	OGLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mUboBuffer);
 
 	// Allocate mem for 2 4x4 matrices 
 	glBufferData(GL_UNIFORM_BUFFER, bufferSize, NULL, GL_STATIC_DRAW);
 
 
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	OGLStateCache::bindBuffer(GL_UNIFORM_BUFFER, 0);
 
 }
 
@@ -27,16 +28,14 @@ void UniformBuffer::uploadUboData(std::vector<glm::mat4> bufferData, int binding
 
 	size_t buffersize = bufferData.size() * sizeof(glm::mat4);
 	// Bind buffer
-	glBindBuffer(GL_UNIFORM_BUFFER, mUboBuffer);
+	OGLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mUboBuffer);
 
 	// Upload data
 	// PARAMS: BufferType, upload offset in buffer, size of upload, values)
 	glBufferSubData(GL_UNIFORM_BUFFER, 0, buffersize, bufferData.data());
+	OGLStateCache::countUpload(buffersize);
 
-	glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, mUboBuffer, 0, buffersize);
-
-	// Unbind buffer
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	OGLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, mUboBuffer, 0, buffersize);
 
 }
 
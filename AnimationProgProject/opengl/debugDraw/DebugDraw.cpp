@@ -0,0 +1,142 @@
+#include "DebugDraw.h"
+#include "../Logger/Logger.h"
+#include <stateCache/OGLStateCache.h>
+
+bool DebugDraw::init(size_t maxVerticesPerFrame) {
+
+	if (!mStreamingBuffer.init(maxVerticesPerFrame)) {
+		Logger::log(0, "%s: Error - Could not init debug draw buffer.\n", __FUNCTION__);
+		return false;
+	}
+
+	ArrowModel arrowModel;
+	CoordArrowsModel coordArrowsModel;
+	mArrowMesh = arrowModel.getVertexData();
+	mCoordArrowsMesh = coordArrowsModel.getVertexData();
+
+	/* reserve once, the batches are only cleared between frames */
+	for (auto& batch : mBatches) {
+		batch.vertices.reserve(maxVerticesPerFrame / static_cast<int>(debugDrawType::NUM));
+	}
+
+	/* skeleton lines are visible through the model */
+	setDepthTest(debugDrawType::lines, false);
+
+	Logger::log(1, "%s: debug draw initialized\n", __FUNCTION__);
+	return true;
+}
+
+DebugDraw::DebugDrawBatch& DebugDraw::getBatch(debugDrawType type) {
+	return mBatches[static_cast<int>(type)];
+}
+
+void DebugDraw::setDepthTest(debugDrawType type, bool depthTest) {
+	getBatch(type).depthTest = depthTest;
+}
+
+void DebugDraw::beginFrame() {
+	for (auto& batch : mBatches) {
+		batch.vertices.clear();
+	}
+	mDrawCallCount = 0;
+}
+
+void DebugDraw::addLine(glm::vec3 start, glm::vec3 end, glm::vec3 color) {
+	addLine(start, end, color, color);
+}
+
+void DebugDraw::addLine(glm::vec3 start, glm::vec3 end, glm::vec3 startColor, glm::vec3 endColor) {
+	std::vector<OGLVertex>& vertices = getBatch(debugDrawType::lines).vertices;
+
+	OGLVertex vertex{};
+	vertex.position = start;
+	vertex.color = startColor;
+	vertices.emplace_back(vertex);
+
+	vertex.position = end;
+	vertex.color = endColor;
+	vertices.emplace_back(vertex);
+}
+
+void DebugDraw::addArrow(glm::vec3 start, glm::vec3 end, glm::vec3 color) {
+	glm::vec3 direction = end - start;
+	float length = glm::length(direction);
+	if (length < 0.0001f) {
+		return;
+	}
+
+	/* the template arrow points to the X axis and has a length of 1 */
+	glm::quat rotation = glm::rotation(glm::vec3(1.0f, 0.0f, 0.0f), direction / length);
+
+	std::vector<OGLVertex>& vertices = getBatch(debugDrawType::arrows).vertices;
+	for (const auto& templateVertex : mArrowMesh.vertices) {
+		OGLVertex vertex = templateVertex;
+		vertex.position = rotation * (templateVertex.position * length) + start;
+		vertex.color = color;
+		vertices.emplace_back(vertex);
+	}
+}
+
+void DebugDraw::addAxes(glm::vec3 position, glm::quat rotation, float colorScale) {
+	std::vector<OGLVertex>& vertices = getBatch(debugDrawType::axes).vertices;
+	for (const auto& templateVertex : mCoordArrowsMesh.vertices) {
+		OGLVertex vertex = templateVertex;
+		vertex.position = rotation * templateVertex.position + position;
+		vertex.color = templateVertex.color * colorScale;
+		vertices.emplace_back(vertex);
+	}
+}
+
+void DebugDraw::upload() {
+	mStreamingBuffer.beginFrame();
+
+	/* the buffer grows before anything is written, the batches are the only copy of the vertices */
+	size_t vertexCount = 0;
+	for (const auto& batch : mBatches) {
+		vertexCount += batch.vertices.size();
+	}
+	mStreamingBuffer.reserve(vertexCount);
+
+	for (auto& batch : mBatches) {
+		batch.bufferStart = mStreamingBuffer.append(batch.vertices);
+	}
+}
+
+void DebugDraw::draw() {
+	mStreamingBuffer.bind();
+
+	/* depth tested batches first, overlays must not be hidden by them */
+	for (const auto& batch : mBatches) {
+		if (batch.depthTest && !batch.vertices.empty()) {
+			mStreamingBuffer.draw(GL_LINES, batch.bufferStart, batch.vertices.size());
+			++mDrawCallCount;
+		}
+	}
+
+	OGLStateCache::setCapability(GL_DEPTH_TEST, false);
+	for (const auto& batch : mBatches) {
+		if (!batch.depthTest && !batch.vertices.empty()) {
+			mStreamingBuffer.draw(GL_LINES, batch.bufferStart, batch.vertices.size());
+			++mDrawCallCount;
+		}
+	}
+	OGLStateCache::setCapability(GL_DEPTH_TEST, true);
+
+	mStreamingBuffer.endFrame();
+}
+
+unsigned int DebugDraw::getVertexCount() {
+	return mStreamingBuffer.getVertexCount();
+}
+
+unsigned int DebugDraw::getDrawCallCount() {
+	return mDrawCallCount;
+}
+
+size_t DebugDraw::getUploadedBytes() {
+	return mStreamingBuffer.getUploadedBytes();
+}
+
+void DebugDraw::cleanup() {
+	mStreamingBuffer.cleanup();
+}
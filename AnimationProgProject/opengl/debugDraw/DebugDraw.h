@@ -0,0 +1,66 @@
+/* immediate mode debug lines, arrows and axes */
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "../MainRenderer/OGLRenderData.h"
+#include "../buffers/streamingVertexBuffer/StreamingVertexBuffer.h"
+#include "../../models/arrow/ArrowModel.h"
+#include "../../models/arrow/CoordArrowsModel.h"
+
+enum class debugDrawType {
+	lines = 0,
+	arrows,
+	axes,
+	NUM
+};
+
+class DebugDraw {
+public:
+
+	// Creates the streaming buffer and caches the arrow templates
+	// @param maxVerticesPerFrame - Initial capacity, the buffer grows if a frame needs more
+	bool init(size_t maxVerticesPerFrame);
+
+	// Drops all primitives of the last frame, keeps the allocated memory
+	void beginFrame();
+
+	void addLine(glm::vec3 start, glm::vec3 end, glm::vec3 color);
+	void addLine(glm::vec3 start, glm::vec3 end, glm::vec3 startColor, glm::vec3 endColor);
+	void addArrow(glm::vec3 start, glm::vec3 end, glm::vec3 color);
+	void addAxes(glm::vec3 position, glm::quat rotation, float colorScale = 1.0f);
+
+	// Copies all batches into the streaming buffer
+	void upload();
+
+	// Draws one draw call per non-empty batch, must be called after upload()
+	void draw();
+
+	// Lines are drawn on top of the scene (skeletons), arrows and axes are depth tested
+	void setDepthTest(debugDrawType type, bool depthTest);
+
+	unsigned int getVertexCount();
+	unsigned int getDrawCallCount();
+	size_t getUploadedBytes();
+
+	void cleanup();
+
+private:
+	struct DebugDrawBatch {
+		std::vector<OGLVertex> vertices{};
+		unsigned int bufferStart = 0;
+		bool depthTest = true;
+	};
+
+	DebugDrawBatch mBatches[static_cast<int>(debugDrawType::NUM)];
+	StreamingVertexBuffer mStreamingBuffer{};
+
+	OGLMesh mArrowMesh{};
+	OGLMesh mCoordArrowsMesh{};
+
+	unsigned int mDrawCallCount = 0;
+
+	DebugDrawBatch& getBatch(debugDrawType type);
+};
@@ -1,36 +1,148 @@
 #include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <algorithm>
 #include "../Logger/Logger.h"
+#include "../timer/Timer.h"
+#include <stateCache/OGLStateCache.h>
+#include <buffers/constantBuffer/ConstantBlocks.h>
 #include "Shader.h"
 
+std::string Shader::mCacheDirectory = "ShaderCache";
+int Shader::mCacheHits = 0;
+int Shader::mCacheMisses = 0;
+float Shader::mLoadTime = 0.0f;
+
+namespace {
+	const char cacheMagic[4] = { 'A', 'P', 'S', 'B' };
+	const uint32_t cacheVersion = 1;
+
+	// Stored in front of the driver specific program binary
+	struct ProgramBinaryHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	// FNV-1a, with a separator so that moving text between two strings changes the hash
+	uint64_t hashString(uint64_t hash, const std::string& text) {
+		for (const unsigned char c : text) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		hash ^= 0xff;
+		hash *= 1099511628211ull;
+		return hash;
+	}
+
+	std::string getGLString(GLenum name) {
+		const GLubyte* glString = glGetString(name);
+		return glString ? reinterpret_cast<const char*>(glString) : "";
+	}
+}
+
 bool Shader::loadShaders(std::string vertexShaderFileName, std::string fragmentShaderFileName) {
 
 	Logger::log(1, " %s : Loading Shaders...\n", __FUNCTION__);
 
-	GLuint vertexShader = readShader(vertexShaderFileName, GL_VERTEX_SHADER);
+	Timer loadTimer{};
+	loadTimer.start();
 
-	if (!vertexShader) {
+	// The sources are always read, a changed file must not use the old binary
+	std::string vertexShaderText;
+	if (!readShaderFile(vertexShaderFileName, vertexShaderText)) {
 
 		Logger::log(0, " %s : Error - Failed to load Vertex Shader.\n", __FUNCTION__);
 
 		return false;
 	}
 
-	GLuint fragmentShader = readShader(fragmentShaderFileName, GL_FRAGMENT_SHADER);
+	std::string fragmentShaderText;
+	if (!readShaderFile(fragmentShaderFileName, fragmentShaderText)) {
+
+		Logger::log(0, " %s : Error - Failed to load Fragment Shader.\n", __FUNCTION__);
+
+		return false;
+	}
+
+	GLint numBinaryFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+	bool useCache = !mCacheDirectory.empty() && numBinaryFormats > 0;
+
+	uint64_t cacheKey = 0;
+	if (useCache) {
+		cacheKey = getCacheKey(vertexShaderText, fragmentShaderText);
+		if (loadProgramBinary(cacheKey)) {
+			cacheLocations();
+			bindUniformBlocks();
+			++mCacheHits;
+			mLoadTime += loadTimer.stop();
+
+			Logger::log(1, " %s : Loaded Shaders from cache file %s.\n", __FUNCTION__, getCacheFileName(cacheKey).c_str());
+			return true;
+		}
+		++mCacheMisses;
+	}
+
+	GLuint vertexShader = compileShader(vertexShaderText, GL_VERTEX_SHADER);
+
+	if (!vertexShader) {
+
+		Logger::log(0, " %s : Error - Failed to compile Vertex Shader %s.\n", __FUNCTION__, vertexShaderFileName.c_str());
+
+		return false;
+	}
+
+	GLuint fragmentShader = compileShader(fragmentShaderText, GL_FRAGMENT_SHADER);
 
 	if (!fragmentShader) {
 		
-		Logger::log(0, " %s : Error - Failed to load Fragment Shader.\n", __FUNCTION__);
+		Logger::log(0, " %s : Error - Failed to compile Fragment Shader %s.\n", __FUNCTION__, fragmentShaderFileName.c_str());
+		glDeleteShader(vertexShader);
 
 		return false;
 	}
 
 	// OpenGL calls to create shader objects and link them
+	if (!linkProgram(vertexShader, fragmentShader, useCache)) {
+		return false;
+	}
+
+	cacheLocations();
+	bindUniformBlocks();
+
+	if (useCache) {
+		saveProgramBinary(cacheKey);
+	}
+	mLoadTime += loadTimer.stop();
+	
+	Logger::log(1, " %s : Loaded Shaders Successfully.\n", __FUNCTION__);
+
+
+	return true;
+
+}
+
+bool Shader::linkProgram(GLuint vertexShader, GLuint fragmentShader, bool retrievable) {
 
 	mShaderProgram = glCreateProgram();
+
+	// Tell the driver we want to read the binary back after linking
+	if (retrievable) {
+		glProgramParameteri(mShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	glAttachShader(mShaderProgram, vertexShader);
 	glAttachShader(mShaderProgram, fragmentShader);
 	glLinkProgram(mShaderProgram);
 
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
 	GLint isProgramLinked;
 
 	glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &isProgramLinked);
@@ -40,33 +152,84 @@ bool Shader::loadShaders(std::string vertexShaderFileName, std::string fragmentS
 		return false;
 	}
 
-	// Extracts location of block with passed in name from the compiled shader program
-	GLint uboIndex = glGetUniformBlockIndex(mShaderProgram, "Matrices");
+	return true;
+}
 
-	// The location is then bound to passed index of the uniform buffer in the shader file (see basic.vert and changed.vert)
-	glUniformBlockBinding(mShaderProgram, uboIndex, 0);
+void Shader::cacheLocations() {
+
+	mUniformLocations.clear();
+	mUniformBlockIndices.clear();
+	mStorageBlockIndices.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramInterfaceiv(mShaderProgram, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+	GLint maxNameLength = 0;
+	glGetProgramInterfaceiv(mShaderProgram, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+	std::vector<char> name(std::max(maxNameLength, 1));
+
+	for (GLint i = 0; i < uniformCount; ++i) {
+		// Members of uniform blocks have no location
+		const GLenum locationProperty = GL_LOCATION;
+		GLint location = -1;
+		glGetProgramResourceiv(mShaderProgram, GL_UNIFORM, i, 1, &locationProperty, 1, nullptr, &location);
+		if (location < 0) {
+			continue;
+		}
+		glGetProgramResourceName(mShaderProgram, GL_UNIFORM, i, static_cast<GLsizei>(name.size()), nullptr, name.data());
+		std::string uniformName = name.data();
+		mUniformLocations[uniformName] = location;
+
+		// Arrays are reported as "name[0]", make them available by their plain name too
+		size_t bracketPos = uniformName.find("[0]");
+		if (bracketPos != std::string::npos) {
+			mUniformLocations[uniformName.substr(0, bracketPos)] = location;
+		}
+	}
 
+	auto cacheBlocks = [&](GLenum programInterface, std::unordered_map<std::string, GLuint>& blockIndices) {
+		GLint blockCount = 0;
+		glGetProgramInterfaceiv(mShaderProgram, programInterface, GL_ACTIVE_RESOURCES, &blockCount);
+		GLint maxBlockNameLength = 0;
+		glGetProgramInterfaceiv(mShaderProgram, programInterface, GL_MAX_NAME_LENGTH, &maxBlockNameLength);
+		std::vector<char> blockName(std::max(maxBlockNameLength, 1));
+		for (GLint i = 0; i < blockCount; ++i) {
+			glGetProgramResourceName(mShaderProgram, programInterface, i, static_cast<GLsizei>(blockName.size()), nullptr, blockName.data());
+			blockIndices[blockName.data()] = static_cast<GLuint>(i);
+		}
+	};
+	cacheBlocks(GL_UNIFORM_BLOCK, mUniformBlockIndices);
+	cacheBlocks(GL_SHADER_STORAGE_BLOCK, mStorageBlockIndices);
 
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	
-	Logger::log(1, " %s : Loaded Shaders Successfully.\n", __FUNCTION__);
+	Logger::log(2, "%s: %i uniforms, %i uniform blocks, %i storage blocks\n", __FUNCTION__,
+		static_cast<int>(mUniformLocations.size()), static_cast<int>(mUniformBlockIndices.size()),
+		static_cast<int>(mStorageBlockIndices.size()));
+}
 
+void Shader::bindUniformBlocks() {
 
-	return true;
+	// The shaders set the binding points too, this keeps older shaders without explicit bindings working
+	auto frameBlock = mUniformBlockIndices.find("FrameConstants");
+	if (frameBlock != mUniformBlockIndices.end()) {
+		glUniformBlockBinding(mShaderProgram, frameBlock->second, ConstantBlocks::frameBinding);
+	}
 
+	auto drawBlock = mUniformBlockIndices.find("DrawConstants");
+	if (drawBlock != mUniformBlockIndices.end()) {
+		glUniformBlockBinding(mShaderProgram, drawBlock->second, ConstantBlocks::drawBinding);
+	}
 }
 
 void Shader::cleanup() {
 	glDeleteProgram(mShaderProgram);
+
+	// the name may be reused by the next program
+	OGLStateCache::invalidate();
 }
 
-GLuint Shader::readShader(std::string shaderFileName, GLuint shaderType) {
+bool Shader::readShaderFile(std::string shaderFileName, std::string& shaderAsText) {
 
 	Logger::log(1, "%s : Reading shader file %s ... \n", __FUNCTION__, shaderFileName.c_str());
 
-	GLuint shader;
-	std::string shaderAsText;
 	std::ifstream inFile(shaderFileName);
 	if (inFile.is_open()) {
 		
@@ -86,20 +249,27 @@ GLuint Shader::readShader(std::string shaderFileName, GLuint shaderType) {
 	else {
 		Logger::log(0, " %s : Error - Failed to open File %s.\n", __FUNCTION__,shaderFileName.c_str());
 		Logger::log(1, "%s error: system says '%s'\n", __FUNCTION__, strerror(errno));
-		return 0;
+		return false;
 	}
 
 	if (inFile.bad() || inFile.fail()) {
 		inFile.close();
 		Logger::log(0, " %s : Error - Read failed or bad state for File %s.\n", __FUNCTION__, shaderFileName.c_str());
-		return 0;
+		return false;
 	}
 	inFile.close();
 
+	Logger::log(1, " %s : Read Shader %s successfully.\n", __FUNCTION__, shaderFileName.c_str());
+
+	return true;
+}
+
+GLuint Shader::compileShader(const std::string& shaderAsText, GLuint shaderType) {
+
 	const char* shaderSource = shaderAsText.c_str();
 
 	// Create memory for shader type
-	shader = glCreateShader(shaderType);
+	GLuint shader = glCreateShader(shaderType);
 
 	// Load shader code into shader
 	glShaderSource(shader, 1, (const GLchar**)&shaderSource, 0);
@@ -115,39 +285,177 @@ GLuint Shader::readShader(std::string shaderFileName, GLuint shaderType) {
 	if (!isShaderCompiled) {
 
 		Logger::log(0, " %s : Error - Could not compile shader.\n", __FUNCTION__);
+		glDeleteShader(shader);
 		return 0;
 	}
 
-	Logger::log(1, " %s : Read Shader %s successfully.\n", __FUNCTION__, shaderFileName.c_str());
-
 	return shader;
 }
 
+uint64_t Shader::getCacheKey(const std::string& vertexShaderText, const std::string& fragmentShaderText) {
+
+	// A driver update may change the binary format, so vendor, renderer and version are part of the key
+	uint64_t cacheKey = 14695981039346656037ull;
+	cacheKey = hashString(cacheKey, vertexShaderText);
+	cacheKey = hashString(cacheKey, fragmentShaderText);
+	cacheKey = hashString(cacheKey, getGLString(GL_VENDOR));
+	cacheKey = hashString(cacheKey, getGLString(GL_RENDERER));
+	cacheKey = hashString(cacheKey, getGLString(GL_VERSION));
+	return cacheKey;
+}
+
+std::string Shader::getCacheFileName(uint64_t cacheKey) {
+
+	char keyString[17];
+	std::snprintf(keyString, sizeof(keyString), "%016llx", static_cast<unsigned long long>(cacheKey));
+	return mCacheDirectory + "/" + keyString + ".bin";
+}
+
+bool Shader::loadProgramBinary(uint64_t cacheKey) {
+
+	std::string cacheFileName = getCacheFileName(cacheKey);
+	std::ifstream inFile(cacheFileName, std::ios::binary);
+	if (!inFile.is_open()) {
+		// Not cached yet
+		return false;
+	}
+
+	ProgramBinaryHeader header{};
+	inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!inFile || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+		header.version != cacheVersion || header.key != cacheKey || header.binaryLength == 0) {
+		Logger::log(1, "%s: cache file %s is invalid, compiling from source\n", __FUNCTION__, cacheFileName.c_str());
+		return false;
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	inFile.read(binary.data(), binary.size());
+	if (!inFile) {
+		Logger::log(1, "%s: cache file %s is truncated, compiling from source\n", __FUNCTION__, cacheFileName.c_str());
+		return false;
+	}
+
+	mShaderProgram = glCreateProgram();
+	glProgramBinary(mShaderProgram, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+	// The driver may reject binaries of an older version even if the strings did not change
+	GLint isProgramLinked = 0;
+	glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &isProgramLinked);
+	if (!isProgramLinked) {
+		Logger::log(1, "%s: driver rejected cached program %s, compiling from source\n", __FUNCTION__, cacheFileName.c_str());
+		glDeleteProgram(mShaderProgram);
+		mShaderProgram = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void Shader::saveProgramBinary(uint64_t cacheKey) {
+
+	GLint binaryLength = 0;
+	glGetProgramiv(mShaderProgram, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0) {
+		Logger::log(1, "%s: driver returned no program binary, shader is not cached\n", __FUNCTION__);
+		return;
+	}
+
+	std::vector<char> binary(binaryLength);
+	GLsizei writtenLength = 0;
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(mShaderProgram, binaryLength, &writtenLength, &binaryFormat, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(mCacheDirectory, error);
+
+	std::string cacheFileName = getCacheFileName(cacheKey);
+	std::ofstream outFile(cacheFileName, std::ios::binary | std::ios::trunc);
+	if (!outFile.is_open()) {
+		Logger::log(1, "%s error: could not write cache file %s\n", __FUNCTION__, cacheFileName.c_str());
+		return;
+	}
+
+	ProgramBinaryHeader header{};
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.key = cacheKey;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = writtenLength;
+
+	outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	outFile.write(binary.data(), writtenLength);
+	if (!outFile) {
+		Logger::log(1, "%s error: writing cache file %s failed\n", __FUNCTION__, cacheFileName.c_str());
+		outFile.close();
+		std::filesystem::remove(cacheFileName, error);
+		return;
+	}
+
+	Logger::log(1, "%s: program binary (%i bytes) saved to %s\n", __FUNCTION__, writtenLength, cacheFileName.c_str());
+}
+
+void Shader::setCacheDirectory(std::string directory) {
+	mCacheDirectory = directory;
+}
+
+int Shader::getCacheHits() {
+	return mCacheHits;
+}
+
+int Shader::getCacheMisses() {
+	return mCacheMisses;
+}
+
+float Shader::getLoadTime() {
+	return mLoadTime;
+}
+
 void Shader::use() {
 
 	Logger::log(2, " %s : Using Shader.\n", __FUNCTION__);
 
-	glUseProgram(mShaderProgram);
+	OGLStateCache::useProgram(mShaderProgram);
+}
+
+GLint Shader::getUniformLocation(const std::string& uniformName) const
+{
+	auto location = mUniformLocations.find(uniformName);
+	return location != mUniformLocations.end() ? location->second : -1;
+}
+
+bool Shader::hasUniformBlock(const std::string& blockName) const
+{
+	return mUniformBlockIndices.count(blockName) > 0;
+}
+
+bool Shader::hasStorageBlock(const std::string& blockName) const
+{
+	return mStorageBlockIndices.count(blockName) > 0;
 }
 
-bool Shader::getUniformLocation(std::string uniformName) 
+void Shader::setUniformValue(const std::string& uniformName, int value)
 {
-	if (mShaderProgram > 0)
+	GLint location = getUniformLocation(uniformName);
+	if (location > -1)
 	{
-		mUniformLocation = glGetUniformLocation(mShaderProgram, uniformName.c_str());
-		return mUniformLocation > -1;
+		glProgramUniform1i(mShaderProgram, location, value);
 	}
-	return false;
 }
 
-void Shader::setUniformValue(int value)
+void Shader::setUniformValue(const std::string& uniformName, float value)
 {
-	if (mShaderProgram > 0) 
+	GLint location = getUniformLocation(uniformName);
+	if (location > -1)
 	{
-		if (mUniformLocation > -1)
-		{
-			glUniform1i(mUniformLocation, value);
-		}
+		glProgramUniform1f(mShaderProgram, location, value);
 	}
 }
 
+void Shader::setUniformValue(const std::string& uniformName, const glm::mat4& value)
+{
+	GLint location = getUniformLocation(uniformName);
+	if (location > -1)
+	{
+		glProgramUniformMatrix4fv(mShaderProgram, location, 1, GL_FALSE, &value[0][0]);
+	}
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <string>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -7,23 +11,56 @@ class Shader {
 public:
 
 	// Load shaders from files and generate OpenGL shaders
+	// The linked program is stored in the binary cache and reused on the next start if sources and driver match
 	bool loadShaders(std::string vertexShaderFileName, std::string fragmentShaderFileName);
 
 	// Instructs graphic card to use the shader for draw operation
 	void use();
 
-	bool getUniformLocation(std::string uniformName);
-	void setUniformValue(int value);
+	// Uniform locations and block indices are read once after linking, the lookups do not call into GL
+	// @return - Location of the uniform, -1 if the program has no such active uniform
+	GLint getUniformLocation(const std::string& uniformName) const;
+	bool hasUniformBlock(const std::string& blockName) const;
+	bool hasStorageBlock(const std::string& blockName) const;
+
+	// Sets a uniform of this program, it does not have to be in use
+	void setUniformValue(const std::string& uniformName, int value);
+	void setUniformValue(const std::string& uniformName, float value);
+	void setUniformValue(const std::string& uniformName, const glm::mat4& value);
 
 
 	// Free created OpenGL shader 
 	void cleanup();
 
+	// Folder for the program binaries, an empty name disables the cache
+	static void setCacheDirectory(std::string directory);
+	// Statistics of all shaders loaded so far
+	static int getCacheHits();
+	static int getCacheMisses();
+	static float getLoadTime();
+
 private:
 
 	GLuint mShaderProgram = 0;
-	GLint mUniformLocation = -1;
+	std::unordered_map<std::string, GLint> mUniformLocations{};
+	std::unordered_map<std::string, GLuint> mUniformBlockIndices{};
+	std::unordered_map<std::string, GLuint> mStorageBlockIndices{};
+
+	static std::string mCacheDirectory;
+	static int mCacheHits;
+	static int mCacheMisses;
+	static float mLoadTime;
+
+	bool readShaderFile(std::string shaderFileName, std::string& shaderAsText);
+	GLuint compileShader(const std::string& shaderAsText, GLuint shaderType);
+	bool linkProgram(GLuint vertexShader, GLuint fragmentShader, bool retrievable);
+	void cacheLocations();
+	void bindUniformBlocks();
 
-	GLuint readShader(std::string shaderFileNme, GLuint shaderType);
+	// Program binary cache, keyed by a hash of both sources and the driver strings
+	uint64_t getCacheKey(const std::string& vertexShaderText, const std::string& fragmentShaderText);
+	std::string getCacheFileName(uint64_t cacheKey);
+	bool loadProgramBinary(uint64_t cacheKey);
+	void saveProgramBinary(uint64_t cacheKey);
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,244 @@
+#include <array>
+#include "OGLStateCache.h"
+
+namespace {
+	// Nothing known about the binding, the next call is always sent
+	const GLuint unknownBinding = 0xffffffff;
+
+	const int maxTextureUnits = 16;
+	const int maxBindingPoints = 16;
+	// size of a binding that covers the whole buffer
+	const GLsizeiptr wholeBuffer = -1;
+
+	struct IndexedBinding {
+		GLuint buffer = unknownBinding;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+	};
+
+	GLuint currentProgram = unknownBinding;
+	GLuint currentVertexArray = unknownBinding;
+	GLuint currentDrawFramebuffer = unknownBinding;
+	GLuint currentReadFramebuffer = unknownBinding;
+	GLuint currentActiveUnit = unknownBinding;
+
+	// array, uniform, shader storage, texture buffer
+	std::array<GLuint, 4> currentBuffers{};
+	std::array<IndexedBinding, maxBindingPoints> currentUniformBindings{};
+	std::array<IndexedBinding, maxBindingPoints> currentStorageBindings{};
+	// 2D and buffer textures per unit
+	std::array<std::array<GLuint, 2>, maxTextureUnits> currentTextures{};
+	// depth test, face culling, blending: -1 unknown, 0 off, 1 on
+	std::array<int, 3> currentCapabilities = { -1, -1, -1 };
+
+	OGLFrameCounters counters{};
+
+	bool initialized = false;
+
+	int getBufferSlot(GLenum target) {
+		switch (target) {
+		case GL_ARRAY_BUFFER:
+			return 0;
+		case GL_UNIFORM_BUFFER:
+			return 1;
+		case GL_SHADER_STORAGE_BUFFER:
+			return 2;
+		case GL_TEXTURE_BUFFER:
+			return 3;
+		default:
+			return -1;
+		}
+	}
+
+	int getTextureSlot(GLenum target) {
+		switch (target) {
+		case GL_TEXTURE_2D:
+			return 0;
+		case GL_TEXTURE_BUFFER:
+			return 1;
+		default:
+			return -1;
+		}
+	}
+
+	int getCapabilitySlot(GLenum capability) {
+		switch (capability) {
+		case GL_DEPTH_TEST:
+			return 0;
+		case GL_CULL_FACE:
+			return 1;
+		case GL_BLEND:
+			return 2;
+		default:
+			return -1;
+		}
+	}
+
+	void checkInitialized() {
+		if (!initialized) {
+			OGLStateCache::invalidate();
+		}
+	}
+
+	bool skipBind(bool redundant) {
+		if (redundant) {
+			++counters.skippedBinds;
+			return true;
+		}
+		++counters.binds;
+		return false;
+	}
+}
+
+void OGLStateCache::useProgram(GLuint program) {
+	checkInitialized();
+	if (skipBind(currentProgram == program)) {
+		return;
+	}
+	glUseProgram(program);
+	currentProgram = program;
+}
+
+void OGLStateCache::bindVertexArray(GLuint vertexArray) {
+	checkInitialized();
+	if (skipBind(currentVertexArray == vertexArray)) {
+		return;
+	}
+	glBindVertexArray(vertexArray);
+	currentVertexArray = vertexArray;
+}
+
+void OGLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+	checkInitialized();
+	int slot = getBufferSlot(target);
+	if (skipBind(slot >= 0 && currentBuffers.at(slot) == buffer)) {
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (slot >= 0) {
+		currentBuffers.at(slot) = buffer;
+	}
+}
+
+void OGLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	bindBufferRange(target, index, buffer, 0, wholeBuffer);
+}
+
+void OGLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	checkInitialized();
+	IndexedBinding* binding = nullptr;
+	if (index < maxBindingPoints) {
+		if (target == GL_UNIFORM_BUFFER) {
+			binding = &currentUniformBindings.at(index);
+		}
+		else if (target == GL_SHADER_STORAGE_BUFFER) {
+			binding = &currentStorageBindings.at(index);
+		}
+	}
+
+	if (skipBind(binding && binding->buffer == buffer && binding->offset == offset && binding->size == size)) {
+		return;
+	}
+	if (size == wholeBuffer) {
+		glBindBufferBase(target, index, buffer);
+	}
+	else {
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+	if (binding) {
+		*binding = { buffer, offset, size };
+	}
+
+	// the indexed bind also changes the generic binding of the target
+	int slot = getBufferSlot(target);
+	if (slot >= 0) {
+		currentBuffers.at(slot) = buffer;
+	}
+}
+
+void OGLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+	checkInitialized();
+	int slot = getTextureSlot(target);
+	bool cached = slot >= 0 && unit < maxTextureUnits;
+	if (skipBind(cached && currentTextures.at(unit).at(slot) == texture)) {
+		return;
+	}
+
+	if (currentActiveUnit != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		currentActiveUnit = unit;
+	}
+	glBindTexture(target, texture);
+	if (cached) {
+		currentTextures.at(unit).at(slot) = texture;
+	}
+}
+
+void OGLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer) {
+	checkInitialized();
+	bool bindDraw = (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER);
+	bool bindRead = (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER);
+	if (skipBind((!bindDraw || currentDrawFramebuffer == framebuffer) &&
+		(!bindRead || currentReadFramebuffer == framebuffer))) {
+		return;
+	}
+
+	glBindFramebuffer(target, framebuffer);
+	if (bindDraw) {
+		currentDrawFramebuffer = framebuffer;
+	}
+	if (bindRead) {
+		currentReadFramebuffer = framebuffer;
+	}
+}
+
+void OGLStateCache::setCapability(GLenum capability, bool enabled) {
+	checkInitialized();
+	int slot = getCapabilitySlot(capability);
+	if (skipBind(slot >= 0 && currentCapabilities.at(slot) == static_cast<int>(enabled))) {
+		return;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	}
+	else {
+		glDisable(capability);
+	}
+	if (slot >= 0) {
+		currentCapabilities.at(slot) = static_cast<int>(enabled);
+	}
+}
+
+void OGLStateCache::countDrawCall() {
+	++counters.drawCalls;
+}
+
+void OGLStateCache::countUpload(size_t bytes) {
+	++counters.bufferUploads;
+	counters.uploadBytes += bytes;
+}
+
+void OGLStateCache::invalidate() {
+	currentProgram = unknownBinding;
+	currentVertexArray = unknownBinding;
+	currentDrawFramebuffer = unknownBinding;
+	currentReadFramebuffer = unknownBinding;
+	currentActiveUnit = unknownBinding;
+	currentBuffers.fill(unknownBinding);
+	currentUniformBindings.fill(IndexedBinding{});
+	currentStorageBindings.fill(IndexedBinding{});
+	for (auto& unit : currentTextures) {
+		unit.fill(unknownBinding);
+	}
+	currentCapabilities.fill(-1);
+	initialized = true;
+}
+
+OGLFrameCounters OGLStateCache::getCounters() {
+	return counters;
+}
+
+void OGLStateCache::resetCounters() {
+	counters = OGLFrameCounters{};
+}
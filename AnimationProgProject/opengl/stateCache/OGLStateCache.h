@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <glad/glad.h>
+
+// GL calls issued in one frame, counted by the state cache
+struct OGLFrameCounters {
+	unsigned int drawCalls = 0;
+	unsigned int binds = 0;
+	unsigned int skippedBinds = 0;
+	unsigned int bufferUploads = 0;
+	size_t uploadBytes = 0;
+};
+
+// Shadow copy of the bound GL objects, binds of objects that are already bound are skipped.
+// Every bind in the renderer goes through here. Code that changes the bindings directly (ImGui) or
+// deletes bound objects has to call invalidate() afterwards.
+class OGLStateCache {
+public:
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vertexArray);
+	// The element buffer belongs to the bound VAO, it is passed through and not cached
+	static void bindBuffer(GLenum target, GLuint buffer);
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+	static void bindFramebuffer(GLenum target, GLuint framebuffer);
+	static void setCapability(GLenum capability, bool enabled);
+
+	static void countDrawCall();
+	static void countUpload(size_t bytes);
+
+	// Forget all cached bindings, the next bind of every object is sent to the driver
+	static void invalidate();
+
+	static OGLFrameCounters getCounters();
+	static void resetCounters();
+};
@@ -1,80 +1,457 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <stb_image.h>
 #include "Texture.h"
+#include "TextureCompressor.h"
 #include "../Logger/Logger.h"
+#include "../timer/Timer.h"
+#include <stateCache/OGLStateCache.h>
+#include <ThreadPool.h>
+
+bool Texture::mCompressedCache = true;
+
+namespace {
+	const char cacheMagic[4] = { 'A', 'P', 'T', 'X' };
+	const uint32_t cacheVersion = 1;
+
+	// Stored in front of the levels, size and time of the image file detect a changed source
+	struct TextureCacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint32_t format;
+		uint32_t flipped;
+		int32_t width;
+		int32_t height;
+		uint32_t levelCount;
+		uint32_t padding;
+		uint64_t dataSize;
+	};
+
+	struct TextureCacheLevel {
+		int32_t width;
+		int32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	void forEachIndex(ThreadPool* threadPool, size_t count, const std::function<void(size_t)>& function) {
+		if (threadPool) {
+			threadPool->parallelFor(count, function);
+			return;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			function(i);
+		}
+	}
+
+	bool getSourceStamp(const std::string& textureFileName, uint64_t& sourceSize, int64_t& sourceTime) {
+		std::error_code error;
+		sourceSize = std::filesystem::file_size(textureFileName, error);
+		if (error) {
+			return false;
+		}
+		sourceTime = std::filesystem::last_write_time(textureFileName, error).time_since_epoch().count();
+		return !error;
+	}
+}
 
 bool Texture::loadTexture(std::string textureName,bool flipImage) {
 
 	Logger::log(1, "%s: Started loading texture...\n", __FUNCTION__);
 
+	TextureData textureData{};
+	if (!prepareTexture(textureName, textureData, flipImage)) {
+		Logger::log(0, "%s: Error - Something went wrong while loading the texture.\n", __FUNCTION__);
+		return false;
+	}
+
+	createTexture(textureData);
+
+	Logger::log(1, "%s: Loaded texture successfully. \n", __FUNCTION__);
+
+	return true;
+}
 
-	int texWidth, texHeight, numOfChannels;
+bool Texture::loadTexture(const unsigned char* pixels, int width, int height) {
 
-	// Flips the image on the vertical axis (picture has origin at top-left while texture has it at bottom-left)
-	stbi_set_flip_vertically_on_load(flipImage);
+	if (!pixels || width <= 0 || height <= 0) {
+		Logger::log(0, "%s: Error - No texture data.\n", __FUNCTION__);
+		return false;
+	}
 
-	// Creates memory area, read the file and fill the output params
-	unsigned char* textureData = stbi_load(textureName.c_str(), &texWidth, &texHeight, &numOfChannels, 0);
+	TextureData textureData{};
+	setPixels(textureData, pixels, width, height);
+	createTexture(textureData);
 
-	// If the texture wasn't able to load for some reason then free the allocated memory area or else memory leak
-	if (!textureData) {
+	Logger::log(1, "%s: Created %ix%i texture from memory. \n", __FUNCTION__, width, height);
+	return true;
+}
 
-		Logger::log(0, "%s: Error - Something went wrong while loading the texture.\n", __FUNCTION__);
-		stbi_image_free(textureData);
+bool Texture::prepareTexture(std::string textureFileName, TextureData& textureData, bool flipImage, ThreadPool* threadPool) {
+
+	Timer loadTimer{};
+	loadTimer.start();
+
+	textureData = TextureData{};
+	textureData.name = textureFileName;
+
+	if (mCompressedCache && loadCache(textureFileName, textureData, flipImage)) {
+		textureData.fromCache = true;
+		textureData.loadTime = loadTimer.stop();
+		Logger::log(1, "%s: '%s' read from the compressed cache in %.2f ms\n", __FUNCTION__, textureFileName.c_str(),
+			textureData.loadTime);
+		return true;
+	}
+
+	// Always 4 channels, RGB images would be read as RGBA otherwise
+	int width, height, numOfChannels;
+	unsigned char* decodedData = stbi_load(textureFileName.c_str(), &width, &height, &numOfChannels, 4);
+	if (!decodedData) {
+		Logger::log(0, "%s: Error - Could not decode texture '%s'.\n", __FUNCTION__, textureFileName.c_str());
+		return false;
+	}
+
+	// The flip setting of stb_image is global, the rows are flipped here to allow decoding on several threads
+	size_t rowSize = static_cast<size_t>(width) * 4;
+	textureData.width = width;
+	textureData.height = height;
+	textureData.pixelStorage.resize(rowSize * height);
+	for (int row = 0; row < height; ++row) {
+		int sourceRow = flipImage ? height - 1 - row : row;
+		std::memcpy(textureData.pixelStorage.data() + row * rowSize, decodedData + sourceRow * rowSize, rowSize);
+	}
+	stbi_image_free(decodedData);
+
+	textureData.levels.push_back({ width, height, 0, rowSize * height });
+	buildMipLevels(textureData, threadPool);
+
+	if (mCompressedCache) {
+		compressLevels(textureData, threadPool);
+		saveCache(textureFileName, textureData, flipImage);
+	}
+
+	textureData.pixels = textureData.pixelStorage.data();
+	textureData.size = textureData.pixelStorage.size();
+	textureData.loadTime = loadTimer.stop();
+	Logger::log(1, "%s: '%s' decoded in %.2f ms, %i levels, %i bytes\n", __FUNCTION__, textureFileName.c_str(),
+		textureData.loadTime, textureData.levels.size(), textureData.size);
+	return true;
+}
+
+void Texture::setPixels(TextureData& textureData, const unsigned char* pixels, int width, int height) {
+
+	textureData.width = width;
+	textureData.height = height;
+	textureData.format = GL_RGBA8;
+	textureData.pixels = pixels;
+	textureData.size = static_cast<size_t>(width) * height * 4;
+	textureData.levels = { { width, height, 0, textureData.size } };
+}
+
+void Texture::setCompressedCache(bool enabled) {
+	mCompressedCache = enabled;
+}
+
+void Texture::buildMipLevels(TextureData& textureData, ThreadPool* threadPool) {
+
+	// Level sizes halve until 1x1, all levels back to back
+	size_t totalSize = textureData.levels.at(0).size;
+	int width = textureData.width;
+	int height = textureData.height;
+	while (width > 1 || height > 1) {
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		size_t levelSize = static_cast<size_t>(width) * height * 4;
+		textureData.levels.push_back({ width, height, totalSize, levelSize });
+		totalSize += levelSize;
+	}
+	textureData.pixelStorage.resize(totalSize);
+
+	// 2x2 box filter, odd sizes repeat the last row or column, the rows of a level are filtered in parallel
+	for (size_t level = 1; level < textureData.levels.size(); ++level) {
+		const TextureLevel& source = textureData.levels.at(level - 1);
+		const TextureLevel& target = textureData.levels.at(level);
+		const unsigned char* sourcePixels = textureData.pixelStorage.data() + source.offset;
+		unsigned char* targetPixels = textureData.pixelStorage.data() + target.offset;
+
+		forEachIndex(threadPool, target.height, [&](size_t y) {
+			int y0 = std::min(static_cast<int>(y) * 2, source.height - 1);
+			int y1 = std::min(static_cast<int>(y) * 2 + 1, source.height - 1);
+			for (int x = 0; x < target.width; ++x) {
+				int x0 = std::min(x * 2, source.width - 1);
+				int x1 = std::min(x * 2 + 1, source.width - 1);
+				for (int c = 0; c < 4; ++c) {
+					int sum = sourcePixels[(static_cast<size_t>(y0) * source.width + x0) * 4 + c] +
+						sourcePixels[(static_cast<size_t>(y0) * source.width + x1) * 4 + c] +
+						sourcePixels[(static_cast<size_t>(y1) * source.width + x0) * 4 + c] +
+						sourcePixels[(static_cast<size_t>(y1) * source.width + x1) * 4 + c];
+					targetPixels[(y * target.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		});
+	}
+}
+
+void Texture::compressLevels(TextureData& textureData, ThreadPool* threadPool) {
+
+	std::vector<TextureLevel> compressedLevels{};
+	size_t totalSize = 0;
+	for (const auto& level : textureData.levels) {
+		size_t levelSize = TextureCompressor::getCompressedSize(level.width, level.height);
+		compressedLevels.push_back({ level.width, level.height, totalSize, levelSize });
+		totalSize += levelSize;
+	}
+
+	// One job per row of 4x4 blocks, the rows of all levels in one go
+	std::vector<std::pair<size_t, int>> blockRows{};
+	for (size_t level = 0; level < textureData.levels.size(); ++level) {
+		for (int row = 0; row < (textureData.levels.at(level).height + 3) / 4; ++row) {
+			blockRows.emplace_back(level, row);
+		}
+	}
+
+	std::vector<unsigned char> compressedData(totalSize);
+	forEachIndex(threadPool, blockRows.size(), [&](size_t i) {
+		const TextureLevel& source = textureData.levels.at(blockRows.at(i).first);
+		const TextureLevel& target = compressedLevels.at(blockRows.at(i).first);
+		int row = blockRows.at(i).second;
+		TextureCompressor::compressBlockRow(textureData.pixelStorage.data() + source.offset, source.width, source.height,
+			row, compressedData.data() + target.offset + row * TextureCompressor::getCompressedSize(source.width, 4));
+	});
+
+	textureData.format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+	textureData.levels = compressedLevels;
+	textureData.pixelStorage = std::move(compressedData);
+}
+
+std::string Texture::getCacheFileName(const std::string& textureFileName) {
+	return textureFileName + ".aptex";
+}
+
+bool Texture::loadCache(const std::string& textureFileName, TextureData& textureData, bool flipImage) {
+
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if (!getSourceStamp(textureFileName, sourceSize, sourceTime)) {
+		return false;
+	}
+
+	std::string cacheFileName = getCacheFileName(textureFileName);
+	std::ifstream inFile(cacheFileName, std::ios::binary);
+	if (!inFile.is_open()) {
+		// Not cached yet
+		return false;
+	}
+
+	TextureCacheHeader header{};
+	inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!inFile || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion ||
+		header.sourceSize != sourceSize || header.sourceTime != sourceTime || header.flipped != (flipImage ? 1u : 0u) ||
+		header.levelCount == 0) {
+		Logger::log(1, "%s: cache file %s is outdated, decoding the image\n", __FUNCTION__, cacheFileName.c_str());
 		return false;
 	}
 
+	std::vector<TextureCacheLevel> levels(header.levelCount);
+	inFile.read(reinterpret_cast<char*>(levels.data()), levels.size() * sizeof(TextureCacheLevel));
+	textureData.pixelStorage.resize(header.dataSize);
+	inFile.read(reinterpret_cast<char*>(textureData.pixelStorage.data()), header.dataSize);
+	if (!inFile) {
+		Logger::log(1, "%s: cache file %s is truncated, decoding the image\n", __FUNCTION__, cacheFileName.c_str());
+		return false;
+	}
+
+	textureData.levels.clear();
+	for (const auto& level : levels) {
+		if (level.offset + level.size > header.dataSize) {
+			Logger::log(1, "%s: cache file %s is invalid, decoding the image\n", __FUNCTION__, cacheFileName.c_str());
+			return false;
+		}
+		textureData.levels.push_back({ level.width, level.height, level.offset, level.size });
+	}
+
+	textureData.width = header.width;
+	textureData.height = header.height;
+	textureData.format = header.format;
+	textureData.pixels = textureData.pixelStorage.data();
+	textureData.size = textureData.pixelStorage.size();
+	return true;
+}
+
+void Texture::saveCache(const std::string& textureFileName, const TextureData& textureData, bool flipImage) {
+
+	TextureCacheHeader header{};
+	if (!getSourceStamp(textureFileName, header.sourceSize, header.sourceTime)) {
+		return;
+	}
+
+	std::string cacheFileName = getCacheFileName(textureFileName);
+	std::ofstream outFile(cacheFileName, std::ios::binary | std::ios::trunc);
+	if (!outFile.is_open()) {
+		Logger::log(1, "%s error: could not write cache file %s\n", __FUNCTION__, cacheFileName.c_str());
+		return;
+	}
+
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = cacheVersion;
+	header.format = textureData.format;
+	header.flipped = flipImage ? 1 : 0;
+	header.width = textureData.width;
+	header.height = textureData.height;
+	header.levelCount = textureData.levels.size();
+	header.dataSize = textureData.pixelStorage.size();
+
+	std::vector<TextureCacheLevel> levels{};
+	for (const auto& level : textureData.levels) {
+		levels.push_back({ level.width, level.height, level.offset, level.size });
+	}
+
+	outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	outFile.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(TextureCacheLevel));
+	outFile.write(reinterpret_cast<const char*>(textureData.pixelStorage.data()), textureData.pixelStorage.size());
+	if (!outFile) {
+		Logger::log(1, "%s error: writing cache file %s failed\n", __FUNCTION__, cacheFileName.c_str());
+		outFile.close();
+		std::error_code error;
+		std::filesystem::remove(cacheFileName, error);
+		return;
+	}
+
+	Logger::log(1, "%s: compressed texture (%i bytes) saved to %s\n", __FUNCTION__, header.dataSize, cacheFileName.c_str());
+}
+
+void Texture::createTexture(const TextureData& textureData) {
+
+	createStorage(textureData);
+	for (size_t offset = 0; offset < textureData.size; ) {
+		offset += uploadData(textureData, offset, textureData.size - offset);
+	}
+	finishUpload(textureData);
+}
+
+void Texture::createStorage(const TextureData& textureData) {
+
+	// Without prepared levels the full chain is allocated and generated on the GPU
+	int levelCount = static_cast<int>(textureData.levels.size());
+	mGpuBytes = 0;
+	if (levelCount > 1 || textureData.format != GL_RGBA8) {
+		for (const auto& level : textureData.levels) {
+			mGpuBytes += level.size;
+		}
+	}
+	else {
+		int width = textureData.width;
+		int height = textureData.height;
+		levelCount = 1;
+		mGpuBytes = static_cast<size_t>(width) * height * 4;
+		while (width > 1 || height > 1) {
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			mGpuBytes += static_cast<size_t>(width) * height * 4;
+			++levelCount;
+		}
+	}
+
 	glGenTextures(1, &mTex);
-	glBindTexture(GL_TEXTURE_2D, mTex);
-/*
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, mTex);
+
 	// For minification we use tri-linear sampling
-	glTextureParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
 	// For magnification we use linear filtering since thats all that iis available 
-	glTextureParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	// Repeat textures outside the range 0 to 1 
-	glTextureParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTextureParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	*/
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// All levels without data, the pixels follow with uploadData
+	glTexStorage2D(GL_TEXTURE_2D, levelCount, textureData.format, textureData.width, textureData.height);
+
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+size_t Texture::uploadData(const TextureData& textureData, size_t offset, size_t maxBytes) {
+
+	size_t levelNum = 0;
+	while (levelNum + 1 < textureData.levels.size() &&
+		offset >= textureData.levels.at(levelNum).offset + textureData.levels.at(levelNum).size) {
+		++levelNum;
+	}
+	const TextureLevel& level = textureData.levels.at(levelNum);
+
+	// Rows of 4x4 blocks for compressed data
+	bool compressed = textureData.format != GL_RGBA8;
+	int rowHeight = compressed ? 4 : 1;
+	size_t rowSize = compressed ? TextureCompressor::getCompressedSize(level.width, 4) : static_cast<size_t>(level.width) * 4;
+	int levelRows = (level.height + rowHeight - 1) / rowHeight;
+
+	int firstRow = static_cast<int>((offset - level.offset) / rowSize);
+	int rowCount = std::clamp(static_cast<int>(maxBytes / rowSize), 1, levelRows - firstRow);
+	int yOffset = firstRow * rowHeight;
+	int height = std::min(rowCount * rowHeight, level.height - yOffset);
+	size_t uploadSize = rowCount * rowSize;
+
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, mTex);
 	// Uses the byte data of the load function and pushes the data to the gpu from the memory 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
+	if (compressed) {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, levelNum, 0, yOffset, level.width, height, textureData.format,
+			static_cast<GLsizei>(uploadSize), textureData.pixels + offset);
+	}
+	else {
+		glTexSubImage2D(GL_TEXTURE_2D, levelNum, 0, yOffset, level.width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+			textureData.pixels + offset);
+	}
+	OGLStateCache::countUpload(uploadSize);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
+	return uploadSize;
+}
 
+void Texture::finishUpload(const TextureData& textureData) {
+
+	if (textureData.levels.size() > 1 || textureData.format != GL_RGBA8) {
+		return;
+	}
+
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, mTex);
 	// Generate mipmaps (scaled down versions of original image, halving the width and height for every step until a configurable limit is reached)
 	// increases rendering speed, as less data is read if texture is far away and reduces artifacts
 	glGenerateMipmap(GL_TEXTURE_2D);
 
 	// Unbind texture
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Free memory allocated by STB load
-	stbi_image_free(textureData);
-
-	Logger::log(1, "%s: Loaded texture successfully. \n", __FUNCTION__);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
+}
 
-	return true;
+size_t Texture::getGpuBytes() {
+	return mGpuBytes;
 }
 
 void Texture::bind() {
 
 	Logger::log(2, "%s: Binding Texture. \n", __FUNCTION__);
 
-	glBindTexture(GL_TEXTURE_2D, mTex);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, mTex);
 }
 void Texture::unbind() {
 	
 	Logger::log(2, "%s: Unbinding Texture. \n", __FUNCTION__);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	OGLStateCache::bindTexture(0, GL_TEXTURE_2D, 0);
 }
 
 void Texture::cleanup() {
 
 	Logger::log(1, "%s: Cleaning up Texture. \n", __FUNCTION__);
 
+	glDeleteTextures(1, &mTex);
 	mTex = 0;
+	mGpuBytes = 0;
+
+	// the name may be reused by the next texture
+	OGLStateCache::invalidate();
 }
\ No newline at end of file
@@ -1,15 +1,87 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+class ThreadPool;
+
+// One mip level inside TextureData::pixels
+struct TextureLevel {
+	int width;
+	int height;
+	size_t offset;
+	size_t size;
+};
+
+// CPU side of a texture with all its mip levels, decoded or read from the compressed cache
+struct TextureData {
+	std::string name;
+	int width = 0;
+	int height = 0;
+
+	// GL_RGBA8, or GL_COMPRESSED_RGBA_BPTC_UNORM from the cache
+	GLenum format = GL_RGBA8;
+	std::vector<TextureLevel> levels{};
+
+	// Points into pixelStorage, or into memory of the caller like a mapped cooked model
+	const unsigned char* pixels = nullptr;
+	std::vector<unsigned char> pixelStorage{};
+	size_t size = 0;
+
+	float loadTime = 0.0f;
+	bool fromCache = false;
+};
+
 class Texture {
 	public:
 
-		// Loads the texture and generates an openGL texture 
+		// Loads the texture and generates an openGL texture
 		// @param Filepath to texture
 		bool loadTexture(std::string textureFileName, bool flipImage = true);
 
+		// Generates the openGL texture from already decoded pixels, e.g. from a cooked model
+		// @param pixels - RGBA8 data, row by row
+		// @param width - Width of the texture
+		// @param height - Height of the texture
+		bool loadTexture(const unsigned char* pixels, int width, int height);
+
+		// Decodes an image file and builds the mip levels, without any GL call, safe to use on worker threads
+		// Uses the compressed cache next to the image file if it is enabled and up to date, writes it otherwise
+		// @param textureFileName - Filepath to texture
+		// @param textureData - Receives the levels
+		// @param flipImage - Flips the rows like loadTexture
+		// @param threadPool - Builds and compresses the levels in parallel if set
+		static bool prepareTexture(std::string textureFileName, TextureData& textureData, bool flipImage = true,
+			ThreadPool* threadPool = nullptr);
+
+		// Single RGBA8 level owned by the caller, the other levels are generated on the GPU
+		// @param textureData - Receives the level
+		// @param pixels - RGBA8 data, row by row
+		// @param width - Width of the texture
+		// @param height - Height of the texture
+		static void setPixels(TextureData& textureData, const unsigned char* pixels, int width, int height);
+
+		// Block compressed cache files (<image>.aptex) next to the images, enabled by default
+		static void setCompressedCache(bool enabled);
+
+		// Texture upload in steps, e.g. a few rows per frame: storage first, then the data, finishUpload at the end
+		// @param textureData - Prepared texture, must stay unchanged until finishUpload
+		void createStorage(const TextureData& textureData);
+
+		// Uploads whole rows (rows of blocks if compressed) of one level, at least one row
+		// @param textureData - Prepared texture
+		// @param offset - Bytes of textureData already uploaded
+		// @param maxBytes - Upload budget
+		// @return Number of bytes uploaded
+		size_t uploadData(const TextureData& textureData, size_t offset, size_t maxBytes);
+
+		// Generates the mip levels on the GPU if the data has none
+		void finishUpload(const TextureData& textureData);
+
+		// GPU memory of all levels
+		size_t getGpuBytes();
+
 
 		// Enables modifications to the texture (For when we want to use multiple textures and avoid any unexpected results)
 		void bind();
@@ -24,6 +96,17 @@ private:
 
 	// Stores the generated openGL that was loaded.
 	GLuint mTex = 0;
+	size_t mGpuBytes = 0;
+
+	static bool mCompressedCache;
+
+	void createTexture(const TextureData& textureData);
+
+	static void buildMipLevels(TextureData& textureData, ThreadPool* threadPool);
+	static void compressLevels(TextureData& textureData, ThreadPool* threadPool);
+	static std::string getCacheFileName(const std::string& textureFileName);
+	static bool loadCache(const std::string& textureFileName, TextureData& textureData, bool flipImage);
+	static void saveCache(const std::string& textureFileName, const TextureData& textureData, bool flipImage);
 
 
-};
\ No newline at end of file
+};
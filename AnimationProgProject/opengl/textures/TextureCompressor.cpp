@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "TextureCompressor.h"
+
+namespace {
+	// interpolation weights of the 4 bit indices, 64 is the second endpoint
+	const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// BC7 fields are stored from the lowest bit of the first byte upwards
+	class BlockWriter {
+		public:
+			explicit BlockWriter(unsigned char* block) : mBlock(block) {
+				std::memset(mBlock, 0, TextureCompressor::blockSize);
+			}
+
+			void write(uint32_t value, int bitCount) {
+				for (int i = 0; i < bitCount; ++i, ++mBitPos) {
+					if (value & (1u << i)) {
+						mBlock[mBitPos / 8] |= static_cast<unsigned char>(1u << (mBitPos % 8));
+					}
+				}
+			}
+
+		private:
+			unsigned char* mBlock;
+			int mBitPos = 0;
+	};
+
+	// 7 bit color plus a p-bit shared by the four channels, the better of both p-bits is used
+	void quantizeEndpoint(const float* color, int* quantized, int& pBit) {
+		float bestError = 0.0f;
+		for (int p = 0; p < 2; ++p) {
+			int candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c) {
+				candidate[c] = std::clamp(static_cast<int>(std::lround((color[c] - p) / 2.0f)), 0, 127);
+				float diff = static_cast<float>(candidate[c] * 2 + p) - color[c];
+				error += diff * diff;
+			}
+			if (p == 0 || error < bestError) {
+				bestError = error;
+				pBit = p;
+				std::copy(candidate, candidate + 4, quantized);
+			}
+		}
+	}
+}
+
+size_t TextureCompressor::getCompressedSize(int width, int height) {
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+void TextureCompressor::compressBlockRow(const unsigned char* pixels, int width, int height, int blockRow,
+	unsigned char* output) {
+
+	unsigned char texels[64];
+	int blocksPerRow = (width + 3) / 4;
+	for (int blockX = 0; blockX < blocksPerRow; ++blockX) {
+		// border blocks repeat the last row and column
+		for (int y = 0; y < 4; ++y) {
+			int sourceY = std::min(blockRow * 4 + y, height - 1);
+			for (int x = 0; x < 4; ++x) {
+				int sourceX = std::min(blockX * 4 + x, width - 1);
+				std::memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+			}
+		}
+		compressBlock(texels, output + blockX * blockSize);
+	}
+}
+
+void TextureCompressor::compressBlock(const unsigned char* texels, unsigned char* block) {
+
+	/* principal axis of the 16 colors, power iteration on the covariance matrix */
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 4; ++c) {
+			mean[c] += texels[i * 4 + c];
+		}
+	}
+	for (int c = 0; c < 4; ++c) {
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[4][4] = {};
+	float minColor[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maxColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; ++i) {
+		float diff[4];
+		for (int c = 0; c < 4; ++c) {
+			diff[c] = texels[i * 4 + c] - mean[c];
+			minColor[c] = std::min(minColor[c], static_cast<float>(texels[i * 4 + c]));
+			maxColor[c] = std::max(maxColor[c], static_cast<float>(texels[i * 4 + c]));
+		}
+		for (int row = 0; row < 4; ++row) {
+			for (int col = 0; col < 4; ++col) {
+				covariance[row][col] += diff[row] * diff[col];
+			}
+		}
+	}
+
+	float axis[4];
+	for (int c = 0; c < 4; ++c) {
+		axis[c] = maxColor[c] - minColor[c];
+	}
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int row = 0; row < 4; ++row) {
+			for (int col = 0; col < 4; ++col) {
+				next[row] += covariance[row][col] * axis[col];
+			}
+		}
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length < 1e-6f) {
+			break;
+		}
+		for (int c = 0; c < 4; ++c) {
+			axis[c] = next[c] / length;
+		}
+	}
+	float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+	if (axisLength > 1e-6f) {
+		for (int c = 0; c < 4; ++c) {
+			axis[c] /= axisLength;
+		}
+	}
+
+	/* endpoints at the outermost projections */
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+	for (int i = 0; i < 16; ++i) {
+		float projection = 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+		}
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	float endpoints[2][4];
+	for (int c = 0; c < 4; ++c) {
+		endpoints[0][c] = std::clamp(mean[c] + minProjection * axis[c], 0.0f, 255.0f);
+		endpoints[1][c] = std::clamp(mean[c] + maxProjection * axis[c], 0.0f, 255.0f);
+	}
+
+	int quantized[2][4];
+	int pBits[2];
+	quantizeEndpoint(endpoints[0], quantized[0], pBits[0]);
+	quantizeEndpoint(endpoints[1], quantized[1], pBits[1]);
+
+	/* the palette the decoder will see, the best entry per texel */
+	int palette[16][4];
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 4; ++c) {
+			int color0 = quantized[0][c] * 2 + pBits[0];
+			int color1 = quantized[1][c] * 2 + pBits[1];
+			palette[i][c] = ((64 - bc7Weights[i]) * color0 + bc7Weights[i] * color1 + 32) >> 6;
+		}
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; ++i) {
+		int bestError = 0;
+		for (int entry = 0; entry < 16; ++entry) {
+			int error = 0;
+			for (int c = 0; c < 4; ++c) {
+				int diff = palette[entry][c] - texels[i * 4 + c];
+				error += diff * diff;
+			}
+			if (entry == 0 || error < bestError) {
+				bestError = error;
+				indices[i] = entry;
+			}
+		}
+	}
+
+	/* the first index is stored with 3 bits, its highest bit must be 0, the weights are symmetric */
+	if (indices[0] & 8) {
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (int i = 0; i < 16; ++i) {
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	/* mode 6: mode bits, R0 R1 G0 G1 B0 B1 A0 A1, P0 P1, indices */
+	BlockWriter writer(block);
+	writer.write(1u << 6, 7);
+	for (int c = 0; c < 4; ++c) {
+		writer.write(quantized[0][c], 7);
+		writer.write(quantized[1][c], 7);
+	}
+	writer.write(pBits[0], 1);
+	writer.write(pBits[1], 1);
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; ++i) {
+		writer.write(indices[i], 4);
+	}
+}
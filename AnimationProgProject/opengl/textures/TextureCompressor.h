@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// BC7 encoder for the texture cache, mode 6 only: one RGBA line per 4x4 block, 8 bits per texel
+// BC7 is core since OpenGL 4.2 (GL_COMPRESSED_RGBA_BPTC_UNORM), no extension needed
+class TextureCompressor {
+	public:
+		static const size_t blockSize = 16;
+
+		// Size of a compressed image, partial blocks at the right and bottom border are padded
+		// @param width - Width in texels
+		// @param height - Height in texels
+		static size_t getCompressedSize(int width, int height);
+
+		// Compresses one row of blocks
+		// @param pixels - RGBA8 image, row by row
+		// @param width - Width of the image
+		// @param height - Height of the image
+		// @param blockRow - Row of 4x4 blocks to compress
+		// @param output - Receives the blocks of the row, getCompressedSize(width, 4) bytes
+		static void compressBlockRow(const unsigned char* pixels, int width, int height, int blockRow, unsigned char* output);
+
+		// @param texels - 16 RGBA8 texels, row by row
+		// @param block - Receives 16 bytes
+		static void compressBlock(const unsigned char* texels, unsigned char* block);
+};
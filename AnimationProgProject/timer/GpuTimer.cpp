@@ -0,0 +1,73 @@
+#include "GpuTimer.h"
+#include "../Logger/Logger.h"
+
+bool GpuTimer::init()
+{
+	glGenQueries(mNumQueries, mQueries.data());
+	for (const GLuint query : mQueries) {
+		if (query == 0) {
+			Logger::log(0, "%s: Error - Could not create GPU timer query.\n", __FUNCTION__);
+			return false;
+		}
+	}
+	mPending.fill(false);
+	return true;
+}
+
+void GpuTimer::start()
+{
+	if (mRunning) {
+		return;
+	}
+
+	// All queries still in flight, skip this measurement instead of waiting for the GPU
+	getResult();
+	if (mPending.at(mWritePos)) {
+		return;
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, mQueries.at(mWritePos));
+	mRunning = true;
+}
+
+void GpuTimer::stop()
+{
+	if (!mRunning) {
+		return;
+	}
+	mRunning = false;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	mPending.at(mWritePos) = true;
+	mWritePos = (mWritePos + 1) % mNumQueries;
+}
+
+float GpuTimer::getResult()
+{
+	// Queries finish in order, read all available ones and keep the newest value
+	while (mPending.at(mReadPos)) {
+		GLint available = 0;
+		glGetQueryObjectiv(mQueries.at(mReadPos), GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+
+		GLuint64 elapsedNanoSeconds = 0;
+		glGetQueryObjectui64v(mQueries.at(mReadPos), GL_QUERY_RESULT, &elapsedNanoSeconds);
+		mLastResult = static_cast<float>(elapsedNanoSeconds) / 1000000.0f;
+
+		mPending.at(mReadPos) = false;
+		mReadPos = (mReadPos + 1) % mNumQueries;
+	}
+	return mLastResult;
+}
+
+void GpuTimer::cleanup()
+{
+	glDeleteQueries(mNumQueries, mQueries.data());
+	mQueries.fill(0);
+	mPending.fill(false);
+	mWritePos = 0;
+	mReadPos = 0;
+	mRunning = false;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <array>
+#include <glad/glad.h>
+
+// Measures the GPU execution time of the commands between start() and stop() with GL_TIME_ELAPSED queries.
+// The queries are kept in a small ring and only read back once available, so the result lags a few
+// frames behind but never stalls the pipeline. GL_TIME_ELAPSED queries can't be nested.
+class GpuTimer {
+public:
+	bool init();
+	void start();
+	void stop();
+	// Returns the latest available GPU time in milliseconds
+	float getResult();
+	void cleanup();
+
+private:
+	static const unsigned int mNumQueries = 4;
+
+	std::array<GLuint, mNumQueries> mQueries{};
+	std::array<bool, mNumQueries> mPending{};
+	unsigned int mWritePos = 0;
+	unsigned int mReadPos = 0;
+	bool mRunning = false;
+	float mLastResult = 0.0f;
+};
@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+#include "../Logger/Logger.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& fileName) {
+
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		Logger::log(0, "%s: Error - Could not open file '%s'\n", __FUNCTION__, fileName.c_str());
+		return false;
+	}
+	mFileHandle = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		Logger::log(0, "%s: Error - File '%s' is empty\n", __FUNCTION__, fileName.c_str());
+		close();
+		return false;
+	}
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+
+	// PAGE_WRITECOPY and FILE_MAP_COPY give the copy-on-write view
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mapping) {
+		Logger::log(0, "%s: Error - Could not create mapping for '%s'\n", __FUNCTION__, fileName.c_str());
+		close();
+		return false;
+	}
+	mMappingHandle = mapping;
+
+	mData = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+#else
+	mFileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+	if (mFileDescriptor < 0) {
+		Logger::log(0, "%s: Error - Could not open file '%s'\n", __FUNCTION__, fileName.c_str());
+		return false;
+	}
+
+	struct stat fileStat {};
+	if (fstat(mFileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+		Logger::log(0, "%s: Error - File '%s' is empty\n", __FUNCTION__, fileName.c_str());
+		close();
+		return false;
+	}
+	mSize = static_cast<size_t>(fileStat.st_size);
+
+	void* data = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, mFileDescriptor, 0);
+	if (data == MAP_FAILED) {
+		data = nullptr;
+	}
+	else {
+		// The data is read front to back once, let the kernel read ahead
+		madvise(data, mSize, MADV_SEQUENTIAL);
+	}
+	mData = static_cast<unsigned char*>(data);
+#endif
+
+	if (!mData) {
+		Logger::log(0, "%s: Error - Could not map file '%s'\n", __FUNCTION__, fileName.c_str());
+		close();
+		return false;
+	}
+
+	Logger::log(1, "%s: mapped %i bytes of '%s'\n", __FUNCTION__, static_cast<int>(mSize), fileName.c_str());
+	return true;
+}
+
+unsigned char* MappedFile::getData() const {
+	return mData;
+}
+
+size_t MappedFile::getSize() const {
+	return mSize;
+}
+
+void MappedFile::close() {
+
+#ifdef _WIN32
+	if (mData) {
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle) {
+		CloseHandle(mMappingHandle);
+	}
+	if (mFileHandle) {
+		CloseHandle(mFileHandle);
+	}
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+#else
+	if (mData) {
+		munmap(mData, mSize);
+	}
+	if (mFileDescriptor >= 0) {
+		::close(mFileDescriptor);
+	}
+	mFileDescriptor = -1;
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+bool MappedFile::evictFromCache(const std::string& fileName) {
+
+#if defined(__linux__)
+	int fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	// only clean pages are dropped, files written just now need the sync
+	fdatasync(fileDescriptor);
+	bool result = posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	::close(fileDescriptor);
+	return result;
+#else
+	Logger::log(1, "%s: page cache eviction not supported, '%s' stays cached\n", __FUNCTION__, fileName.c_str());
+	return false;
+#endif
+}
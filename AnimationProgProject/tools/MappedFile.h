@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read only view of a whole file in memory, backed by the page cache instead of a heap copy.
+// The mapping is copy-on-write: writes are allowed but stay private to the process and only
+// the touched pages get copied.
+class MappedFile {
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		// Maps the file, an already open mapping is closed first
+		// @param fileName - Name of the file
+		bool open(const std::string& fileName);
+
+		unsigned char* getData() const;
+		size_t getSize() const;
+
+		// Removes the mapping and closes the file
+		void close();
+
+		// Drops the file from the OS page cache to measure cold loads, only supported on Linux
+		// @param fileName - Name of the file
+		static bool evictFromCache(const std::string& fileName);
+
+	private:
+		unsigned char* mData = nullptr;
+		size_t mSize = 0;
+
+#ifdef _WIN32
+		void* mFileHandle = nullptr;
+		void* mMappingHandle = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,69 @@
+#include "ProcessMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#include <mach/mach.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+size_t ProcessMemory::getPeakResidentBytes() {
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	// bytes on macOS, kilobytes on Linux
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+size_t ProcessMemory::getResidentBytes() {
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.WorkingSetSize;
+	}
+	return 0;
+#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info{};
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+		return 0;
+	}
+	return static_cast<size_t>(info.resident_size);
+#else
+	// second field of statm, in pages
+	FILE* statm = std::fopen("/proc/self/statm", "r");
+	if (!statm) {
+		return 0;
+	}
+	unsigned long totalPages = 0;
+	unsigned long residentPages = 0;
+	int fields = std::fscanf(statm, "%lu %lu", &totalPages, &residentPages);
+	std::fclose(statm);
+	if (fields != 2) {
+		return 0;
+	}
+	return static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
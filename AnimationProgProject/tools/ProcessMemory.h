@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// Resident memory of the running process, used to compare the memory cost of loaders
+class ProcessMemory {
+	public:
+		// Highest resident set size since the process started, 0 if unknown
+		static size_t getPeakResidentBytes();
+
+		// Current resident set size, 0 if unknown
+		static size_t getResidentBytes();
+};
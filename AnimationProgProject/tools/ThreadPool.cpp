@@ -0,0 +1,106 @@
+#include <algorithm>
+#include "ThreadPool.h"
+#include "../Logger/Logger.h"
+
+bool ThreadPool::init(unsigned int threadCount) {
+
+	if (!mWorkers.empty()) {
+		return true;
+	}
+
+	if (threadCount == 0) {
+		// hardware_concurrency() may return 0 if unknown
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mStopping = false;
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	Logger::log(1, "%s: started %u worker threads\n", __FUNCTION__, threadCount);
+	return true;
+}
+
+unsigned int ThreadPool::getThreadCount() {
+	return static_cast<unsigned int>(mWorkers.size());
+}
+
+void ThreadPool::workerLoop() {
+
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+			if (mJobs.empty()) {
+				return;
+			}
+			job = std::move(mJobs.front());
+			mJobs.pop();
+		}
+		job();
+	}
+}
+
+bool ThreadPool::runPendingJob() {
+
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mJobs.empty()) {
+			return false;
+		}
+		job = std::move(mJobs.front());
+		mJobs.pop();
+	}
+	job();
+	return true;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function) {
+
+	// a few ranges per thread, threads done early take the remaining ranges
+	size_t rangeCount = std::min(count, static_cast<size_t>(mWorkers.size() + 1) * 4);
+	if (rangeCount <= 1) {
+		for (size_t i = 0; i < count; ++i) {
+			function(i);
+		}
+		return;
+	}
+
+	std::vector<std::future<void>> ranges{};
+	ranges.reserve(rangeCount);
+	for (size_t range = 0; range < rangeCount; ++range) {
+		size_t first = count * range / rangeCount;
+		size_t last = count * (range + 1) / rangeCount;
+		ranges.push_back(submit([&function, first, last]() {
+			for (size_t i = first; i < last; ++i) {
+				function(i);
+			}
+		}));
+	}
+
+	for (auto& range : ranges) {
+		wait(range);
+	}
+}
+
+void ThreadPool::cleanup() {
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+
+	for (auto& worker : mWorkers) {
+		worker.join();
+	}
+	mWorkers.clear();
+}
+
+ThreadPool::~ThreadPool() {
+	cleanup();
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Worker threads for CPU work like model parsing and image decoding, the jobs must not call OpenGL
+class ThreadPool {
+	public:
+		// Starts the workers
+		// @param threadCount - Number of workers, 0 uses all hardware threads except the one of the renderer
+		bool init(unsigned int threadCount = 0);
+
+		// Queues a job, the result (or the exception) is delivered through the future
+		// Without workers the job runs right away on the calling thread
+		// @param job - Function without parameters
+		template <typename F>
+		auto submit(F&& job) -> std::future<decltype(job())> {
+			using ResultType = decltype(job());
+			auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(job));
+			std::future<ResultType> result = task->get_future();
+
+			if (mWorkers.empty()) {
+				(*task)();
+				return result;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mJobs.emplace([task]() { (*task)(); });
+			}
+			mCondition.notify_one();
+			return result;
+		}
+
+		// Waits for a job and runs queued jobs meanwhile, so jobs can wait for other jobs without a deadlock
+		// @param result - Future returned by submit
+		template <typename T>
+		T wait(std::future<T>& result) {
+			while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				if (!runPendingJob()) {
+					result.wait_for(std::chrono::microseconds(100));
+				}
+			}
+			return result.get();
+		}
+
+		// Calls the function for every index, spread over the workers and the calling thread
+		// @param count - Number of indices
+		// @param function - Called with the index, must be safe to run in parallel
+		void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+		unsigned int getThreadCount();
+
+		// Runs the jobs still queued and joins the workers
+		void cleanup();
+
+		~ThreadPool();
+
+	private:
+		void workerLoop();
+		bool runPendingJob();
+
+		std::vector<std::thread> mWorkers{};
+		std::queue<std::function<void()>> mJobs{};
+		std::mutex mMutex{};
+		std::condition_variable mCondition{};
+		bool mStopping = false;
+};
@@ -0,0 +1,116 @@
+// AssetCooker.cpp : Converts glTF models into the cooked runtime format (.apmodel)
+//
+// AssetCooker <model.gltf|model.glb> <texture.png> <output.apmodel>
+// AssetCooker --benchmark <model.gltf|model.glb> <texture.png> <model.apmodel> [runs]
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stb_image.h>
+#include "../../Logger/Logger.h"
+#include "../../timer/Timer.h"
+#include "../../models/gltf/GltfModel.h"
+#include "../MappedFile.h"
+
+using namespace std;
+
+// Same work as the renderer does before the GL uploads: texture decode and the full import
+static float timeImport(const string& modelFileName, const string& textureFileName) {
+
+	OGLRenderData renderData{};
+	Timer loadTimer{};
+	loadTimer.start();
+
+	int texWidth, texHeight, numOfChannels;
+	unsigned char* textureData = stbi_load(textureFileName.c_str(), &texWidth, &texHeight, &numOfChannels, 0);
+	unique_ptr<GltfModel> gltfModel = make_unique<GltfModel>();
+	bool result = textureData && gltfModel->importModel(renderData, modelFileName);
+	stbi_image_free(textureData);
+
+	float loadTime = loadTimer.stop();
+	return result ? loadTime : -1.0f;
+}
+
+// Mapping only, plus one read of every page, the uploads of the renderer read the whole file
+static float timeCooked(const string& cookedFileName) {
+
+	OGLRenderData renderData{};
+	Timer loadTimer{};
+	loadTimer.start();
+
+	unique_ptr<GltfModel> gltfModel = make_unique<GltfModel>();
+	bool result = gltfModel->mapCookedModel(renderData, cookedFileName);
+
+	MappedFile cookedFile{};
+	if (result && cookedFile.open(cookedFileName)) {
+		volatile unsigned char pageSum = 0;
+		for (size_t i = 0; i < cookedFile.getSize(); i += 4096) {
+			pageSum += cookedFile.getData()[i];
+		}
+	}
+
+	float loadTime = loadTimer.stop();
+	return result ? loadTime : -1.0f;
+}
+
+static int benchmark(const string& modelFileName, const string& textureFileName, const string& cookedFileName, int runs) {
+
+	// loader logs would end up in the timings
+	Logger::setLogLevel(0);
+
+	for (const bool cold : { true, false }) {
+		float importTime = 0.0f;
+		float cookedTime = 0.0f;
+
+		for (int i = 0; i < runs; ++i) {
+			if (cold) {
+				MappedFile::evictFromCache(modelFileName);
+				MappedFile::evictFromCache(textureFileName);
+				MappedFile::evictFromCache(cookedFileName);
+			}
+			float runImport = timeImport(modelFileName, textureFileName);
+			float runCooked = timeCooked(cookedFileName);
+			if (runImport < 0.0f || runCooked < 0.0f) {
+				Logger::log(0, "%s: Error - loading failed\n", __FUNCTION__);
+				return -1;
+			}
+			importTime += runImport;
+			cookedTime += runCooked;
+		}
+
+		importTime /= runs;
+		cookedTime /= runs;
+		Logger::log(0, "%s: %s start, %i runs: glTF import %.2f ms, cooked %.2f ms (%.1fx)\n", __FUNCTION__,
+			cold ? "cold" : "warm", runs, importTime, cookedTime, cookedTime > 0.0f ? importTime / cookedTime : 0.0f);
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	vector<string> args(argv + 1, argv + argc);
+
+	if (args.size() >= 4 && args.at(0) == "--benchmark") {
+		int runs = (args.size() > 4) ? stoi(args.at(4)) : 5;
+		return benchmark(args.at(1), args.at(2), args.at(3), runs > 0 ? runs : 1);
+	}
+
+	if (args.size() != 3) {
+		Logger::log(0, "usage: AssetCooker <model.gltf|model.glb> <texture.png> <output.apmodel>\n");
+		Logger::log(0, "       AssetCooker --benchmark <model.gltf|model.glb> <texture.png> <model.apmodel> [runs]\n");
+		return -1;
+	}
+
+	// default settings of the renderer, the cooked data is used as it is
+	OGLRenderData renderData{};
+	unique_ptr<GltfModel> gltfModel = make_unique<GltfModel>();
+	if (!gltfModel->importModel(renderData, args.at(0))) {
+		Logger::log(0, "%s: Error - could not import '%s'\n", __FUNCTION__, args.at(0).c_str());
+		return -1;
+	}
+
+	if (!gltfModel->saveCookedModel(renderData, args.at(2), args.at(1))) {
+		return -1;
+	}
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include <string>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -32,6 +33,26 @@ void UserInterface::init(OGLRenderData& renderData) {
     mUiDrawValues.resize(mNumUiDrawValues);
 }
 
+void UserInterface::createLoadingFrame(OGLRenderData& renderData) {
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGui::Begin("Control", nullptr, 0);
+
+    if (renderData.rdModelLoading) {
+        /* the worker thread gives no progress, the bar starts with the uploads */
+        ImGui::Text("Loading model...");
+        ImGui::ProgressBar(renderData.rdModelLoadProgress, ImVec2(-1.0f, 0.0f));
+    }
+    else {
+        ImGui::Text("Loading the model failed, see the log for details");
+    }
+
+    ImGui::End();
+}
+
 void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settings) {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -127,6 +148,104 @@ void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settin
         ImGui::SameLine();
         ImGui::Text("%s", std::to_string(renderData.rdTriangleCount + renderData.rdGltfTriangleCount).c_str());
 
+        ImGui::Text("Model Load:");
+        ImGui::SameLine();
+        ImGui::Text("%.2f ms, %s, peak RSS +%.1f KB", renderData.rdModelLoadTime,
+            renderData.rdModelCooked ? "cooked" : (renderData.rdModelMapped ? "mapped" : "copied"), renderData.rdModelLoadPeakRss / 1024.0f);
+
+        ImGui::Text("Clip Import:");
+        ImGui::SameLine();
+        ImGui::Text("%.2f ms", renderData.rdClipImportTime);
+
+        ImGui::Text("Source Data:");
+        ImGui::SameLine();
+        if (renderData.rdResidentMinimal) {
+            ImGui::Text("released after upload, RSS -%.1f KB", renderData.rdModelReleasedBytes / 1024.0f);
+        } else {
+            ImGui::Text("kept in memory");
+        }
+
+        ImGui::Text("Model Ready:");
+        ImGui::SameLine();
+        ImGui::Text("%.1f ms after init, uploads %d KB/frame", renderData.rdModelReadyTime, renderData.rdUploadBudgetKB);
+
+        ImGui::Text("Textures:");
+        for (const auto& texture : renderData.rdTextures) {
+            ImGui::Text("  %s: %dx%d, %d levels, %.1f KB%s, %.2f ms (%s)", texture.name.c_str(), texture.width,
+                texture.height, texture.levels, texture.gpuBytes / 1024.0f, texture.compressed ? " BC7" : "",
+                texture.loadTime, texture.fromCache ? "cache" : "decoded");
+        }
+
+        ImGui::Text("Vertex Data:");
+        ImGui::SameLine();
+        ImGui::Text("%.1f KB (unpacked %.1f KB)", renderData.rdGltfVertexBytes / 1024.0f,
+            renderData.rdGltfUnpackedVertexBytes / 1024.0f);
+
+        ImGui::Text("Vertex Cache:");
+        ImGui::SameLine();
+        ImGui::Text("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", renderData.rdMeshACMRBefore, renderData.rdMeshACMRAfter,
+            renderData.rdMeshATVRBefore, renderData.rdMeshATVRAfter);
+
+        ImGui::Text("LOD Instances:");
+        for (size_t i = 0; i < renderData.rdLodInstances.size(); ++i) {
+            ImGui::SameLine();
+            ImGui::Text("%d", renderData.rdLodInstances.at(i));
+        }
+
+        ImGui::Text("Startup Time:");
+        ImGui::SameLine();
+        ImGui::Text("%.1f ms, shaders %.1f ms (%i cached, %i compiled)", renderData.rdStartupTime,
+            renderData.rdShaderLoadTime, renderData.rdShaderCacheHits, renderData.rdShaderCacheMisses);
+
+        ImGui::Text("Baked Clips:");
+        ImGui::SameLine();
+        ImGui::Text("%.1f KB at %.0f fps", renderData.rdBakedAnimationBytes / 1024.0f, renderData.rdBakeFrameRate);
+
+        ImGui::Text("Debug Draw:");
+        ImGui::SameLine();
+        ImGui::Text("%u vertices, %u draws, %.1f KB/frame", renderData.rdDebugDrawVertexCount,
+            renderData.rdDebugDrawCalls, renderData.rdDebugDrawUploadBytes / 1024.0f);
+
+        ImGui::Checkbox("Draw Directly to Window", &renderData.rdDirectToBackbuffer);
+        ImGui::Text("Render Targets:");
+        ImGui::SameLine();
+        ImGui::Text("%u pooled, %u created", renderData.rdRenderTargets, renderData.rdRenderTargetAllocations);
+
+        ImGui::Text("Assets:");
+        ImGui::SameLine();
+        ImGui::Text("%u loaded, %.1f MB, %u loads, %u reused, %u evicted", renderData.rdAssetCount,
+            renderData.rdAssetBytes / (1024.0f * 1024.0f), renderData.rdAssetLoads, renderData.rdAssetHits,
+            renderData.rdAssetEvictions);
+        ImGui::SliderInt("Asset Budget (MB)", &renderData.rdAssetBudgetMB, 0, 2048);
+
+        ImGui::Text("Clips:");
+        ImGui::SameLine();
+        ImGui::Text("%u of %u resident%s, %.1f KB, %u loads, %u evicted", renderData.rdClipsResident,
+            renderData.rdClipCount, renderData.rdLazyClips ? "" : " (eager)", renderData.rdClipBytes / 1024.0f,
+            renderData.rdClipLoads, renderData.rdClipEvictions);
+        if (renderData.rdLazyClips) {
+            ImGui::SliderInt("Clip Budget (KB)", &renderData.rdClipBudgetKB, 0, 65536);
+        }
+
+        ImGui::Text("Streamed Clips:");
+        ImGui::SameLine();
+        ImGui::Text("%u, %.1f s windows, %u late windows", renderData.rdClipsStreamed, renderData.rdStreamWindowTime,
+            renderData.rdStreamMisses);
+
+        ImGui::Text("Constants:");
+        ImGui::SameLine();
+        ImGui::Text("%.1f KB/frame", renderData.rdConstantBytes / 1024.0f);
+
+        ImGui::Text("GL Calls:");
+        ImGui::SameLine();
+        ImGui::Text("%u draws, %u binds (%u skipped), %u uploads, %.1f KB", renderData.rdDrawCalls,
+            renderData.rdStateBinds, renderData.rdSkippedBinds, renderData.rdBufferUploads,
+            renderData.rdBufferUploadBytes / 1024.0f);
+
+        ImGui::Text("GPU Skeletons:");
+        ImGui::SameLine();
+        ImGui::Text("%u", renderData.rdSkeletonInstanceCount);
+
         std::string windowDims = std::to_string(renderData.rdWidth) + "x" + std::to_string(renderData.rdHeight);
         ImGui::Text("Window Dimensions:");
         ImGui::SameLine();
@@ -236,6 +355,11 @@ void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settin
             ImGui::EndTooltip();
         }
 
+        ImGui::Text("IK Chains:");
+        ImGui::SameLine();
+        ImGui::Text("%u in %u batches, %.2f us/chain", renderData.rdIKChainCount, renderData.rdIKBatchCount,
+            renderData.rdIKChainCount > 0 ? renderData.rdIKTime * 1000.0f / renderData.rdIKChainCount : 0.0f);
+
         ImGui::BeginGroup();
         ImGui::Text("Matrix Upload Time:");
         ImGui::SameLine();
@@ -307,6 +431,31 @@ void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settin
                 uiDrawOverlay.c_str(), 0.0f, FLT_MAX, ImVec2(0, 80));
             ImGui::EndTooltip();
         }
+
+        ImGui::Separator();
+        ImGui::Text("GPU Draw Time (LBS):");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuMatrixDrawTime).c_str());
+
+        ImGui::Text("GPU Draw Time (DQ):");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuDualQuatDrawTime).c_str());
+
+        ImGui::Text("GPU Crowd Draw Time:");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuCrowdDrawTime).c_str());
+
+        ImGui::Text("GPU Line Draw Time:");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuLineDrawTime).c_str());
+
+        ImGui::Text("GPU Blit Time:");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuBlitTime).c_str());
+
+        ImGui::Text("GPU UI Draw Time:");
+        ImGui::SameLine();
+        ImGui::Text("%s ms", std::to_string(renderData.rdGpuUIDrawTime).c_str());
     }
 
     if (ImGui::CollapsingHeader("Camera")) {
@@ -330,6 +479,22 @@ void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settin
     if (ImGui::CollapsingHeader("glTF Instances")) {
         ImGui::Text("Model Instances  : %d", renderData.rdNumberOfInstances);
 
+        ImGui::Checkbox("Use LODs", &renderData.rdEnableLod);
+        ImGui::SameLine();
+        ImGui::Text("(%d levels)", renderData.rdLodLevels);
+        ImGui::Text("LOD Bias         :");
+        ImGui::SameLine();
+        ImGui::SliderFloat("##LODBIAS", &renderData.rdLodBias, 0.1f, 4.0f, "%.2f", flags);
+
+        ImGui::Text("Crowd Instances  :");
+        ImGui::SameLine();
+        ImGui::SliderInt("##CROWD", &renderData.rdCrowdInstances, 0, 50000, "%d", flags);
+        ImGui::Text("Crowd LOD        :");
+        ImGui::SameLine();
+        ImGui::SliderInt("##CROWDLOD", &renderData.rdCrowdLod, 0, std::max(renderData.rdLodLevels - 1, 0), "%d", flags);
+
+        ImGui::Checkbox("Batch FABRIK Chains", &renderData.rdBatchIK);
+
         ImGui::Text("Selected Instance:");
         ImGui::SameLine();
         ImGui::PushButtonRepeat(true);
@@ -503,69 +668,108 @@ void UserInterface::createFrame(OGLRenderData& renderData, ModelSettings& settin
     }
 
     if (ImGui::CollapsingHeader("glTF Inverse Kinematic")) {
-        ImGui::Text("Inverse Kinematics");
-        ImGui::SameLine();
-        if (ImGui::RadioButton("Off",
-            settings.msIkMode == ikMode::off)) {
-            settings.msIkMode = ikMode::off;
+        std::vector<IKChainSettings>& ikChains = settings.msIkChains;
+        auto chainName = [&](int chainNum) {
+            return "Chain " + std::to_string(chainNum) + ": " +
+                settings.msSkelNodeNames.at(ikChains.at(chainNum).effectorNode);
+        };
+
+        ImGui::Text("IK Chain       :");
+        ImGui::SameLine();
+        if (ImGui::BeginCombo("##IKChainCombo", ikChains.empty() ? "(none)" :
+            chainName(settings.msIkSelectedChain).c_str())) {
+            for (int i = 0; i < ikChains.size(); ++i) {
+                const bool isSelected = (settings.msIkSelectedChain == i);
+                if (ImGui::Selectable(chainName(i).c_str(), isSelected)) {
+                    settings.msIkSelectedChain = i;
+                }
+
+                if (isSelected) {
+                    ImGui::SetItemDefaultFocus();
+                }
+            }
+            ImGui::EndCombo();
         }
-        ImGui::SameLine();
-        if (ImGui::RadioButton("CCD",
-            settings.msIkMode == ikMode::ccd)) {
-            settings.msIkMode = ikMode::ccd;
+
+        /* a new chain starts as a copy of the selected one, so only the nodes need to be changed */
+        if (ImGui::Button("Add Chain")) {
+            ikChains.push_back(ikChains.empty() ? IKChainSettings{} : ikChains.at(settings.msIkSelectedChain));
+            ikChains.back().mode = ikMode::off;
+            settings.msIkSelectedChain = static_cast<int>(ikChains.size()) - 1;
         }
         ImGui::SameLine();
-        if (ImGui::RadioButton("FABRIK",
-            settings.msIkMode == ikMode::fabrik)) {
-            settings.msIkMode = ikMode::fabrik;
+        if (ImGui::Button("Remove Chain") && !ikChains.empty()) {
+            ikChains.erase(ikChains.begin() + settings.msIkSelectedChain);
+            settings.msIkSelectedChain = std::max(settings.msIkSelectedChain - 1, 0);
         }
 
-        if (settings.msIkMode == ikMode::ccd ||
-            settings.msIkMode == ikMode::fabrik) {
-            ImGui::Text("IK Iterations  :");
-            ImGui::SameLine();
-            ImGui::SliderInt("##IKITER", &settings.msIkIterations, 0, 15, "%d", flags);
+        if (!ikChains.empty()) {
+            IKChainSettings& chain = ikChains.at(settings.msIkSelectedChain);
 
-            ImGui::Text("Target Position:");
+            ImGui::Text("Inverse Kinematics");
             ImGui::SameLine();
-            ImGui::SliderFloat3("##IKTargetPOS", glm::value_ptr(settings.msIkTargetPos), -10.0f,
-                10.0f, "%.3f", flags);
-            ImGui::Text("Effector Node  :");
+            if (ImGui::RadioButton("Off",
+                chain.mode == ikMode::off)) {
+                chain.mode = ikMode::off;
+            }
             ImGui::SameLine();
-            if (ImGui::BeginCombo("##EffectorNodeCombo",
-                settings.msSkelNodeNames.at(settings.msIkEffectorNode).c_str())) {
-                for (int i = 0; i < settings.msSkelNodeNames.size(); ++i) {
-                    if (settings.msSkelNodeNames.at(i).compare("(invalid)") != 0) {
-                        const bool isSelected = (settings.msIkEffectorNode == i);
-                        if (ImGui::Selectable(settings.msSkelNodeNames.at(i).c_str(), isSelected)) {
-                            settings.msIkEffectorNode = i;
-                        }
+            if (ImGui::RadioButton("CCD",
+                chain.mode == ikMode::ccd)) {
+                chain.mode = ikMode::ccd;
+            }
+            ImGui::SameLine();
+            if (ImGui::RadioButton("FABRIK",
+                chain.mode == ikMode::fabrik)) {
+                chain.mode = ikMode::fabrik;
+            }
 
-                        if (isSelected) {
-                            ImGui::SetItemDefaultFocus();
+            if (chain.mode == ikMode::ccd ||
+                chain.mode == ikMode::fabrik) {
+                ImGui::Text("IK Iterations  :");
+                ImGui::SameLine();
+                ImGui::SliderInt("##IKITER", &chain.iterations, 0, 15, "%d", flags);
+
+                ImGui::Text("Target Position:");
+                ImGui::SameLine();
+                ImGui::SliderFloat3("##IKTargetPOS", glm::value_ptr(chain.targetPos), -10.0f,
+                    10.0f, "%.3f", flags);
+                ImGui::Text("Effector Node  :");
+                ImGui::SameLine();
+                if (ImGui::BeginCombo("##EffectorNodeCombo",
+                    settings.msSkelNodeNames.at(chain.effectorNode).c_str())) {
+                    for (int i = 0; i < settings.msSkelNodeNames.size(); ++i) {
+                        if (settings.msSkelNodeNames.at(i).compare("(invalid)") != 0) {
+                            const bool isSelected = (chain.effectorNode == i);
+                            if (ImGui::Selectable(settings.msSkelNodeNames.at(i).c_str(), isSelected)) {
+                                chain.effectorNode = i;
+                            }
+
+                            if (isSelected) {
+                                ImGui::SetItemDefaultFocus();
+                            }
                         }
                     }
+                    ImGui::EndCombo();
                 }
-                ImGui::EndCombo();
-            }
 
-            ImGui::Text("IK Root Node   :");
-            ImGui::SameLine();
-            if (ImGui::BeginCombo("##RootNodeCombo",
-                settings.msSkelNodeNames.at(settings.msIkRootNode).c_str())) {
-                for (int i = 0; i < settings.msSkelNodeNames.size(); ++i) {
-                    if (settings.msSkelNodeNames.at(i).compare("(invalid)") != 0) {
-                        const bool isSelected = (settings.msIkRootNode == i);
-                        if (ImGui::Selectable(settings.msSkelNodeNames.at(i).c_str(), isSelected)) {
-                            settings.msIkRootNode = i;
-                        }
-
-                        if (isSelected) {
-                            ImGui::SetItemDefaultFocus();
+                ImGui::Text("IK Root Node   :");
+                ImGui::SameLine();
+                if (ImGui::BeginCombo("##RootNodeCombo",
+                    settings.msSkelNodeNames.at(chain.rootNode).c_str())) {
+                    for (int i = 0; i < settings.msSkelNodeNames.size(); ++i) {
+                        if (settings.msSkelNodeNames.at(i).compare("(invalid)") != 0) {
+                            const bool isSelected = (chain.rootNode == i);
+                            if (ImGui::Selectable(settings.msSkelNodeNames.at(i).c_str(), isSelected)) {
+                                chain.rootNode = i;
+                            }
+
+                            if (isSelected) {
+                                ImGui::SetItemDefaultFocus();
+                            }
                         }
                     }
+                    ImGui::EndCombo();
                 }
-                ImGui::EndCombo();
             }
         }
     }
@@ -2,13 +2,15 @@
 #pragma once
 #include <vector>
 
-#include "../opengl/mainRenderer/OGLRenderData.h"
+#include "../opengl/MainRenderer/OGLRenderData.h"
 #include "../models/ModelSettings.h"
 
 class UserInterface {
 public:
     void init(OGLRenderData& renderData);
     void createFrame(OGLRenderData& renderData, ModelSettings& settings);
+    /* progress only, used until the model and its instances exist */
+    void createLoadingFrame(OGLRenderData& renderData);
     void render();
     void cleanup();
 